@@ -1,3 +1,4 @@
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -13,6 +14,7 @@
 #include <pacer/datatypes/datatypes.hpp>
 #include <pacer/geometry/geometry.hpp>
 #include <pacer/gps-source/gps-source.hpp>
+#include <pacer/gps-source/log-follower.hpp>
 #include <pacer/laps-display/laps-display.hpp>
 #include <pacer/laps/laps.hpp>
 #include <pacer/map-tiles/implot-tiles.hpp>
@@ -50,6 +52,34 @@ static bool LoadLapsFromFiles(pacer::Laps *plaps,
   return true;
 }
 
+// Appends what the followed log gained since the last frame. If it was
+// rewritten rather than appended to, the points so far are stale: the other
+// files are reloaded and the log replayed from its start.
+static void PollFollowedLog(pacer::Laps *plaps, pacer::LogFollower *follower,
+                            const std::vector<std::string> &other_files,
+                            std::string &message) {
+  std::vector<GPSSample> fresh;
+  pacer::LogFollower::PollResult result;
+  try {
+    result = follower->Poll([&](GPSSample s) { fresh.push_back(s); });
+  } catch (const std::exception &e) {
+    message = e.what();
+    return;
+  }
+  if (result.restarted) {
+    plaps->ClearPoints();
+    pacer::LoadGPSFiles(other_files,
+                        [&](GPSSample sample) { plaps->AddPoint(sample); });
+  }
+  for (const GPSSample &sample : fresh) {
+    plaps->AddPoint(sample);
+  }
+  if (result.samples > 0 || result.restarted) {
+    message = "Following " + follower->Filename() + ": " +
+              std::to_string(plaps->PointCount()) + " points.";
+  }
+}
+
 // Sensible default docking layout setup
 // We split the screen into Left column (controls), Center (Map/Chart), and
 // Right column (Delta/Telemetry)
@@ -87,15 +117,23 @@ int main(int argc, char **argv) {
   pacer::TileStore tile_store;
   bool show_map_tiles = true;
 
+  // `--follow` tails the last data file (.dat, .pcl or .ubx) as it grows,
+  // e.g. a log synced from the kart, updating laps and deltas live.
+  std::unique_ptr<pacer::LogFollower> follower;
+  std::vector<std::string> followed_with;
+
   // Dev convenience: `timeline data.MP4 ... track.json --laps 3,5` loads
   // everything a manual session would click together: data files, the
   // reference track (any .json argument), and the delta lap selection.
   {
     std::vector<std::string> data_files;
     std::string track_file;
+    bool follow = false;
     for (int i = 1; i < argc; ++i) {
       std::string arg = argv[i];
-      if (arg == "--laps" && i + 1 < argc) {
+      if (arg == "--follow") {
+        follow = true;
+      } else if (arg == "--laps" && i + 1 < argc) {
         std::stringstream ss(argv[++i]);
         for (std::string id; std::getline(ss, id, ',');) {
           delta.selected_laps.insert(std::stoi(id));
@@ -108,7 +146,20 @@ int main(int argc, char **argv) {
     }
     if (!data_files.empty()) {
       load_filenames = data_files;
-      LoadLapsFromFiles(&laps, load_filenames, load_message);
+      if (follow) {
+        followed_with.assign(data_files.begin(), data_files.end() - 1);
+        try {
+          follower = std::make_unique<pacer::LogFollower>(data_files.back());
+          pacer::LoadGPSFiles(followed_with, [&](GPSSample sample) {
+            laps.AddPoint(sample);
+          });
+          PollFollowedLog(&laps, follower.get(), followed_with, load_message);
+        } catch (const std::exception &e) {
+          load_message = e.what();
+        }
+      } else {
+        LoadLapsFromFiles(&laps, load_filenames, load_message);
+      }
     }
     if (!track_file.empty()) {
       delta.reference_track_picker.path = track_file;
@@ -181,6 +232,7 @@ int main(int argc, char **argv) {
         ImGui::PopID();
       }
       if (ImGui::Button("Load files")) {
+        follower.reset();
         if (LoadLapsFromFiles(&laps, load_filenames, load_message)) {
           laps_display.bounds = {{1.0, 1.0}, {0.0, 0.0}};
           laps_display.selected_lap = -1;
@@ -356,12 +408,19 @@ int main(int argc, char **argv) {
       deltaWindow,     lapTelemetryWindow, comparisonMapWindow};
 
   runnerParams.callbacks.ShowGui = [&]() {
+    // Wait(0) only checks for a change notification; only new bytes are
+    // read and split, so a frame costs the same an hour into the session.
+    if (follower && follower->Wait(0)) {
+      PollFollowedLog(&laps, follower.get(), followed_with, load_message);
+    }
     laps.Update();
     // Drain finished downloads even when the Map window is not drawn, so
     // PendingCount() falls back to zero and the idle rate can drop again.
     tile_store.ApplyResults();
+    // A followed log only shows up in frames, so keep them coming at the
+    // logger's flush rate or better.
     HelloImGui::GetRunnerParams()->fpsIdling.fpsIdle =
-        (tile_store.PendingCount() > 0) ? 30.f : 3.f;
+        (tile_store.PendingCount() > 0) ? 30.f : (follower ? 10.f : 3.f);
   };
 
   HelloImGui::Run(runnerParams);
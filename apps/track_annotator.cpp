@@ -12,6 +12,7 @@
 #include <pacer/map-tiles/canvas-tiles.hpp>
 #include <pacer/map-tiles/tile-store.hpp>
 #include <pacer/reference-track/reference-track.hpp>
+#include <pacer/reference-track/track-catalog.hpp>
 #include <pacer/ui/track-picker.hpp>
 
 struct TrackPoint {
@@ -141,7 +142,7 @@ static bool SaveState(const TrackState &state, const std::string &filename) {
   }
 
   try {
-    track.SaveToFile(filename);
+    pacer::TrackCatalog::SaveTrack(track, filename);
     return true;
   } catch (const std::exception &) {
     return false;
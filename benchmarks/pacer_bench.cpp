@@ -0,0 +1,295 @@
+// Throughput of the timing hot paths shared by the desktop tools and the
+// firmware, in samples (or gates) per second.
+//
+//   pacer_bench [--log=<file.dat|.mp4> ... --track=<track.json>]
+//               [--benchmark_filter=<regex>] [other Google Benchmark flags]
+//
+// Every benchmark runs on synthetic sessions of each kLengths size. With
+// --log (repeatable; loaded like the timeline app does) and --track, the
+// same benchmarks also run on that recording, cut or repeated to the same
+// sizes.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <pacer/datatypes/datatypes.hpp>
+#include <pacer/geometry/gate-index.hpp>
+#include <pacer/geometry/geometry.hpp>
+#include <pacer/gps-source/gps-source.hpp>
+#include <pacer/laps/laps.hpp>
+#include <pacer/live-timing/live-timing.hpp>
+#include <pacer/reference-track/reference-track.hpp>
+
+#include "sessions.hpp"
+
+namespace {
+
+using pacer::bench::Session;
+
+void CountSamples(benchmark::State &state, size_t per_iteration,
+                  const char *unit = "samples/s") {
+  state.counters[unit] = benchmark::Counter(
+      static_cast<double>(per_iteration * state.iterations()),
+      benchmark::Counter::kIsRate);
+}
+
+void BM_CoordinateSystemLocal(benchmark::State &state, const Session *session) {
+  const pacer::CoordinateSystem &cs = session->track.cs;
+  for (auto _ : state) {
+    for (const pacer::GPSSample &s : session->samples) {
+      benchmark::DoNotOptimize(cs.Local(s));
+    }
+  }
+  CountSamples(state, session->samples.size());
+}
+
+void BM_CoordinateSystemDistance(benchmark::State &state,
+                                 const Session *session) {
+  const pacer::CoordinateSystem &cs = session->track.cs;
+  const auto &samples = session->samples;
+  for (auto _ : state) {
+    double total = 0;
+    for (size_t i = 1; i < samples.size(); ++i) {
+      total += cs.Distance(samples[i - 1], samples[i]);
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  CountSamples(state, session->samples.size());
+}
+
+void BM_CoordinateSystemLocalBatch(benchmark::State &state,
+                                   const Session *session,
+                                   pacer::Projection projection) {
+  const pacer::CoordinateSystem &cs = session->track.cs;
+  std::vector<pacer::Vec3f> local(session->samples.size());
+  for (auto _ : state) {
+    cs.LocalBatch(session->samples, local, projection);
+    benchmark::DoNotOptimize(local.data());
+  }
+  CountSamples(state, session->samples.size());
+}
+
+void BM_CoordinateSystemLocalBatchExact(benchmark::State &state,
+                                        const Session *session) {
+  BM_CoordinateSystemLocalBatch(state, session, pacer::Projection::kExact);
+}
+
+void BM_CoordinateSystemLocalBatchTangent(benchmark::State &state,
+                                          const Session *session) {
+  BM_CoordinateSystemLocalBatch(state, session,
+                                pacer::Projection::kTangentPlane);
+}
+
+void BM_CoordinateSystemCumulativeDistances(benchmark::State &state,
+                                            const Session *session) {
+  const pacer::CoordinateSystem &cs = session->track.cs;
+  std::vector<double> distances(session->samples.size());
+  for (auto _ : state) {
+    cs.CumulativeDistances(session->samples, distances);
+    benchmark::DoNotOptimize(distances.data());
+  }
+  CountSamples(state, session->samples.size());
+}
+
+// The start line against every fix-to-fix segment, in lon/lat as Laps
+// splits them.
+void BM_SegmentIntersects(benchmark::State &state, const Session *session) {
+  pacer::Segment line =
+      session->track.ToGlobal(session->track.TimingLine(0));
+  std::vector<pacer::Point> points;
+  for (const pacer::GPSSample &s : session->samples) {
+    points.push_back(pacer::Point{s.lon, s.lat});
+  }
+  for (auto _ : state) {
+    size_t crossings = 0;
+    for (size_t i = 1; i < points.size(); ++i) {
+      double ratio = 0;
+      crossings += line.Intersects(points[i - 1], points[i], &ratio);
+    }
+    benchmark::DoNotOptimize(crossings);
+  }
+  CountSamples(state, session->samples.size());
+}
+
+pacer::Laps MakeLaps(const Session &session) {
+  pacer::Laps laps;
+  laps.SetCoordinateSystem(session.track.cs);
+  laps.sectors = session.track.BuildSectors(session.track.cs);
+  for (const pacer::GPSSample &s : session.samples) {
+    laps.AddPoint(s);
+  }
+  return laps;
+}
+
+// Full re-split of a loaded session, as after opening files or moving a
+// timing line.
+void BM_LapsUpdate(benchmark::State &state, const Session *session) {
+  pacer::Laps laps = MakeLaps(*session);
+  for (auto _ : state) {
+    state.PauseTiming();
+    laps.ClearPoints();
+    for (const pacer::GPSSample &s : session->samples) {
+      laps.AddPoint(s);
+    }
+    state.ResumeTiming();
+    laps.Update();
+  }
+  CountSamples(state, session->samples.size());
+}
+
+// Sample-by-sample ingestion, as when following a live log.
+void BM_LapsAddPointUpdate(benchmark::State &state, const Session *session) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    pacer::Laps laps;
+    laps.SetCoordinateSystem(session->track.cs);
+    laps.sectors = session->track.BuildSectors(session->track.cs);
+    state.ResumeTiming();
+    for (const pacer::GPSSample &s : session->samples) {
+      laps.AddPoint(s);
+      laps.Update();
+    }
+  }
+  CountSamples(state, session->samples.size());
+}
+
+void BM_ReferenceTrackResample(benchmark::State &state,
+                               const Session *session) {
+  pacer::Laps laps = MakeLaps(*session);
+  laps.Update();
+  std::vector<pacer::Lap> lap_list;
+  size_t samples = 0;
+  for (size_t i = 0; i < laps.LapsCount(); ++i) {
+    lap_list.push_back(laps.GetLap(i));
+    samples += lap_list.back().Count();
+  }
+  if (lap_list.empty()) {
+    state.SkipWithError("no laps: is this the log's track?");
+    return;
+  }
+  pacer::GateIndex gates(session->track.DensifiedGates());
+
+  for (auto _ : state) {
+    for (const pacer::Lap &lap : lap_list) {
+      benchmark::DoNotOptimize(session->track.Resample(lap, gates));
+    }
+  }
+  CountSamples(state, samples);
+}
+
+void BM_DensifiedGates(benchmark::State &state, const Session *session) {
+  size_t gates = 0;
+  for (auto _ : state) {
+    std::vector<pacer::Segment> dense = session->track.DensifiedGates();
+    gates = dense.size();
+    benchmark::DoNotOptimize(dense);
+  }
+  CountSamples(state, gates, "gates/s");
+}
+
+void BM_LiveTimingOnSample(benchmark::State &state, const Session *session) {
+  pacer::LiveTiming timing;
+  for (auto _ : state) {
+    state.PauseTiming();
+    timing.SetReferenceTrack(session->track);
+    state.ResumeTiming();
+    for (const pacer::GPSSample &s : session->samples) {
+      timing.OnSample(s);
+    }
+    benchmark::DoNotOptimize(timing.Snapshot());
+  }
+  CountSamples(state, session->samples.size());
+}
+
+void Register(const char *name, void (*fn)(benchmark::State &, const Session *),
+              const Session &session) {
+  benchmark::RegisterBenchmark((std::string(name) + "/" + session.name).c_str(),
+                               fn, &session)
+      ->Unit(benchmark::kMicrosecond);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  // Our flags first; everything else goes to Google Benchmark.
+  std::vector<std::string> logs;
+  std::string track_file;
+  std::vector<char *> args{argv[0]};
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg.starts_with("--log=")) {
+      logs.emplace_back(arg.substr(6));
+    } else if (arg.starts_with("--track=")) {
+      track_file = arg.substr(8);
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+
+  // Registered benchmarks keep pointers into this; it's filled up front.
+  std::vector<Session> sessions;
+  for (const pacer::bench::Length &length : pacer::bench::kLengths) {
+    sessions.push_back(pacer::bench::SyntheticSession(length));
+  }
+  if (!logs.empty()) {
+    if (track_file.empty()) {
+      fprintf(stderr, "--log needs --track=<reference track .json>\n");
+      return 1;
+    }
+    try {
+      pacer::ReferenceTrack track = pacer::ReferenceTrack::FromFile(track_file);
+      std::vector<pacer::GPSSample> log;
+      std::vector<std::string> errors;
+      pacer::LoadGPSFiles(
+          logs, [&](pacer::GPSSample s) { log.push_back(s); }, &errors);
+      for (const std::string &error : errors) {
+        fprintf(stderr, "%s\n", error.c_str());
+      }
+      for (const pacer::bench::Length &length : pacer::bench::kLengths) {
+        sessions.push_back(
+            pacer::bench::RecordedSession("recorded", log, track, length));
+      }
+    } catch (const std::exception &e) {
+      fprintf(stderr, "%s\n", e.what());
+      return 1;
+    }
+  }
+
+  for (const Session &session : sessions) {
+    Register("CoordinateSystem::Local", BM_CoordinateSystemLocal, session);
+    Register("CoordinateSystem::Distance", BM_CoordinateSystemDistance,
+             session);
+    Register("CoordinateSystem::LocalBatch", BM_CoordinateSystemLocalBatchExact,
+             session);
+    Register("CoordinateSystem::LocalBatch(tangent)",
+             BM_CoordinateSystemLocalBatchTangent, session);
+    Register("CoordinateSystem::CumulativeDistances",
+             BM_CoordinateSystemCumulativeDistances, session);
+    Register("Segment::Intersects", BM_SegmentIntersects, session);
+    Register("Laps::Update", BM_LapsUpdate, session);
+    Register("Laps::AddPoint+Update", BM_LapsAddPointUpdate, session);
+    Register("ReferenceTrack::Resample", BM_ReferenceTrackResample, session);
+    Register("LiveTiming::OnSample", BM_LiveTimingOnSample, session);
+  }
+  // Depends on the track only: once per distinct track.
+  benchmark::RegisterBenchmark("ReferenceTrack::DensifiedGates/synthetic",
+                               BM_DensifiedGates, &sessions.front());
+  if (!logs.empty()) {
+    benchmark::RegisterBenchmark("ReferenceTrack::DensifiedGates/recorded",
+                                 BM_DensifiedGates, &sessions.back());
+  }
+
+  int args_count = static_cast<int>(args.size());
+  benchmark::Initialize(&args_count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(args_count, args.data())) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
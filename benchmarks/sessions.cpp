@@ -0,0 +1,133 @@
+#include "sessions.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <random>
+
+namespace {
+
+constexpr double kSampleMs = 40; // 25 Hz
+
+// Centerline of the synthetic circuit: a wobbly closed curve in polar form,
+// tabulated by arc length so it can be walked at a given speed.
+class Centerline {
+public:
+  Centerline() {
+    constexpr size_t kPoints = 4096;
+    for (size_t i = 0; i <= kPoints; ++i) {
+      double a = 2 * std::numbers::pi * static_cast<double>(i) / kPoints;
+      double r = 180 * (1 + 0.25 * std::sin(3 * a) + 0.1 * std::cos(5 * a));
+      pacer::Point p{r * std::cos(a), r * std::sin(a)};
+      double step = points_.empty() ? 0 : std::sqrt((p - points_.back()).Norm());
+      arc_.push_back(arc_.empty() ? 0 : arc_.back() + step);
+      points_.push_back(p);
+    }
+  }
+
+  double Length() const { return arc_.back(); }
+
+  /// Point at arc length `s` (wrapped) and the unit normal there.
+  void At(double s, pacer::Point *p, pacer::Point *normal) const {
+    s = std::fmod(s, Length());
+    if (s < 0) {
+      s += Length();
+    }
+    size_t i = std::upper_bound(arc_.begin(), arc_.end(), s) - arc_.begin();
+    i = std::clamp<size_t>(i, 1, points_.size() - 1);
+    double t = (s - arc_[i - 1]) / (arc_[i] - arc_[i - 1]);
+    pacer::Point d = points_[i] - points_[i - 1];
+    *p = points_[i - 1] + d * t;
+    *normal = d.Rot() / std::sqrt(d.Norm());
+  }
+
+private:
+  std::vector<pacer::Point> points_;
+  std::vector<double> arc_;
+};
+
+const Centerline &SyntheticCenterline() {
+  static const Centerline centerline;
+  return centerline;
+}
+
+pacer::CoordinateSystem SyntheticFrame() {
+  return pacer::CoordinateSystem(pacer::GPSSample{.lat = 52.04, .lon = -0.78});
+}
+
+} // namespace
+
+pacer::ReferenceTrack pacer::bench::SyntheticTrack() {
+  const Centerline &line = SyntheticCenterline();
+  ReferenceTrack track;
+  track.cs = SyntheticFrame();
+  for (double s = 0; s + 5 < line.Length(); s += 10) {
+    Point p, n;
+    line.At(s, &p, &n);
+    track.segments.push_back(Segment{p - n * 5.0, p + n * 5.0});
+  }
+  int count = static_cast<int>(track.segments.size());
+  track.sector_indices = {count / 3, 2 * count / 3};
+  return track;
+}
+
+pacer::bench::Session pacer::bench::SyntheticSession(const Length &length) {
+  const Centerline &line = SyntheticCenterline();
+  CoordinateSystem cs = SyntheticFrame();
+  std::mt19937 rng(239);
+  std::normal_distribution<double> noise(0, 0.3);
+
+  Session session{.name = std::string("synthetic/") + length.name,
+                  .track = SyntheticTrack(),
+                  .samples = {}};
+  size_t count = static_cast<size_t>(length.duration_s * 1000 / kSampleMs);
+  session.samples.reserve(count);
+
+  // Start a little before the line so the first lap is timed.
+  double s = -30;
+  for (size_t i = 0; i < count; ++i) {
+    double phase = 2 * std::numbers::pi * s / line.Length();
+    double speed = 20 + 5 * std::sin(7 * phase);
+    double offset = 1.5 * std::sin(s / 23) + noise(rng);
+
+    Point p, n;
+    line.At(s, &p, &n);
+    Point q = p + n * offset;
+    GPSSample sample = cs.Global(Vec3f{q.x, q.y, 0});
+    sample.full_speed = sample.ground_speed = speed;
+    sample.timestamp_ms =
+        1'000'000 + static_cast<int64_t>(static_cast<double>(i) * kSampleMs);
+    session.samples.push_back(sample);
+
+    s += speed * kSampleMs / 1000;
+  }
+  return session;
+}
+
+pacer::bench::Session
+pacer::bench::RecordedSession(const std::string &name,
+                              const std::vector<GPSSample> &log,
+                              const ReferenceTrack &track,
+                              const Length &length) {
+  Session session{
+      .name = name + "/" + length.name, .track = track, .samples = {}};
+  if (log.empty()) {
+    return session;
+  }
+
+  int64_t start = log.front().timestamp_ms;
+  int64_t span = log.back().timestamp_ms - start +
+                 static_cast<int64_t>(kSampleMs);
+  int64_t duration = static_cast<int64_t>(length.duration_s * 1000);
+  for (int64_t shift = 0; shift < duration; shift += span) {
+    for (GPSSample sample : log) {
+      sample.timestamp_ms += shift;
+      if (sample.timestamp_ms - start >= duration) {
+        break;
+      }
+      session.samples.push_back(sample);
+    }
+  }
+  return session;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <pacer/datatypes/datatypes.hpp>
+#include <pacer/reference-track/reference-track.hpp>
+
+namespace pacer::bench {
+
+// A GPS session to benchmark on, with the reference track it was driven on.
+struct Session {
+  std::string name; ///< e.g. "synthetic/15min"
+  ReferenceTrack track;
+  std::vector<GPSSample> samples;
+};
+
+// Session lengths benchmarked, at the 25 Hz the kart's receiver runs at:
+// a single lap, a typical sprint session and an endurance race.
+struct Length {
+  const char *name;
+  double duration_s;
+};
+
+inline constexpr Length kLengths[] = {
+    {"1lap", 75},
+    {"15min", 15 * 60},
+    {"3h", 3 * 60 * 60},
+};
+
+/// A ~1.3 km kart-like circuit (a lap takes about 70 s at the speeds
+/// SyntheticSession() drives it), gates every 10 m.
+ReferenceTrack SyntheticTrack();
+
+/// `duration_s` of 25 Hz laps around SyntheticTrack(), with varying speed,
+/// a wandering line and fix noise. Deterministic.
+Session SyntheticSession(const Length &length);
+
+/// A recorded log cut (or, when it's shorter, repeated back to back with
+/// its clock shifted) to `length`.
+Session RecordedSession(const std::string &name,
+                        const std::vector<GPSSample> &log,
+                        const ReferenceTrack &track, const Length &length);
+
+} // namespace pacer::bench
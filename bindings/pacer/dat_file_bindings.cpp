@@ -0,0 +1,89 @@
+// Hand-written bindings for pacer::DatFile: litgen can't express strided
+// views into a memory mapping, and copying a multi-hour log into Python
+// lists is exactly what DatFile exists to avoid. Columns are numpy arrays
+// aliasing the mapped records (read-only, kept alive by the DatFile).
+
+#include <cstddef>
+#include <cstdint>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/string.h>
+
+#include <pacer/gps-source/dat-file.hpp>
+
+namespace nb = nanobind;
+
+namespace {
+
+template <class T>
+using Column = nb::ndarray<nb::numpy, const T, nb::ndim<1>>;
+
+// Raw NAV-PVT field at byte `offset` of every record. Strides are in
+// elements; both record strides (92, 100) are multiples of 4, so any 4-byte
+// field lines up.
+template <class T>
+Column<T> PvtColumn(nb::handle owner, const pacer::DatFile &file,
+                    size_t offset) {
+  static_assert(sizeof(T) == 4);
+  const std::byte *base =
+      file.empty() ? nullptr
+                   : reinterpret_cast<const std::byte *>(&file.Pvt(0)) + offset;
+  size_t shape[1] = {file.size()};
+  int64_t strides[1] = {static_cast<int64_t>(file.Stride() / sizeof(T))};
+  return Column<T>(base, 1, shape, owner, strides);
+}
+
+} // namespace
+
+void py_init_module_pacer_dat_file(nb::module_ &m) {
+  nb::class_<pacer::DatFile>(
+      m, "DatFile",
+      "Memory-mapped .dat session log. Columns are zero-copy numpy views "
+      "of the raw UBX-NAV-PVT fields (integer units as logged).")
+      .def(nb::init<const char *, pacer::DatVersion>(), nb::arg("filename"),
+           nb::arg("version") = pacer::DatVersion::WITH_TIMESTAMP)
+      .def("__len__", &pacer::DatFile::size)
+      .def("sample", &pacer::DatFile::Sample, nb::arg("i"))
+      .def("timestamp", &pacer::DatFile::Timestamp, nb::arg("i"))
+      .def_prop_ro(
+          "lat_e7",
+          [](nb::handle self) {
+            auto &f = nb::cast<const pacer::DatFile &>(self);
+            return PvtColumn<int32_t>(self, f,
+                                      offsetof(uGnssDecUbxNavPvt_t, lat));
+          },
+          "Latitude, degrees * 1e7.")
+      .def_prop_ro(
+          "lon_e7",
+          [](nb::handle self) {
+            auto &f = nb::cast<const pacer::DatFile &>(self);
+            return PvtColumn<int32_t>(self, f,
+                                      offsetof(uGnssDecUbxNavPvt_t, lon));
+          },
+          "Longitude, degrees * 1e7.")
+      .def_prop_ro(
+          "height_mm",
+          [](nb::handle self) {
+            auto &f = nb::cast<const pacer::DatFile &>(self);
+            return PvtColumn<int32_t>(self, f,
+                                      offsetof(uGnssDecUbxNavPvt_t, height));
+          },
+          "Height above ellipsoid, mm.")
+      .def_prop_ro(
+          "g_speed_mm_s",
+          [](nb::handle self) {
+            auto &f = nb::cast<const pacer::DatFile &>(self);
+            return PvtColumn<int32_t>(self, f,
+                                      offsetof(uGnssDecUbxNavPvt_t, gSpeed));
+          },
+          "2D ground speed, mm/s.")
+      .def_prop_ro(
+          "itow_ms",
+          [](nb::handle self) {
+            auto &f = nb::cast<const pacer::DatFile &>(self);
+            return PvtColumn<uint32_t>(self, f,
+                                       offsetof(uGnssDecUbxNavPvt_t, iTOW));
+          },
+          "GPS time of week, ms.");
+}
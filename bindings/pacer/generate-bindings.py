@@ -40,6 +40,13 @@ def my_litgen_options() -> litgen.LitgenOptions:
     # We want to exclude `inline void priv_SetOptions(bool v) {}` from the bindings
     # priv_ is a prefix for private functions that we don't want to expose
     options.fn_exclude_by_name__regex = "^priv_"
+    # CoordinateSystem's batch kernels take std::span, which litgen can't
+    # bind; they stay C++-only.
+    options.fn_exclude_by_name__regex += "|Batch$|^CumulativeDistances$"
+    # ReferenceTrack's precomputed gates are a load-time cache for .ptrk
+    # files; Python reads the gates through densified_gates() instead.
+    options.fn_exclude_by_name__regex += "|^PrecomputeGates$|^Precomputed$"
+    options.class_exclude_by_name__regex = "^PrecomputedGates$"
 
     # Inside `inline void SetOptions(bool v, bool priv_param = false) {}`,
     # we don't want to expose the private parameter priv_param
@@ -72,7 +79,13 @@ def my_litgen_options() -> litgen.LitgenOptions:
     # methods) with no meaningful Python-side use; excluding it as a member type
     # keeps litgen from generating a __init__ default for it, which would need a
     # nanobind type caster that doesn't exist and throws std::bad_cast on import.
-    options.member_exclude_by_type__regex = "^TrackFilePicker$"
+    options.member_exclude_by_type__regex = "^TrackFilePicker$|^PrecomputedGates$"
+
+    # Point, Segment and Vec3f are aliases of the double instantiations; the
+    # float ones are for the firmware only.
+    options.class_template_options.add_specialization(
+        r"^Basic(Point|Segment|Vec3)$", ["double"]
+    )
 
     options.class_template_options.add_ignore("VectorOperators")
     options.class_template_options.add_ignore("PointwiseOperators")
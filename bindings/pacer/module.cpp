@@ -6,6 +6,7 @@
 namespace nb = nanobind;
 
 void py_init_module_pacer(nb::module_ &m);
+void py_init_module_pacer_dat_file(nb::module_ &m);
 
 // This builds the native python module `_pacer`
 // it will be wrapped in a standard python module `pacer`
@@ -17,4 +18,5 @@ NB_MODULE(_pacer, m) {
 #endif
 
   py_init_module_pacer(m);
+  py_init_module_pacer_dat_file(m);
 }
\ No newline at end of file
@@ -164,7 +164,9 @@ void py_init_module_pacer(nb::module_ &m) {
                "/ Maps local-coordinate point back to gps sample.\n/ N.B. "
                "Speed is not preserved.")
           .def("distance", &pacer::CoordinateSystem::Distance, nb::arg("from_"),
-               nb::arg("to"));
+               nb::arg("to"))
+          .def("origin", &pacer::CoordinateSystem::Origin,
+               "/ The sample this frame was built around.");
 
   m.def(
       "interpolate",
@@ -300,8 +302,10 @@ void py_init_module_pacer(nb::module_ &m) {
                   "/ How far TimingLine() extends each gate past both "
                   "annotated edges, in\n/ meters, so the gate still catches a "
                   "driven lap that strays slightly\n/ outside the annotated "
-                  "track boundary. Runtime-only (not saved to the\n/ track "
-                  "file); tune it in the timeline's reference track loader.")
+                  "track boundary. Not in the JSON track file; a\n/ .ptrk "
+                  "file keeps the value its gates were built with and loads "
+                  "it back.\n/ Tune it in the timeline's reference track "
+                  "loader.")
           .def("count", &pacer::ReferenceTrack::Count)
           .def("timing_lines_count", &pacer::ReferenceTrack::TimingLinesCount)
           .def("timing_line", &pacer::ReferenceTrack::TimingLine,
@@ -315,6 +319,10 @@ void py_init_module_pacer(nb::module_ &m) {
               "in this track's\n/ local frame. Gate 0 is the start/finish "
               "line. Both Resample() and the\n/ live-timing engine consume "
               "laps through this same gate sequence, so\n/ their deltas agree.")
+          .def("densified_global_gates",
+               &pacer::ReferenceTrack::DensifiedGlobalGates,
+               "/ DensifiedGates() converted with ToGlobal(), the frame the "
+               "live-timing\n/ engine reads them in.")
           .def("to_global", &pacer::ReferenceTrack::ToGlobal, nb::arg("local"),
                "/ Converts a local-frame segment to raw lon/lat Points, i.e. "
                "the frame\n/ pacer::Split() expects when intersecting against "
@@ -338,11 +346,23 @@ void py_init_module_pacer(nb::module_ &m) {
               nb::arg("filename"),
               "/ Loads a reference track from the JSON schema written by\n/ "
               "track_annotator ({\"segments\": [[[lat,lon],[lat,lon]], "
-              "...]}).\n/ Throws std::runtime_error on failure.")
+              "...]}), or, for a\n/ *.ptrk filename, from the binary format "
+              "(see SaveToFile()), with\n/ `precomputed` and "
+              "gate_extension_m filled in. Throws\n/ std::runtime_error on "
+              "failure.")
           .def("save_to_file", &pacer::ReferenceTrack::SaveToFile,
                nb::arg("filename"),
-               "/ Writes this track using the same JSON schema. Throws\n/ "
-               "std::runtime_error on failure.")
+               "/ Writes this track using the same JSON schema, or for a "
+               "*.ptrk filename\n/ the binary one: a fixed header (magic, "
+               "version, counts, frame origin,\n/ gate_extension_m), then "
+               "segments, the densified local and global gates,\n/ and "
+               "sector_indices as raw arrays in native endianness. Loading it "
+               "is a\n/ handful of reads straight into the vectors; the JSON "
+               "stays the\n/ editable source. Throws std::runtime_error on "
+               "failure.")
+          .def_static("binary_path", &pacer::ReferenceTrack::BinaryPath,
+                      nb::arg("filename"),
+                      "/ `filename` with its extension replaced by .ptrk.")
           .def("build_sectors", &pacer::ReferenceTrack::BuildSectors,
                nb::arg("target_cs"),
                "/ Builds a pacer::Sectors using segments[0] as the "
@@ -397,19 +417,34 @@ void py_init_module_pacer(nb::module_ &m) {
           .def("get_total_duration", &pacer::GPMFSource::GetTotalDuration,
                "Gets total MP4 duration.");
 
+  auto pyClassChainedGPSSource =
+      nb::class_<pacer::ChainedGPSSource, pacer::RawGPSSource>(
+          m, "ChainedGPSSource",
+          " Several sources played back to back as one timeline, e.g. the "
+          "chapters\n of a GoPro recording. Chapter start offsets are prefix "
+          "sums of the\n durations taken once at construction (the sources "
+          "don't grow), so\n Seek() and CurrentTimeSpan() find their chapter "
+          "by binary search rather\n than walking a chain.")
+          .def(nb::init<std::vector<pacer::RawGPSSource *>>(),
+               nb::arg("sources"),
+               "Sources are borrowed and must outlive the chain.")
+          .def("get_total_duration",
+               &pacer::ChainedGPSSource::GetTotalDuration)
+          .def("is_end", &pacer::ChainedGPSSource::IsEnd)
+          .def("seek", &pacer::ChainedGPSSource::Seek, nb::arg("target"))
+          .def("next", &pacer::ChainedGPSSource::Next)
+          .def("current_time_span", &pacer::ChainedGPSSource::CurrentTimeSpan,
+               "Returns current samples' time span.")
+          .def("source_count", &pacer::ChainedGPSSource::SourceCount)
+          .def("current_source", &pacer::ChainedGPSSource::CurrentSource,
+               "Index of the chapter being played.");
+
   auto pyClassSequentialGPSSource =
-      nb::class_<pacer::SequentialGPSSource, pacer::RawGPSSource>(
-          m, "SequentialGPSSource", "")
+      nb::class_<pacer::SequentialGPSSource, pacer::ChainedGPSSource>(
+          m, "SequentialGPSSource",
+          " Two sources back to back; a ChainedGPSSource of both.")
           .def(nb::init<pacer::RawGPSSource *, pacer::RawGPSSource *>(),
-               nb::arg("left"), nb::arg("right"))
-          .def("get_total_duration",
-               &pacer::SequentialGPSSource::GetTotalDuration)
-          .def("is_end", &pacer::SequentialGPSSource::IsEnd)
-          .def("seek", &pacer::SequentialGPSSource::Seek, nb::arg("target"))
-          .def("next", &pacer::SequentialGPSSource::Next)
-          .def("current_time_span",
-               &pacer::SequentialGPSSource::CurrentTimeSpan,
-               "Returns current samples' time span.");
+               nb::arg("left"), nb::arg("right"));
 
   auto pyEnumDatVersion =
       nb::enum_<pacer::DatVersion>(m, "DatVersion", nb::is_arithmetic(), "")
@@ -418,12 +453,17 @@ void py_init_module_pacer(nb::module_ &m) {
 
   m.def("load_gps_files", pacer::LoadGPSFiles, nb::arg("filenames"),
         nb::arg("on_sample"), nb::arg("errors") = nb::none(),
-        "/ Loads GPS samples from a mix of .dat and GPMF (.mp4 etc.) files, in "
-        "the\n/ given order. Samples that predate embedded timestamps get a "
-        "clock\n/ synthesized from the MP4 chunk spans, chained across files "
-        "so they stay\n/ ordered. Missing/unreadable files are reported "
-        "through `errors` (if\n/ non-null). Returns the number of files "
-        "samples were loaded from.");
+        "/ Loads GPS samples from a mix of .dat, compact session logs "
+        "(.pcl), raw\n/ UBX captures (.ubx) and GPMF (.mp4 etc.) files, in "
+        "the given order.\n/ Samples that predate embedded timestamps get a "
+        "clock synthesized from\n/ the MP4 chunk spans, chained across "
+        "files so they stay ordered.\n/ Missing/unreadable files are "
+        "reported through `errors` (if non-null).\n/ Returns the number of "
+        "files samples were loaded from.\n/\n/ Files are decoded in "
+        "parallel, but `on_sample` is only ever called from\n/ the calling "
+        "thread, in file order. An exception from `on_sample` (or an\n/ "
+        "unexpected one from a decoder) propagates to the caller; files not "
+        "yet\n/ picked up by a worker are then not decoded.");
   ////////////////////    </generated_from:gps-source.hpp> ////////////////////
 
   ////////////////////    <generated_from:laps-display.hpp> ////////////////////
@@ -1,4 +1,6 @@
 from typing import overload, Callable, Tuple, List, Any
+import numpy
+import numpy.typing
 
 # // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!  AUTOGENERATED CODE !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 # // <litgen_stub>  // Autogenerated code below! Do not edit!
@@ -150,6 +152,10 @@ class CoordinateSystem:
     def distance(self, from_: GPSSample, to: GPSSample) -> float:
         pass
 
+    def origin(self) -> GPSSample:
+        """/ The sample this frame was built around."""
+        pass
+
 @overload
 def interpolate(from_: Point, to: Point, ratio: float) -> Point:
     pass
@@ -318,8 +324,9 @@ class ReferenceTrack:
 
     # / How far TimingLine() extends each gate past both annotated edges, in
     # / meters, so the gate still catches a driven lap that strays slightly
-    # / outside the annotated track boundary. Runtime-only (not saved to the
-    # / track file); tune it in the timeline's reference track loader.
+    # / outside the annotated track boundary. Not in the JSON track file; a
+    # / .ptrk file keeps the value its gates were built with and loads it back.
+    # / Tune it in the timeline's reference track loader.
     gate_extension_m: float = 2.0
 
     def count(self) -> int:
@@ -341,6 +348,12 @@ class ReferenceTrack:
         """
         pass
 
+    def densified_global_gates(self) -> List[Segment]:
+        """/ DensifiedGates() converted with ToGlobal(), the frame the live-timing
+        / engine reads them in.
+        """
+        pass
+
     def to_global(self, local: Segment) -> Segment:
         """/ Converts a local-frame segment to raw lon/lat Points, i.e. the frame
         / pacer::Split() expects when intersecting against raw GPSSample points.
@@ -368,17 +381,28 @@ class ReferenceTrack:
     @staticmethod
     def from_file(filename: str) -> ReferenceTrack:
         """/ Loads a reference track from the JSON schema written by
-        / track_annotator ({"segments": [[[lat,lon],[lat,lon]], ...]}).
-        / Throws std::runtime_error on failure.
+        / track_annotator ({"segments": [[[lat,lon],[lat,lon]], ...]}), or, for a
+        / *.ptrk filename, from the binary format (see SaveToFile()), with
+        / `precomputed` and gate_extension_m filled in. Throws
+        / std::runtime_error on failure.
         """
         pass
 
     def save_to_file(self, filename: str) -> None:
-        """/ Writes this track using the same JSON schema. Throws
-        / std::runtime_error on failure.
+        """/ Writes this track using the same JSON schema, or for a *.ptrk filename
+        / the binary one: a fixed header (magic, version, counts, frame origin,
+        / gate_extension_m), then segments, the densified local and global gates,
+        / and sector_indices as raw arrays in native endianness. Loading it is a
+        / handful of reads straight into the vectors; the JSON stays the
+        / editable source. Throws std::runtime_error on failure.
         """
         pass
 
+    @staticmethod
+    def binary_path(filename: str) -> str:
+        """/ `filename` with its extension replaced by .ptrk."""
+        pass
+
     def build_sectors(self, target_cs: CoordinateSystem) -> Sectors:
         """/ Builds a pacer::Sectors using segments[0] as the start/finish line and
         / sector_indices (in order) as sector splits, converting from this
@@ -475,8 +499,16 @@ class GPMFSource(RawGPSSource):
         """Gets total MP4 duration."""
         pass
 
-class SequentialGPSSource(RawGPSSource):
-    def __init__(self, left: RawGPSSource, right: RawGPSSource) -> None:
+class ChainedGPSSource(RawGPSSource):
+    """Several sources played back to back as one timeline, e.g. the chapters
+    of a GoPro recording. Chapter start offsets are prefix sums of the
+    durations taken once at construction (the sources don't grow), so
+    Seek() and CurrentTimeSpan() find their chapter by binary search rather
+    than walking a chain.
+    """
+
+    def __init__(self, sources: List[RawGPSSource]) -> None:
+        """Sources are borrowed and must outlive the chain."""
         pass
 
     def get_total_duration(self) -> float:
@@ -495,6 +527,19 @@ class SequentialGPSSource(RawGPSSource):
         """Returns current samples' time span."""
         pass
 
+    def source_count(self) -> int:
+        pass
+
+    def current_source(self) -> int:
+        """Index of the chapter being played."""
+        pass
+
+class SequentialGPSSource(ChainedGPSSource):
+    """Two sources back to back; a ChainedGPSSource of both."""
+
+    def __init__(self, left: RawGPSSource, right: RawGPSSource) -> None:
+        pass
+
 class DatVersion(enum.IntEnum):
     just_data = enum.auto()  # (= 0)
     with_timestamp = enum.auto()  # (= 1)
@@ -504,11 +549,17 @@ def load_gps_files(
     on_sample: Callable[[GPSSample], None],
     errors: Optional[List[str]] = None,
 ) -> int:
-    """/ Loads GPS samples from a mix of .dat and GPMF (.mp4 etc.) files, in the
-    / given order. Samples that predate embedded timestamps get a clock
-    / synthesized from the MP4 chunk spans, chained across files so they stay
-    / ordered. Missing/unreadable files are reported through `errors` (if
-    / non-null). Returns the number of files samples were loaded from.
+    """/ Loads GPS samples from a mix of .dat, compact session logs (.pcl), raw
+    / UBX captures (.ubx) and GPMF (.mp4 etc.) files, in the given order.
+    / Samples that predate embedded timestamps get a clock synthesized from
+    / the MP4 chunk spans, chained across files so they stay ordered.
+    / Missing/unreadable files are reported through `errors` (if non-null).
+    / Returns the number of files samples were loaded from.
+    /
+    / Files are decoded in parallel, but `on_sample` is only ever called from
+    / the calling thread, in file order. An exception from `on_sample` (or an
+    / unexpected one from a decoder) propagates to the caller; files not yet
+    / picked up by a worker are then not decoded.
     """
     pass
 
@@ -666,3 +717,41 @@ class DeltaLapsComparision:
 
 # // </litgen_stub> // Autogenerated code end
 # // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!  AUTOGENERATED CODE END !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+# Hand-written bindings (bindings/pacer/dat_file_bindings.cpp)
+
+class DatFile:
+    """Memory-mapped .dat session log. Columns are zero-copy numpy views of the
+    raw UBX-NAV-PVT fields (integer units as logged).
+    """
+
+    def __init__(
+        self, filename: str, version: DatVersion = DatVersion.with_timestamp
+    ) -> None:
+        pass
+    def __len__(self) -> int:
+        pass
+    def sample(self, i: int) -> GPSSample:
+        pass
+    def timestamp(self, i: int) -> int:
+        pass
+    @property
+    def lat_e7(self) -> numpy.typing.NDArray[numpy.int32]:
+        """Latitude, degrees * 1e7."""
+        pass
+    @property
+    def lon_e7(self) -> numpy.typing.NDArray[numpy.int32]:
+        """Longitude, degrees * 1e7."""
+        pass
+    @property
+    def height_mm(self) -> numpy.typing.NDArray[numpy.int32]:
+        """Height above ellipsoid, mm."""
+        pass
+    @property
+    def g_speed_mm_s(self) -> numpy.typing.NDArray[numpy.int32]:
+        """2D ground speed, mm/s."""
+        pass
+    @property
+    def itow_ms(self) -> numpy.typing.NDArray[numpy.uint32]:
+        """GPS time of week, ms."""
+        pass
@@ -810,16 +810,18 @@ bool dashboard_ui_consume_track_reload() {
 
 bool dashboard_ui_logging_enabled() { return s_logging_enabled; }
 
-void dashboard_ui_set_log_stats(size_t written, size_t flushed) {
+void dashboard_ui_set_log_stats(size_t written, size_t flushed, size_t stalls,
+                                size_t overruns) {
   if (!s_disp || !s_logstats_label) {
     return;
   }
   if (lv_obj_has_flag(s_logging_page, LV_OBJ_FLAG_HIDDEN)) {
     return;
   }
-  char buf[48];
-  snprintf(buf, sizeof(buf), "%u flushed\n%u written", (unsigned)flushed,
-           (unsigned)written);
+  char buf[80];
+  snprintf(buf, sizeof(buf), "%u flushed\n%u written\n%u stalls  %u dropped",
+           (unsigned)flushed, (unsigned)written, (unsigned)stalls,
+           (unsigned)overruns);
   lvgl_port_lock(0);
   lv_label_set_text(s_logstats_label, buf);
   lvgl_port_unlock();
@@ -29,16 +29,16 @@ void dashboard_ui_set_status(const char *text);
 void dashboard_ui_set_debug(const char *text);
 
 /// True exactly once after the user picks "Reload track" in the debug menu
-/// (long press -> menu); the main loop polls this.
+/// (long press -> menu); the timing task polls this.
 bool dashboard_ui_consume_track_reload();
 
 /// Live value for the debug menu's "next timing line" page; NaN shows
 /// "no track". Cheap no-op while that page is closed.
 void dashboard_ui_set_next_line_distance(double meters);
 
-/// True while the debug menu's "Track offset" page is open. The main loop
-/// checks this before running LiveTiming::OffsetFromTrack(), which scans
-/// every gate — no point paying for it with nobody watching.
+/// True while the debug menu's "Track offset" page is open. The timing task
+/// checks this before running LiveTiming::OffsetFromTrack() — cheap, but no
+/// point paying for it (or the LVGL lock) with nobody watching.
 bool dashboard_ui_track_offset_visible();
 
 /// Values for the track-offset page (see pacer::TrackOffset); lateral NaN
@@ -59,7 +59,7 @@ void dashboard_ui_set_track_offset(double lateral_m, double half_width_m,
 void dashboard_ui_set_track_map(const std::vector<pacer::Segment> &gates,
                                 const std::vector<int> &sector_splits = {});
 
-/// True while the track-map page is open. The main loop checks this before
+/// True while the track-map page is open. The timing task checks this before
 /// converting the fix into the map frame — no point paying for it (or the
 /// LVGL lock) with nobody watching.
 bool dashboard_ui_track_map_visible();
@@ -72,5 +72,7 @@ void dashboard_ui_set_track_map_position(double x_m, double y_m);
 /// Current state of the debug menu's logging toggle (defaults to on).
 bool dashboard_ui_logging_enabled();
 
-/// Counters for the debug menu's logging page; cheap no-op while closed.
-void dashboard_ui_set_log_stats(size_t written, size_t flushed);
+/// Counters for the debug menu's logging page (see storage_log_*); cheap
+/// no-op while closed.
+void dashboard_ui_set_log_stats(size_t written, size_t flushed, size_t stalls,
+                                size_t overruns);
@@ -1,28 +1,41 @@
 #pragma once
 
 // SD card (SPI mode) storage:
-//  - /sdcard/tracks/*.json        track_annotator reference tracks
+//  - /sdcard/tracks/*.json        track_annotator reference tracks, each
+//                                 with a binary *.ptrk copy beside it
 //  - /sdcard/pacer/config.json    {"session_minutes": 15}
-//  - /sdcard/pacer/SESS_NNN.dat   raw session log, one int64 timestamp_ms +
+//  - /sdcard/pacer/SESS_NNN.pcl   session log in the compact format
+//                                 (pacer/gps-source/compact-log.hpp), or
+//  - /sdcard/pacer/SESS_NNN.dat   with CONFIG_PACER_LOG_COMPACT off: raw
+//                                 session log, one int64 timestamp_ms +
 //                                 uGnssDecUbxNavPvt_t per record — the same
 //                                 DatVersion::WITH_TIMESTAMP format the
 //                                 desktop tools already read.
+//
+// Log files are preallocated in 1 MB extents of zeros ahead of the data,
+// so a log cut off by a power-off ends in a zero tail; the desktop readers
+// treat it as end of file.
 
 #include <string>
 
 #include "esp_err.h"
 
 #include <pacer/gps-source/ubx-nav-pvt.hpp>
+#include <pacer/reference-track/reference-track.hpp>
 
 esp_err_t storage_mount();
 
 /// Session length from config.json, or `fallback_minutes` if absent/invalid.
 double storage_session_minutes(double fallback_minutes);
 
-/// Creates the next free /sdcard/pacer/SESS_NNN.dat for logging.
+/// Creates the next free /sdcard/pacer/SESS_NNN.pcl (.dat) for logging. A
+/// log already open is flushed and closed first, and the counters below
+/// start over for the new one.
 esp_err_t storage_log_open(std::string *path_out = nullptr);
 
-/// Appends one record; flushes to card roughly once a second (25 records).
+/// Appends one record to a RAM buffer; never waits on the card. Roughly once
+/// a second (25 records) the buffer goes to a background writer task that
+/// writes and fsyncs it.
 void storage_log_append(int64_t timestamp_ms, const uGnssDecUbxNavPvt_t &pvt);
 
 /// Records handed to storage_log_append so far this session.
@@ -31,15 +44,31 @@ size_t storage_log_appended();
 /// Records durably on the card (covered by the last fsync).
 size_t storage_log_flushed();
 
-/// Flushes + fsyncs whatever is pending now (e.g. when logging is paused
-/// from the debug menu).
+/// Times a second's worth of records was due but the writer was still busy
+/// with the previous buffer (the card took over a second).
+size_t storage_log_stalls();
+
+/// Records dropped because both buffers were full; not in
+/// storage_log_appended().
+size_t storage_log_overruns();
+
+/// Hands over whatever is buffered and waits until it is fsynced (e.g. when
+/// logging is paused from the debug menu).
 void storage_log_flush();
 
 /// Scans /sdcard/tracks/*.json and returns the path whose start line is
 /// nearest to (lat, lon), or an empty string if none parse. Distance in
 /// meters of the winner via distance_m_out. debug_out (if given) gets a
-/// one-line human-readable scan report: every entry seen and why it was
-/// skipped, for showing on screen.
+/// one-line human-readable scan report: every entry skipped and why, then the
+/// winner, for showing on screen. Start lines come from
+/// /sdcard/tracks/catalog.bin (pacer::TrackCatalog); only files it lacks or
+/// that changed since are parsed, and the catalog is rewritten to match.
 std::string storage_find_track(double lat, double lon,
                                double *distance_m_out = nullptr,
                                std::string *debug_out = nullptr);
+
+/// Loads the track storage_find_track() returned: from the .ptrk beside it
+/// (gates already densified and converted) when that is at least as new as
+/// the JSON, else, or if it doesn't load, from the JSON itself. Throws
+/// std::runtime_error if neither loads.
+pacer::ReferenceTrack storage_load_track(const std::string &json_path);
@@ -1,32 +1,149 @@
 #include "storage.hpp"
 
+#include <atomic>
 #include <cstdio>
+#include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <fstream>
+#include <map>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include "driver/sdspi_host.h"
 #include "driver/spi_common.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_vfs_fat.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 #include "sdkconfig.h"
 #include "sdmmc_cmd.h"
 
 #include <nlohmann/json.hpp>
 
 #include <pacer/geometry/geometry.hpp>
+#include <pacer/gps-source/compact-log.hpp>
 #include <pacer/reference-track/reference-track.hpp>
+#include <pacer/reference-track/track-catalog.hpp>
 
 namespace {
 
 const char *TAG = "storage";
 const char *kMountPoint = "/sdcard";
 
-FILE *s_log = nullptr;
-int s_unflushed = 0;
+// Session log pipeline: storage_log_append() encodes into one of two RAM
+// buffers; about once a second the filled one is handed to a low-priority
+// writer task, which writes and fsyncs it while appends go to the other.
+// A slow card then only delays the writer; appends block on nothing.
+//
+// The file is grown ahead of the data by kExtentBytes of zeros at a time,
+// so the fsync after each buffer only rewrites sectors the file already
+// owns and never allocates clusters. A power-off leaves the zero tail in
+// place; the desktop readers stop at it.
+constexpr size_t kBufferSize = 16 * 1024;
+constexpr size_t kFlushRecords = 25; // ~1 s at 25 Hz
+constexpr off_t kExtentBytes = 1024 * 1024;
+
+#ifdef CONFIG_PACER_LOG_COMPACT
+const char *kLogExtension = "pcl";
+constexpr size_t kMaxRecordSize = pacer::CompactLogEncoder::kMaxRecordSize;
+pacer::CompactLogEncoder s_encoder;
+#else
+const char *kLogExtension = "dat";
+constexpr size_t kMaxRecordSize =
+    sizeof(int64_t) + sizeof(uGnssDecUbxNavPvt_t);
+#endif
+
+struct LogBuffer {
+  uint8_t *data = nullptr; ///< kBufferSize bytes, DMA-capable
+  size_t used = 0;
+  size_t records = 0;     ///< records in `data`
+  size_t records_end = 0; ///< s_appended as of the last one
+};
+
+int s_fd = -1;
+LogBuffer s_buffers[2];
+int s_filling = 0;          ///< buffer storage_log_append() writes into
+QueueHandle_t s_full;       ///< buffer index for the writer task
+SemaphoreHandle_t s_idle;   ///< available while the writer has no buffer
+
 size_t s_appended = 0;
-size_t s_flushed = 0;
+std::atomic<size_t> s_flushed{0};
+size_t s_stalls = 0;
+size_t s_overruns = 0;
+
+// Writer-task state.
+off_t s_written = 0;      ///< log bytes on the card
+off_t s_preallocated = 0; ///< file size: s_written plus the zero tail
+
+// Grows the file by zero extents until `bytes` fit. Writing the zeros is
+// what allocates the clusters; the fsync commits them and the new size.
+bool Preallocate(off_t bytes) {
+  static const uint8_t kZeros[4096] = {};
+  if (s_preallocated >= bytes) {
+    return true;
+  }
+  if (lseek(s_fd, s_preallocated, SEEK_SET) < 0) {
+    return false;
+  }
+  while (s_preallocated < bytes) {
+    for (off_t n = 0; n < kExtentBytes; n += sizeof(kZeros)) {
+      if (write(s_fd, kZeros, sizeof(kZeros)) != sizeof(kZeros)) {
+        return false;
+      }
+    }
+    s_preallocated += kExtentBytes;
+  }
+  return fsync(s_fd) == 0;
+}
+
+void WriterTask(void *) {
+  int index;
+  while (true) {
+    xQueueReceive(s_full, &index, portMAX_DELAY);
+    LogBuffer &buffer = s_buffers[index];
+
+    // Keep a buffer's worth of slack so the next write lands in place too.
+    if (!Preallocate(s_written + buffer.used + kBufferSize)) {
+      ESP_LOGE(TAG, "preallocating the log failed (card full?)");
+    }
+    if (lseek(s_fd, s_written, SEEK_SET) == s_written &&
+        write(s_fd, buffer.data, buffer.used) ==
+            static_cast<ssize_t>(buffer.used)) {
+      s_written += buffer.used;
+      // The data sectors only reach the card on fsync; until then a
+      // power-off loses them even though the file already spans them.
+      if (fsync(s_fd) == 0) {
+        s_flushed = buffer.records_end;
+      }
+    } else {
+      ESP_LOGE(TAG, "log write failed");
+    }
+    buffer.used = 0;
+    buffer.records = 0;
+    xSemaphoreGive(s_idle);
+  }
+}
+
+// Passes s_filling to the writer if it is idle (or once it is, if `wait`).
+bool HandOff(bool wait) {
+  if (xSemaphoreTake(s_idle, wait ? portMAX_DELAY : 0) != pdTRUE) {
+    return false;
+  }
+  s_buffers[s_filling].records_end = s_appended;
+  xQueueSend(s_full, &s_filling, portMAX_DELAY);
+  s_filling ^= 1;
+  return true;
+}
+
+void BufferAppend(const void *bytes, size_t n) {
+  LogBuffer &buffer = s_buffers[s_filling];
+  std::memcpy(buffer.data + buffer.used, bytes, n);
+  buffer.used += n;
+}
 
 } // namespace
 
@@ -92,19 +209,62 @@ double storage_session_minutes(double fallback_minutes) {
 }
 
 esp_err_t storage_log_open(std::string *path_out) {
+  if (s_fd >= 0) {
+    // A new session while one is open: the old file gets what's buffered
+    // and is closed. The flush returns with the writer idle, so its state
+    // can start over below.
+    storage_log_flush();
+    close(s_fd);
+    s_fd = -1;
+  }
+  s_written = 0;
+  s_preallocated = 0;
+  s_appended = 0;
+  s_flushed = 0;
+  s_stalls = 0;
+  s_overruns = 0;
+  for (LogBuffer &buffer : s_buffers) {
+    buffer.used = 0;
+    buffer.records = 0;
+  }
+  s_filling = 0;
+
   char path[64];
   for (int i = 0; i < 1000; ++i) {
-    snprintf(path, sizeof(path), "/sdcard/pacer/SESS_%03d.dat", i);
+    snprintf(path, sizeof(path), "/sdcard/pacer/SESS_%03d.%s", i,
+             kLogExtension);
     struct stat st;
     if (stat(path, &st) != 0) {
       break;
     }
   }
-  s_log = fopen(path, "wb");
-  if (!s_log) {
+  for (LogBuffer &buffer : s_buffers) {
+    if (!buffer.data) {
+      buffer.data = static_cast<uint8_t *>(
+          heap_caps_malloc(kBufferSize, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL));
+    }
+    if (!buffer.data) {
+      ESP_LOGE(TAG, "no memory for log buffers");
+      return ESP_ERR_NO_MEM;
+    }
+  }
+  s_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0664);
+  if (s_fd < 0) {
     ESP_LOGE(TAG, "cannot open %s", path);
     return ESP_FAIL;
   }
+  if (!s_full) {
+    s_full = xQueueCreate(1, sizeof(int));
+    s_idle = xSemaphoreCreateBinary();
+    xSemaphoreGive(s_idle);
+    // Below everything timing- or UI-related: it mostly waits on the card.
+    xTaskCreate(WriterTask, "sd_writer", 4096, nullptr, 2, nullptr);
+  }
+#ifdef CONFIG_PACER_LOG_COMPACT
+  uint8_t header[pacer::CompactLogEncoder::kHeaderSize];
+  BufferAppend(header, pacer::CompactLogEncoder::Header(header));
+  s_encoder.ForceKeyframe();
+#endif
   if (path_out) {
     *path_out = path;
   }
@@ -113,14 +273,35 @@ esp_err_t storage_log_open(std::string *path_out) {
 }
 
 void storage_log_append(int64_t timestamp_ms, const uGnssDecUbxNavPvt_t &pvt) {
-  if (!s_log) {
+  if (s_fd < 0) {
+    return;
+  }
+  if (kBufferSize - s_buffers[s_filling].used < kMaxRecordSize &&
+      !HandOff(false)) {
+    // Both buffers full: the card has been stuck for several seconds.
+    ++s_overruns;
+#ifdef CONFIG_PACER_LOG_COMPACT
+    // The next record that fits must decode without this one.
+    s_encoder.ForceKeyframe();
+#endif
     return;
   }
-  fwrite(&timestamp_ms, sizeof(timestamp_ms), 1, s_log);
-  fwrite(&pvt, sizeof(pvt), 1, s_log);
+#ifdef CONFIG_PACER_LOG_COMPACT
+  LogBuffer &buffer = s_buffers[s_filling];
+  buffer.used +=
+      s_encoder.Append(timestamp_ms, pvt, buffer.data + buffer.used);
+#else
+  BufferAppend(&timestamp_ms, sizeof(timestamp_ms));
+  BufferAppend(&pvt, sizeof(pvt));
+#endif
   ++s_appended;
-  if (++s_unflushed >= 25) {
-    storage_log_flush();
+
+  // A second's worth is due for the card. If the writer is still busy with
+  // the previous one, keep filling and retry on every append.
+  size_t records = ++s_buffers[s_filling].records;
+  if (records >= kFlushRecords && !HandOff(false) &&
+      records == kFlushRecords) {
+    ++s_stalls;
   }
 }
 
@@ -128,17 +309,19 @@ size_t storage_log_appended() { return s_appended; }
 
 size_t storage_log_flushed() { return s_flushed; }
 
+size_t storage_log_stalls() { return s_stalls; }
+
+size_t storage_log_overruns() { return s_overruns; }
+
 void storage_log_flush() {
-  if (!s_log) {
+  if (s_fd < 0) {
     return;
   }
-  // fflush alone only drains the stdio buffer; the FAT directory entry
-  // (file size) is committed by fsync. Without it a hard power-off — the
-  // normal way this device shuts down — leaves a 0-byte file behind.
-  fflush(s_log);
-  fsync(fileno(s_log));
-  s_flushed = s_appended;
-  s_unflushed = 0;
+  // Hand over whatever is buffered, then wait for the writer to fsync it:
+  // the caller is about to let the card be pulled.
+  HandOff(true);
+  xSemaphoreTake(s_idle, portMAX_DELAY);
+  xSemaphoreGive(s_idle);
 }
 
 namespace {
@@ -153,6 +336,16 @@ void debug_append(std::string *debug_out, const std::string &entry) {
   *debug_out += entry;
 }
 
+// Track files that didn't load, by name, as of the size and mtime they had:
+// skipped on later scans (with the same reason) until they change, rather
+// than parsed again every time.
+struct Unreadable {
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  std::string reason;
+};
+std::map<std::string, Unreadable> s_unreadable;
+
 bool has_json_ext(const std::string &name) {
   if (name.size() < 5) {
     return false;
@@ -174,54 +367,115 @@ std::string storage_find_track(double lat, double lon, double *distance_m_out,
     return "";
   }
 
-  pacer::GPSSample here{.lat = lat, .lon = lon, .altitude = 0};
-  pacer::CoordinateSystem cs(here);
+  // The catalog holds each track's start line; only files it doesn't know
+  // (or that changed since) get parsed, and the result is written back.
+  const std::string catalog_path =
+      std::string("/sdcard/tracks/") + pacer::TrackCatalog::kFileName;
+  pacer::TrackCatalog cached;
+  try {
+    cached = pacer::TrackCatalog::FromFile(catalog_path);
+  } catch (const std::exception &) {
+    // First scan, or a card written by an older track_annotator.
+  }
 
-  std::string best_path;
-  double best_dist = 1e18;
+  pacer::TrackCatalog catalog;
+  bool changed = false;
   int entries = 0;
 
   while (dirent *entry = readdir(dir)) {
     std::string name = entry->d_name;
-    if (name == "." || name == "..") {
+    if (name == "." || name == ".." || name == pacer::TrackCatalog::kFileName) {
       continue;
     }
     ++entries;
+    if (pacer::ReferenceTrack::BinaryPath(name) == name) {
+      continue; // a .ptrk, loaded alongside its JSON
+    }
     if (!has_json_ext(name)) {
       debug_append(debug_out, name + ": not *.json");
       continue;
     }
     std::string path = std::string("/sdcard/tracks/") + name;
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    if (!pacer::TrackCatalog::Stat(path, &size, &mtime)) {
+      debug_append(debug_out, name + ": stat failed");
+      continue;
+    }
+    const pacer::TrackCatalog::Entry *known = cached.Find(name);
+    if (known && known->size == size && known->mtime == mtime) {
+      catalog.entries.push_back(*known);
+      continue;
+    }
+    auto failed = s_unreadable.find(name);
+    if (failed != s_unreadable.end() && failed->second.size == size &&
+        failed->second.mtime == mtime) {
+      debug_append(debug_out, name + ": " + failed->second.reason);
+      continue;
+    }
+    std::string reason;
     try {
       auto rt = pacer::ReferenceTrack::FromFile(path);
       if (rt.segments.empty()) {
-        debug_append(debug_out, name + ": no segments");
+        reason = "no segments";
+      } else {
+        catalog.entries.push_back(
+            pacer::TrackCatalog::Describe(rt, name, size, mtime));
+        changed = true;
+        s_unreadable.erase(name);
+        ESP_LOGI(TAG, "track %s: added to catalog", name.c_str());
         continue;
       }
-      pacer::Segment start = rt.ToGlobal(rt.segments[0]);
-      pacer::GPSSample start_gps{
-          .lat = start.first.y, .lon = start.first.x, .altitude = 0};
-      double dist = cs.Distance(here, start_gps);
-      ESP_LOGI(TAG, "track %s: start line %.0f m away", name.c_str(), dist);
-      char buf[32];
-      snprintf(buf, sizeof(buf), ": %.0fm", dist);
-      debug_append(debug_out, name + buf);
-      if (dist < best_dist) {
-        best_dist = dist;
-        best_path = path;
-      }
     } catch (const std::exception &e) {
       ESP_LOGW(TAG, "skipping %s: %s", name.c_str(), e.what());
-      debug_append(debug_out, name + ": " + e.what());
+      reason = e.what();
     }
+    s_unreadable[name] = Unreadable{size, mtime, reason};
+    debug_append(debug_out, name + ": " + reason);
   }
   closedir(dir);
 
+  // A file that doesn't load is no change to write back; one that dropped
+  // out of the catalog shows in the count.
+  if (changed || catalog.entries.size() != cached.entries.size()) {
+    try {
+      catalog.SaveToFile(catalog_path);
+    } catch (const std::exception &e) {
+      // Still usable from memory; the next scan re-parses what changed.
+      ESP_LOGW(TAG, "%s", e.what());
+    }
+  }
+
   if (entries == 0) {
     debug_append(debug_out, "tracks dir empty");
   }
+  double best_dist = 1e18;
+  const pacer::TrackCatalog::Entry *best =
+      catalog.Nearest(lat, lon, &best_dist);
+  if (best) {
+    ESP_LOGI(TAG, "track %s: start line %.0f m away", best->file, best_dist);
+    char buf[32];
+    snprintf(buf, sizeof(buf), ": %.0fm", best_dist);
+    debug_append(debug_out, best->file + std::string(buf));
+  }
   if (distance_m_out) {
     *distance_m_out = best_dist;
   }
-  return best_path;
+  return best ? std::string("/sdcard/tracks/") + best->file : "";
+}
+
+pacer::ReferenceTrack storage_load_track(const std::string &json_path) {
+  std::string binary_path = pacer::ReferenceTrack::BinaryPath(json_path);
+  uint64_t size = 0;
+  int64_t json_mtime = 0, binary_mtime = 0;
+  if (pacer::TrackCatalog::Stat(binary_path, &size, &binary_mtime) &&
+      pacer::TrackCatalog::Stat(json_path, &size, &json_mtime) &&
+      binary_mtime >= json_mtime) {
+    try {
+      return pacer::ReferenceTrack::FromFile(binary_path);
+    } catch (const std::exception &e) {
+      ESP_LOGW(TAG, "%s; falling back to the JSON", e.what());
+    }
+  }
+  return pacer::ReferenceTrack::FromFile(json_path);
 }
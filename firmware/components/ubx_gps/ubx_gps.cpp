@@ -8,6 +8,8 @@
 #include "freertos/task.h"
 #include "sdkconfig.h"
 
+#include <pacer/gps-source/ubx-parser.hpp>
+
 namespace {
 
 const char *TAG = "ubx_gps";
@@ -15,89 +17,27 @@ const char *TAG = "ubx_gps";
 constexpr uart_port_t kUart = (uart_port_t)CONFIG_PACER_GPS_UART_NUM;
 constexpr int kBaud = CONFIG_PACER_GPS_BAUD;
 
-constexpr uint8_t kSync1 = 0xB5, kSync2 = 0x62;
-constexpr uint8_t kClassNav = 0x01, kIdNavPvt = 0x07;
 constexpr uint8_t kClassCfg = 0x06, kIdCfgValset = 0x8A;
-constexpr size_t kNavPvtLen = 92;
 
 ubx_pvt_callback_t s_callback = nullptr;
 void *s_ctx = nullptr;
 
-//------------------------------ wire helpers ------------------------------//
-
-uint16_t get_u2(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
-uint32_t get_u4(const uint8_t *p) {
-  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
-         ((uint32_t)p[3] << 24);
-}
-int32_t get_i4(const uint8_t *p) { return (int32_t)get_u4(p); }
-int16_t get_i2(const uint8_t *p) { return (int16_t)get_u2(p); }
-
-// Offsets per the u-blox interface manual (UBX-NAV-PVT, 92-byte payload).
-// The wire fixType is one byte; the shared struct keeps it as an enum (an
-// int), which is why this is a field-by-field decode and not a memcpy.
-void decode_nav_pvt(const uint8_t *p, uGnssDecUbxNavPvt_t &out) {
-  out.iTOW = get_u4(p + 0);
-  out.year = get_u2(p + 4);
-  out.month = p[6];
-  out.day = p[7];
-  out.hour = p[8];
-  out.min = p[9];
-  out.sec = p[10];
-  out.valid = p[11];
-  out.tAcc = get_u4(p + 12);
-  out.nano = get_i4(p + 16);
-  out.fixType = (uGnssDecUbxNavPvtFixType_t)p[20];
-  out.flags = p[21];
-  out.flags2 = p[22];
-  out.numSV = p[23];
-  out.lon = get_i4(p + 24);
-  out.lat = get_i4(p + 28);
-  out.height = get_i4(p + 32);
-  out.hMSL = get_i4(p + 36);
-  out.hAcc = get_u4(p + 40);
-  out.vAcc = get_u4(p + 44);
-  out.velN = get_i4(p + 48);
-  out.velE = get_i4(p + 52);
-  out.velD = get_i4(p + 56);
-  out.gSpeed = get_i4(p + 60);
-  out.headMot = get_i4(p + 64);
-  out.sAcc = get_u4(p + 68);
-  out.headAcc = get_u4(p + 72);
-  out.pDOP = get_u2(p + 76);
-  out.flags3 = get_u2(p + 78);
-  // p+80..83 reserved
-  out.headVeh = get_i4(p + 84);
-  out.magDec = get_i2(p + 88);
-  out.magAcc = get_u2(p + 90);
-}
-
 //----------------------------- frame sending ------------------------------//
 
-void ubx_checksum(const uint8_t *data, size_t len, uint8_t &ck_a,
-                  uint8_t &ck_b) {
-  ck_a = 0;
-  ck_b = 0;
-  for (size_t i = 0; i < len; ++i) {
-    ck_a += data[i];
-    ck_b += ck_a;
-  }
-}
-
 void send_ubx(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len) {
   uint8_t frame[8 + 512];
   if (len > 512) {
     return;
   }
-  frame[0] = kSync1;
-  frame[1] = kSync2;
+  frame[0] = pacer::kUbxSync1;
+  frame[1] = pacer::kUbxSync2;
   frame[2] = cls;
   frame[3] = id;
   frame[4] = (uint8_t)(len & 0xFF);
   frame[5] = (uint8_t)(len >> 8);
   memcpy(frame + 6, payload, len);
   uint8_t ck_a, ck_b;
-  ubx_checksum(frame + 2, 4 + len, ck_a, ck_b);
+  pacer::UbxChecksum(frame + 2, 4 + len, &ck_a, &ck_b);
   frame[6 + len] = ck_a;
   frame[7 + len] = ck_b;
   uart_write_bytes(kUart, frame, 8 + len);
@@ -157,12 +97,9 @@ void push_config(bool include_baud) {
 //------------------------------ reader task -------------------------------//
 
 void reader_task(void *) {
-  // Frame parser state machine.
-  enum class St { Sync1, Sync2, Class, Id, Len1, Len2, Payload, CkA, CkB };
-  St st = St::Sync1;
-  uint8_t cls = 0, id = 0, ck_a = 0, ck_b = 0;
-  uint16_t len = 0, got = 0;
-  static uint8_t payload[1024];
+  // Static: the parser carries a max-size frame buffer, too big for the
+  // task's stack.
+  static pacer::UbxParser parser;
 
   uint8_t buf[256];
   TickType_t last_pvt = xTaskGetTickCount();
@@ -199,75 +136,21 @@ void reader_task(void *) {
       uart_set_baudrate(kUart, kBaud);
       push_config(/*include_baud=*/false);
       uart_flush_input(kUart);
-      st = St::Sync1;
+      parser.Reset();
       last_pvt = xTaskGetTickCount();
       continue;
     }
 
-    for (int i = 0; i < n; ++i) {
-      uint8_t b = buf[i];
-      switch (st) {
-      case St::Sync1:
-        st = (b == kSync1) ? St::Sync2 : St::Sync1;
-        break;
-      case St::Sync2:
-        st = (b == kSync2) ? St::Class : St::Sync1;
-        break;
-      case St::Class:
-        cls = b;
-        ck_a = b;
-        ck_b = ck_a;
-        st = St::Id;
-        break;
-      case St::Id:
-        id = b;
-        ck_a += b;
-        ck_b += ck_a;
-        st = St::Len1;
-        break;
-      case St::Len1:
-        len = b;
-        ck_a += b;
-        ck_b += ck_a;
-        st = St::Len2;
-        break;
-      case St::Len2:
-        len |= (uint16_t)b << 8;
-        ck_a += b;
-        ck_b += ck_a;
-        got = 0;
-        if (len > sizeof(payload)) {
-          st = St::Sync1;
-        } else {
-          st = len ? St::Payload : St::CkA;
-        }
-        break;
-      case St::Payload:
-        payload[got++] = b;
-        ck_a += b;
-        ck_b += ck_a;
-        if (got == len) {
-          st = St::CkA;
-        }
-        break;
-      case St::CkA:
-        st = (b == ck_a) ? St::CkB : St::Sync1;
-        break;
-      case St::CkB:
-        if (b == ck_b && cls == kClassNav && id == kIdNavPvt &&
-            len >= kNavPvtLen) {
-          uGnssDecUbxNavPvt_t pvt;
-          decode_nav_pvt(payload, pvt);
-          last_pvt = xTaskGetTickCount();
-          resync_attempt = 0;
-          if (s_callback) {
-            s_callback(pvt, s_ctx);
-          }
-        }
-        st = St::Sync1;
-        break;
-      }
+    if (n <= 0) {
+      continue;
     }
+    parser.FeedNavPvt({buf, (size_t)n}, [&](const uGnssDecUbxNavPvt_t &pvt) {
+      last_pvt = xTaskGetTickCount();
+      resync_attempt = 0;
+      if (s_callback) {
+        s_callback(pvt, s_ctx);
+      }
+    });
   }
 }
 
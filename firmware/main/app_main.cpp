@@ -1,15 +1,21 @@
 // In-kart live timing dashboard.
 //
 // Data flow:
-//   ubx_gps reader task --(queue)--> main loop:
-//     log to SD (.dat, same format the desktop tools read)
-//     -> LiveTiming::OnSample -> dashboard_ui at ~10 Hz
+//   ubx_gps reader task --(queue)--> timing task:
+//     log to SD (.pcl/.dat, formats the desktop tools read)
+//     -> LiveTiming::OnSample -> DashFrame --(TripleBuffer)--> main loop:
+//     dashboard_ui at ~10 Hz
+//
+// The timing task never waits on LVGL: a slow repaint only means the screen
+// skips frames, never that fixes pile up in the queue.
 //
 // On the first 2D/3D fix, the nearest /sdcard/tracks/*.json annotation is
 // loaded as the reference track; until then the screen shows fix status.
 
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -21,11 +27,14 @@
 #include "soc/rtc_cntl_reg.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "freertos/task.h"
 #include "sdkconfig.h"
 
 #include <pacer/datatypes/datatypes.hpp>
 #include <pacer/geometry/geometry.hpp>
+#include <pacer/gps-source/ubx-parser.hpp>
 #include <pacer/live-timing/live-timing.hpp>
+#include <pacer/live-timing/triple-buffer.hpp>
 #include <pacer/reference-track/reference-track.hpp>
 
 #include "dashboard_ui.hpp"
@@ -38,23 +47,36 @@ const char *TAG = "pacer";
 
 QueueHandle_t s_pvt_queue = nullptr;
 
+// LiveTiming's current/best gate times, kept out of the heap.
+int32_t s_gate_times[2][CONFIG_PACER_MAX_GATES];
+
+// Everything the main screen shows, produced by the timing task once per fix.
+struct DashFrame {
+  bool timing_valid = false; ///< a track is loaded; the fields below are live
+  pacer::LiveSnapshot timing;
+  double next_line_m = NAN;
+  bool has_offset = false; ///< only filled while the offset page is open
+  pacer::TrackOffset offset;
+  bool has_map_pos = false; ///< only filled while the map page is open
+  double map_x_m = 0, map_y_m = 0;
+  size_t log_appended = 0, log_flushed = 0, log_stalls = 0, log_overruns = 0;
+  char status[256] = ""; ///< fits a track-scan report
+  char debug[64] = "";
+};
+
+pacer::TripleBuffer<DashFrame> s_frames;
+
+// Set by app_main before the timing task starts.
+bool s_sd_ok = false;
+double s_session_minutes = CONFIG_PACER_SESSION_MINUTES;
+
 void OnPvt(const uGnssDecUbxNavPvt_t &pvt, void *) {
   // Reader task context: hand off and get back to the UART. Dropping on a
-  // full queue is fine — the consumer only stalls on SD flush hiccups.
+  // full queue is fine — the consumer only stalls while scanning for a
+  // track or committing the log when logging is paused.
   xQueueSend(s_pvt_queue, &pvt, 0);
 }
 
-pacer::GPSSample ToSample(const uGnssDecUbxNavPvt_t &pvt) {
-  return pacer::GPSSample{
-      .lat = static_cast<double>(pvt.lat) / 1e7,
-      .lon = static_cast<double>(pvt.lon) / 1e7,
-      .altitude = pvt.height / 1000.0,
-      .full_speed = pvt.gSpeed / 1000.0,
-      .ground_speed = pvt.gSpeed / 1000.0,
-      .timestamp_ms = static_cast<int64_t>(pvt.iTOW),
-  };
-}
-
 // Diagnostic for the reset-into-download-mode issue: GPIO0 is the boot strap;
 // something appears to hold it low across warm resets. Samples the pin 1000x
 // floating and 1000x with pull-up: low-with-pullup means actively driven low.
@@ -87,29 +109,16 @@ void StrapDiagTask(void *) {
   }
 }
 
-} // namespace
-
-extern "C" void app_main(void) {
-  LogStrapDiag("boot");
-  xTaskCreate(StrapDiagTask, "strap_diag", 4096, nullptr, 1, nullptr);
-  ESP_ERROR_CHECK(dashboard_ui_start());
-  dashboard_ui_set_status("mounting sd card...");
-
-  bool sd_ok = storage_mount() == ESP_OK;
-  double session_minutes = CONFIG_PACER_SESSION_MINUTES;
-  if (sd_ok) {
-    session_minutes = storage_session_minutes(session_minutes);
-    storage_log_open();
-  }
-
-  s_pvt_queue = xQueueCreate(64, sizeof(uGnssDecUbxNavPvt_t));
-  ESP_ERROR_CHECK(ubx_gps_start(OnPvt, nullptr));
-  dashboard_ui_set_status(sd_ok ? "waiting for gps fix..."
-                                : "NO SD CARD - waiting for gps fix...");
-
-  pacer::LiveTiming timing;
+// Owns the LiveTiming instance: consumes fixes, logs them, loads the track
+// and publishes a DashFrame per fix. The only LVGL calls from here are the
+// one-off track-map install/clear on (re)load.
+void TimingTask(void *) {
+  // Single precision: the S3's FPU has no double unit.
+  pacer::LiveTimingF timing;
+  timing.SetGateTimeStorage(s_gate_times[0], s_gate_times[1]);
   bool track_loaded = false;
   std::string track_name;
+  double session_minutes = s_session_minutes;
 
   // Frame for the track-map page: origin at the "median" of the track (mean
   // of the annotated gate midpoints), so the outline is centered on its own
@@ -118,9 +127,8 @@ extern "C" void app_main(void) {
   pacer::CoordinateSystem map_cs;
   bool map_ready = false;
 
+  DashFrame frame;
   uGnssDecUbxNavPvt_t pvt;
-  int samples_since_ui = 0;
-  int samples_since_debug = 0;
   int samples_until_scan = 1;
   bool was_logging = false;
 
@@ -134,20 +142,22 @@ extern "C" void app_main(void) {
     if (dashboard_ui_consume_track_reload()) {
       track_loaded = false;
       track_name.clear();
-      timing = pacer::LiveTiming{};
+      timing = pacer::LiveTimingF{};
+      timing.SetGateTimeStorage(s_gate_times[0], s_gate_times[1]);
       map_ready = false;
       dashboard_ui_set_track_map({});
-      if (sd_ok) {
+      if (s_sd_ok) {
         session_minutes = storage_session_minutes(CONFIG_PACER_SESSION_MINUTES);
       }
       samples_until_scan = 1;
-      dashboard_ui_set_status("track reload requested...");
+      frame.timing_valid = false;
+      snprintf(frame.status, sizeof(frame.status), "track reload requested...");
       ESP_LOGI(TAG, "track reload requested");
     }
 
     // Debug menu toggle gates the log; on pause, commit what's pending so
     // pulling the card right after is safe.
-    bool logging = sd_ok && dashboard_ui_logging_enabled();
+    bool logging = s_sd_ok && dashboard_ui_logging_enabled();
     if (was_logging && !logging) {
       storage_log_flush();
     }
@@ -158,30 +168,28 @@ extern "C" void app_main(void) {
 
     // Raw receiver state in the corner, unconditionally — the point is to
     // see what the GPS reports even before a fix or track.
-    if (++samples_since_debug >= 5) {
-      samples_since_debug = 0;
-      char dbg[64];
-      snprintf(dbg, sizeof(dbg), "%.6f %.6f  %.1f km/h  %d sat",
-               pvt.lat / 1e7, pvt.lon / 1e7, pvt.gSpeed * 0.0036, pvt.numSV);
-      dashboard_ui_set_debug(dbg);
-      dashboard_ui_set_log_stats(storage_log_appended(), storage_log_flushed());
-    }
+    snprintf(frame.debug, sizeof(frame.debug), "%.6f %.6f  %.1f km/h  %d sat",
+             pvt.lat / 1e7, pvt.lon / 1e7, pvt.gSpeed * 0.0036, pvt.numSV);
+    frame.log_appended = storage_log_appended();
+    frame.log_flushed = storage_log_flushed();
+    frame.log_stalls = storage_log_stalls();
+    frame.log_overruns = storage_log_overruns();
 
     bool has_fix = pvt.fixType == U_GNSS_DEC_UBX_NAV_PVT_FIX_TYPE_2D ||
                    pvt.fixType == U_GNSS_DEC_UBX_NAV_PVT_FIX_TYPE_3D ||
                    pvt.fixType ==
                        U_GNSS_DEC_UBX_NAV_PVT_FIX_TYPE_GNSS_PLUS_DEAD_RECKONING;
     if (!has_fix) {
-      char status[64];
-      snprintf(status, sizeof(status), "no fix (%d sats)", pvt.numSV);
-      dashboard_ui_set_status(status);
+      snprintf(frame.status, sizeof(frame.status), "no fix (%d sats)",
+               pvt.numSV);
+      s_frames.Publish(frame);
       continue;
     }
 
-    pacer::GPSSample sample = ToSample(pvt);
+    pacer::GPSSample sample = pacer::ToGPSSample(pvt);
 
     if (!track_loaded) {
-      if (sd_ok && --samples_until_scan <= 0) {
+      if (s_sd_ok && --samples_until_scan <= 0) {
         samples_until_scan = 25; // rescan ~1/s, not per 25 Hz sample
         double dist = 0;
         std::string scan_debug;
@@ -189,7 +197,7 @@ extern "C" void app_main(void) {
             storage_find_track(sample.lat, sample.lon, &dist, &scan_debug);
         if (!path.empty()) {
           try {
-            auto rt = pacer::ReferenceTrack::FromFile(path);
+            auto rt = storage_load_track(path);
             timing.SetReferenceTrack(
                 rt, pacer::SessionConfig{.session_length_s =
                                              session_minutes * 60.0});
@@ -229,42 +237,105 @@ extern "C" void app_main(void) {
           }
         }
         if (!track_loaded) {
-          std::string status = "no track | " + scan_debug;
-          dashboard_ui_set_status(status.c_str());
+          snprintf(frame.status, sizeof(frame.status), "no track | %s",
+                   scan_debug.c_str());
         }
-      } else if (!sd_ok) {
-        dashboard_ui_set_status("fix ok - NO SD CARD");
+      } else if (!s_sd_ok) {
+        snprintf(frame.status, sizeof(frame.status), "fix ok - NO SD CARD");
       }
       if (!track_loaded) {
+        s_frames.Publish(frame);
         continue;
       }
     }
 
     timing.OnSample(sample);
 
-    // 25 Hz in, ~8 Hz to the screen: plenty for eyes, cheap for LVGL.
-    if (++samples_since_ui >= 3) {
-      samples_since_ui = 0;
-      dashboard_ui_update(timing.Snapshot());
-      dashboard_ui_set_next_line_distance(timing.DistanceToNextLine(sample));
-      // Both map calls are skipped while the page is closed.
-      if (map_ready && dashboard_ui_track_map_visible()) {
-        pacer::Vec3f local = map_cs.Local(sample);
-        dashboard_ui_set_track_map_position(local.x, local.y);
-      }
-      // Full gate scan — only worth it while that debug page is open.
-      if (dashboard_ui_track_offset_visible()) {
-        if (auto off = timing.OffsetFromTrack(sample)) {
-          dashboard_ui_set_track_offset(off->lateral_m, off->half_width_m,
-                                        off->gate,
-                                        timing.Snapshot().gate_count);
-        }
+    frame.timing_valid = true;
+    frame.timing = timing.Snapshot();
+    frame.next_line_m = timing.DistanceToNextLine(sample);
+    // Both map fields and the nearest-gate lookup are only worth it while
+    // their debug pages are open.
+    frame.has_map_pos = map_ready && dashboard_ui_track_map_visible();
+    if (frame.has_map_pos) {
+      pacer::Vec3f local = map_cs.Local(sample);
+      frame.map_x_m = local.x;
+      frame.map_y_m = local.y;
+    }
+    frame.has_offset = false;
+    if (dashboard_ui_track_offset_visible()) {
+      if (auto off = timing.OffsetFromTrack(sample)) {
+        frame.has_offset = true;
+        frame.offset = *off;
       }
-      char status[96];
-      snprintf(status, sizeof(status), "%s | %d sats | %.0f km/h%s",
-               track_name.c_str(), pvt.numSV, sample.full_speed * 3.6,
-               sd_ok ? "" : " | NO LOG");
-      dashboard_ui_set_status(status);
+    }
+    snprintf(frame.status, sizeof(frame.status), "%s | %d sats | %.0f km/h%s",
+             track_name.c_str(), pvt.numSV, sample.full_speed * 3.6,
+             s_sd_ok ? "" : " | NO LOG");
+    s_frames.Publish(frame);
+  }
+}
+
+} // namespace
+
+extern "C" void app_main(void) {
+  LogStrapDiag("boot");
+  xTaskCreate(StrapDiagTask, "strap_diag", 4096, nullptr, 1, nullptr);
+  ESP_ERROR_CHECK(dashboard_ui_start());
+  dashboard_ui_set_status("mounting sd card...");
+
+  s_sd_ok = storage_mount() == ESP_OK;
+  if (s_sd_ok) {
+    s_session_minutes = storage_session_minutes(s_session_minutes);
+    storage_log_open();
+  }
+
+  s_pvt_queue = xQueueCreate(64, sizeof(uGnssDecUbxNavPvt_t));
+  ESP_ERROR_CHECK(ubx_gps_start(OnPvt, nullptr));
+  dashboard_ui_set_status(s_sd_ok ? "waiting for gps fix..."
+                                  : "NO SD CARD - waiting for gps fix...");
+
+  // Below the UART reader (10) so it drains the receiver first, above the
+  // LVGL task so a repaint can't delay a fix.
+  xTaskCreate(TimingTask, "timing", 8192, nullptr, 8, nullptr);
+
+  // UI loop: repaint from the newest frame at ~10 Hz — plenty for eyes,
+  // cheap for LVGL. Frames published in between are simply skipped.
+  char shown_status[sizeof(DashFrame::status)] = "";
+  char shown_debug[sizeof(DashFrame::debug)] = "";
+  while (true) {
+    vTaskDelay(pdMS_TO_TICKS(100));
+    if (!s_frames.Fresh()) {
+      continue;
+    }
+    const DashFrame &frame = s_frames.Read();
+
+    // Labels only change when their text does; each set is an LVGL lock.
+    if (strcmp(shown_status, frame.status) != 0) {
+      dashboard_ui_set_status(frame.status);
+      memcpy(shown_status, frame.status, sizeof(shown_status));
+    }
+    if (strcmp(shown_debug, frame.debug) != 0) {
+      dashboard_ui_set_debug(frame.debug);
+      memcpy(shown_debug, frame.debug, sizeof(shown_debug));
+    }
+    dashboard_ui_set_log_stats(frame.log_appended, frame.log_flushed,
+                               frame.log_stalls, frame.log_overruns);
+
+    if (!frame.timing_valid) {
+      continue;
+    }
+    dashboard_ui_update(frame.timing);
+    dashboard_ui_set_next_line_distance(frame.next_line_m);
+    // Both calls are no-ops while their pages are closed.
+    if (frame.has_map_pos) {
+      dashboard_ui_set_track_map_position(frame.map_x_m, frame.map_y_m);
+    }
+    if (frame.has_offset) {
+      dashboard_ui_set_track_offset(frame.offset.lateral_m,
+                                    frame.offset.half_width_m,
+                                    frame.offset.gate,
+                                    frame.timing.gate_count);
     }
   }
 }
@@ -19,18 +19,23 @@ inline std::ostream &operator<<(std::ostream &os, const GPSSample &s) {
             << ", ground: " << s.ground_speed << ")";
 }
 
-struct Vec3f : public VectorOperators<Vec3f, double, 3> {
-  double x = 0, y = 0, z = 0;
+// 3D vector over scalar T: double on the desktop, float where the FPU only
+// does single precision (the ESP32-S3), in a frame small enough for it.
+template <typename T>
+struct BasicVec3 : public VectorOperators<BasicVec3<T>, T, 3> {
+  T x = 0, y = 0, z = 0;
 
-  Vec3f() = default;
-  Vec3f(double x, double y, double z) : x{x}, y{y}, z{z} {}
+  BasicVec3() = default;
+  BasicVec3(T x, T y, T z) : x{x}, y{y}, z{z} {}
 
-  double &operator[](size_t index) {
+  T &operator[](size_t index) {
     return (index == 0) ? x : (index == 1) ? y : z;
   }
-  double operator[](size_t index) const {
+  T operator[](size_t index) const {
     return (index == 0) ? x : (index == 1) ? y : z;
   }
 };
 
+using Vec3f = BasicVec3<double>;
+
 } // namespace pacer
@@ -0,0 +1,323 @@
+#include "crossings.hpp"
+
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define PACER_CROSSINGS_AVX2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PACER_CROSSINGS_NEON 1
+#endif
+
+template <typename T>
+pacer::BasicSegmentBatch<T>::BasicSegmentBatch(
+    const std::vector<BasicSegment<T>> &segments) {
+  ax.reserve(segments.size());
+  ay.reserve(segments.size());
+  bx.reserve(segments.size());
+  by.reserve(segments.size());
+  nx.reserve(segments.size());
+  ny.reserve(segments.size());
+  for (const BasicSegment<T> &s : segments) {
+    push_back(s);
+  }
+}
+
+template <typename T>
+void pacer::BasicSegmentBatch<T>::push_back(const BasicSegment<T> &s) {
+  BasicPoint<T> n = (s.second - s.first).Rot();
+  ax.push_back(s.first.x);
+  ay.push_back(s.first.y);
+  bx.push_back(s.second.x);
+  by.push_back(s.second.y);
+  nx.push_back(n.x);
+  ny.push_back(n.y);
+}
+
+template struct pacer::BasicSegmentBatch<double>;
+template struct pacer::BasicSegmentBatch<float>;
+
+namespace {
+
+// Segment{a, b}.Intersects(f, s), spelled out on scalars with the segment
+// normal (gnx, gny) given. The vector kernels below only decide which lanes
+// hit; ratios always come from here, so every path agrees bit for bit.
+template <typename T>
+inline bool Cross(T fx, T fy, T sx, T sy, T ax, T ay, T bx, T by, T gnx,
+                  T gny, T *ratio) {
+  T nx = -(sy - fy), ny = sx - fx;
+  T s1 = nx * (bx - fx) + ny * (by - fy);
+  T s2 = nx * (ax - fx) + ny * (ay - fy);
+  if (s1 * s2 >= 0) {
+    return false;
+  }
+  T d1 = gnx * (sx - ax) + gny * (sy - ay);
+  T d2 = gnx * (fx - ax) + gny * (fy - ay);
+  if (d1 * d2 >= 0) {
+    return false;
+  }
+  d1 = std::abs(d1);
+  d2 = std::abs(d2);
+  *ratio = d2 / (d1 + d2);
+  return true;
+}
+
+template <typename T>
+void FindCrossingsScalar(const pacer::BasicSegmentBatch<T> &b, size_t begin,
+                         size_t end, pacer::BasicPoint<T> f,
+                         pacer::BasicPoint<T> s,
+                         std::vector<pacer::BasicSegmentHit<T>> *out) {
+  for (size_t i = begin; i < end; ++i) {
+    T ratio = 0;
+    if (Cross(f.x, f.y, s.x, s.y, b.ax[i], b.ay[i], b.bx[i], b.by[i], b.nx[i],
+              b.ny[i], &ratio)) {
+      out->push_back(
+          pacer::BasicSegmentHit<T>{static_cast<uint32_t>(i), ratio});
+    }
+  }
+}
+
+size_t FindFirstCrossingScalar(const pacer::Segment &g, double gnx,
+                               double gny, const double *x, const double *y,
+                               size_t begin, size_t end, double *ratio) {
+  for (size_t i = begin; i < end; ++i) {
+    if (Cross(x[i - 1], y[i - 1], x[i], y[i], g.first.x, g.first.y,
+              g.second.x, g.second.y, gnx, gny, ratio)) {
+      return i;
+    }
+  }
+  return end;
+}
+
+#if PACER_CROSSINGS_AVX2
+
+// Lanes where !(s1 * s2 >= 0) && !(d1 * d2 >= 0) — the NaN-tolerant
+// negation Segment::Intersects() uses.
+__attribute__((target("avx2"))) inline int
+HitMask(__m256d s1, __m256d s2, __m256d d1, __m256d d2) {
+  __m256d zero = _mm256_setzero_pd();
+  __m256d ok1 = _mm256_cmp_pd(_mm256_mul_pd(s1, s2), zero, _CMP_NGE_UQ);
+  __m256d ok2 = _mm256_cmp_pd(_mm256_mul_pd(d1, d2), zero, _CMP_NGE_UQ);
+  return _mm256_movemask_pd(_mm256_and_pd(ok1, ok2));
+}
+
+__attribute__((target("avx2"))) void
+FindCrossingsAvx2(const pacer::SegmentBatch &b, size_t begin, size_t end,
+                  pacer::Point f, pacer::Point s,
+                  std::vector<pacer::SegmentHit> *out) {
+  __m256d fx = _mm256_set1_pd(f.x), fy = _mm256_set1_pd(f.y);
+  __m256d sx = _mm256_set1_pd(s.x), sy = _mm256_set1_pd(s.y);
+  __m256d nx = _mm256_set1_pd(-(s.y - f.y)), ny = _mm256_set1_pd(s.x - f.x);
+
+  size_t i = begin;
+  for (; i + 4 <= end; i += 4) {
+    __m256d ax = _mm256_loadu_pd(&b.ax[i]), ay = _mm256_loadu_pd(&b.ay[i]);
+    __m256d bx = _mm256_loadu_pd(&b.bx[i]), by = _mm256_loadu_pd(&b.by[i]);
+    __m256d gnx = _mm256_loadu_pd(&b.nx[i]), gny = _mm256_loadu_pd(&b.ny[i]);
+
+    __m256d s1 = _mm256_add_pd(_mm256_mul_pd(nx, _mm256_sub_pd(bx, fx)),
+                               _mm256_mul_pd(ny, _mm256_sub_pd(by, fy)));
+    __m256d s2 = _mm256_add_pd(_mm256_mul_pd(nx, _mm256_sub_pd(ax, fx)),
+                               _mm256_mul_pd(ny, _mm256_sub_pd(ay, fy)));
+    __m256d d1 = _mm256_add_pd(_mm256_mul_pd(gnx, _mm256_sub_pd(sx, ax)),
+                               _mm256_mul_pd(gny, _mm256_sub_pd(sy, ay)));
+    __m256d d2 = _mm256_add_pd(_mm256_mul_pd(gnx, _mm256_sub_pd(fx, ax)),
+                               _mm256_mul_pd(gny, _mm256_sub_pd(fy, ay)));
+
+    // Crossings are rare; only hit lanes go through the scalar path.
+    if (HitMask(s1, s2, d1, d2) != 0) {
+      FindCrossingsScalar(b, i, i + 4, f, s, out);
+    }
+  }
+  FindCrossingsScalar(b, i, end, f, s, out);
+}
+
+__attribute__((target("avx2"))) size_t
+FindFirstCrossingAvx2(const pacer::Segment &g, double gnx_s, double gny_s,
+                      const double *x, const double *y, size_t begin,
+                      size_t end, double *ratio) {
+  __m256d ax = _mm256_set1_pd(g.first.x), ay = _mm256_set1_pd(g.first.y);
+  __m256d bx = _mm256_set1_pd(g.second.x), by = _mm256_set1_pd(g.second.y);
+  __m256d gnx = _mm256_set1_pd(gnx_s), gny = _mm256_set1_pd(gny_s);
+  __m256d sign = _mm256_set1_pd(-0.0);
+
+  size_t i = begin;
+  for (; i + 4 <= end; i += 4) {
+    __m256d fx = _mm256_loadu_pd(x + i - 1), fy = _mm256_loadu_pd(y + i - 1);
+    __m256d sx = _mm256_loadu_pd(x + i), sy = _mm256_loadu_pd(y + i);
+
+    __m256d nx = _mm256_xor_pd(_mm256_sub_pd(sy, fy), sign);
+    __m256d ny = _mm256_sub_pd(sx, fx);
+    __m256d s1 = _mm256_add_pd(_mm256_mul_pd(nx, _mm256_sub_pd(bx, fx)),
+                               _mm256_mul_pd(ny, _mm256_sub_pd(by, fy)));
+    __m256d s2 = _mm256_add_pd(_mm256_mul_pd(nx, _mm256_sub_pd(ax, fx)),
+                               _mm256_mul_pd(ny, _mm256_sub_pd(ay, fy)));
+    __m256d d1 = _mm256_add_pd(_mm256_mul_pd(gnx, _mm256_sub_pd(sx, ax)),
+                               _mm256_mul_pd(gny, _mm256_sub_pd(sy, ay)));
+    __m256d d2 = _mm256_add_pd(_mm256_mul_pd(gnx, _mm256_sub_pd(fx, ax)),
+                               _mm256_mul_pd(gny, _mm256_sub_pd(fy, ay)));
+
+    // The scalar pass has the final say (and sets the ratio); should it
+    // reject every flagged lane, scanning carries on past them.
+    if (HitMask(s1, s2, d1, d2) != 0) {
+      size_t hit =
+          FindFirstCrossingScalar(g, gnx_s, gny_s, x, y, i, i + 4, ratio);
+      if (hit != i + 4) {
+        return hit;
+      }
+    }
+  }
+  return FindFirstCrossingScalar(g, gnx_s, gny_s, x, y, i, end, ratio);
+}
+
+bool HasAvx2() {
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  return has_avx2;
+}
+
+#elif PACER_CROSSINGS_NEON
+
+inline uint64x2_t HitMask(float64x2_t s1, float64x2_t s2, float64x2_t d1,
+                          float64x2_t d2) {
+  float64x2_t zero = vdupq_n_f64(0);
+  uint64x2_t reject = vorrq_u64(vcgeq_f64(vmulq_f64(s1, s2), zero),
+                                vcgeq_f64(vmulq_f64(d1, d2), zero));
+  return veorq_u64(reject, vdupq_n_u64(~uint64_t{0}));
+}
+
+void FindCrossingsNeon(const pacer::SegmentBatch &b, size_t begin,
+                       size_t end, pacer::Point f, pacer::Point s,
+                       std::vector<pacer::SegmentHit> *out) {
+  float64x2_t fx = vdupq_n_f64(f.x), fy = vdupq_n_f64(f.y);
+  float64x2_t sx = vdupq_n_f64(s.x), sy = vdupq_n_f64(s.y);
+  float64x2_t nx = vdupq_n_f64(-(s.y - f.y)), ny = vdupq_n_f64(s.x - f.x);
+
+  size_t i = begin;
+  for (; i + 2 <= end; i += 2) {
+    float64x2_t ax = vld1q_f64(&b.ax[i]), ay = vld1q_f64(&b.ay[i]);
+    float64x2_t bx = vld1q_f64(&b.bx[i]), by = vld1q_f64(&b.by[i]);
+    float64x2_t gnx = vld1q_f64(&b.nx[i]), gny = vld1q_f64(&b.ny[i]);
+
+    float64x2_t s1 = vaddq_f64(vmulq_f64(nx, vsubq_f64(bx, fx)),
+                               vmulq_f64(ny, vsubq_f64(by, fy)));
+    float64x2_t s2 = vaddq_f64(vmulq_f64(nx, vsubq_f64(ax, fx)),
+                               vmulq_f64(ny, vsubq_f64(ay, fy)));
+    float64x2_t d1 = vaddq_f64(vmulq_f64(gnx, vsubq_f64(sx, ax)),
+                               vmulq_f64(gny, vsubq_f64(sy, ay)));
+    float64x2_t d2 = vaddq_f64(vmulq_f64(gnx, vsubq_f64(fx, ax)),
+                               vmulq_f64(gny, vsubq_f64(fy, ay)));
+
+    uint64x2_t hit = HitMask(s1, s2, d1, d2);
+    if (vgetq_lane_u64(hit, 0) | vgetq_lane_u64(hit, 1)) {
+      FindCrossingsScalar(b, i, i + 2, f, s, out);
+    }
+  }
+  FindCrossingsScalar(b, i, end, f, s, out);
+}
+
+size_t FindFirstCrossingNeon(const pacer::Segment &g, double gnx_s,
+                             double gny_s, const double *x, const double *y,
+                             size_t begin, size_t end, double *ratio) {
+  float64x2_t ax = vdupq_n_f64(g.first.x), ay = vdupq_n_f64(g.first.y);
+  float64x2_t bx = vdupq_n_f64(g.second.x), by = vdupq_n_f64(g.second.y);
+  float64x2_t gnx = vdupq_n_f64(gnx_s), gny = vdupq_n_f64(gny_s);
+
+  size_t i = begin;
+  for (; i + 2 <= end; i += 2) {
+    float64x2_t fx = vld1q_f64(x + i - 1), fy = vld1q_f64(y + i - 1);
+    float64x2_t sx = vld1q_f64(x + i), sy = vld1q_f64(y + i);
+
+    float64x2_t nx = vnegq_f64(vsubq_f64(sy, fy));
+    float64x2_t ny = vsubq_f64(sx, fx);
+    float64x2_t s1 = vaddq_f64(vmulq_f64(nx, vsubq_f64(bx, fx)),
+                               vmulq_f64(ny, vsubq_f64(by, fy)));
+    float64x2_t s2 = vaddq_f64(vmulq_f64(nx, vsubq_f64(ax, fx)),
+                               vmulq_f64(ny, vsubq_f64(ay, fy)));
+    float64x2_t d1 = vaddq_f64(vmulq_f64(gnx, vsubq_f64(sx, ax)),
+                               vmulq_f64(gny, vsubq_f64(sy, ay)));
+    float64x2_t d2 = vaddq_f64(vmulq_f64(gnx, vsubq_f64(fx, ax)),
+                               vmulq_f64(gny, vsubq_f64(fy, ay)));
+
+    // As in the AVX2 kernel: the scalar pass decides, and a rejected pair
+    // of lanes doesn't end the scan.
+    uint64x2_t mask = HitMask(s1, s2, d1, d2);
+    if (vgetq_lane_u64(mask, 0) | vgetq_lane_u64(mask, 1)) {
+      size_t hit =
+          FindFirstCrossingScalar(g, gnx_s, gny_s, x, y, i, i + 2, ratio);
+      if (hit != i + 2) {
+        return hit;
+      }
+    }
+  }
+  return FindFirstCrossingScalar(g, gnx_s, gny_s, x, y, i, end, ratio);
+}
+
+#endif
+
+pacer::CrossingsKernel BestKernel() {
+#if PACER_CROSSINGS_AVX2
+  return HasAvx2() ? pacer::CrossingsKernel::kAvx2
+                   : pacer::CrossingsKernel::kScalar;
+#elif PACER_CROSSINGS_NEON
+  return pacer::CrossingsKernel::kNeon;
+#else
+  return pacer::CrossingsKernel::kScalar;
+#endif
+}
+
+} // namespace
+
+bool pacer::HasCrossingsKernel(CrossingsKernel kernel) {
+  return kernel == CrossingsKernel::kScalar || kernel == BestKernel();
+}
+
+void pacer::FindCrossings(const SegmentBatch &batch, size_t begin, size_t end,
+                          Point fst, Point snd, std::vector<SegmentHit> *out) {
+  FindCrossings(BestKernel(), batch, begin, end, fst, snd, out);
+}
+
+void pacer::FindCrossings(CrossingsKernel kernel, const SegmentBatch &batch,
+                          size_t begin, size_t end, Point fst, Point snd,
+                          std::vector<SegmentHit> *out) {
+  switch (HasCrossingsKernel(kernel) ? kernel : CrossingsKernel::kScalar) {
+#if PACER_CROSSINGS_AVX2
+  case CrossingsKernel::kAvx2:
+    return FindCrossingsAvx2(batch, begin, end, fst, snd, out);
+#elif PACER_CROSSINGS_NEON
+  case CrossingsKernel::kNeon:
+    return FindCrossingsNeon(batch, begin, end, fst, snd, out);
+#endif
+  default:
+    return FindCrossingsScalar(batch, begin, end, fst, snd, out);
+  }
+}
+
+void pacer::FindCrossings(const BasicSegmentBatch<float> &batch, size_t begin,
+                          size_t end, PointF fst, PointF snd,
+                          std::vector<BasicSegmentHit<float>> *out) {
+  FindCrossingsScalar(batch, begin, end, fst, snd, out);
+}
+
+size_t pacer::FindFirstCrossing(const Segment &gate, const double *x,
+                                const double *y, size_t begin, size_t end,
+                                double *ratio) {
+  return FindFirstCrossing(BestKernel(), gate, x, y, begin, end, ratio);
+}
+
+size_t pacer::FindFirstCrossing(CrossingsKernel kernel, const Segment &gate,
+                                const double *x, const double *y,
+                                size_t begin, size_t end, double *ratio) {
+  Point n = (gate.second - gate.first).Rot();
+  switch (HasCrossingsKernel(kernel) ? kernel : CrossingsKernel::kScalar) {
+#if PACER_CROSSINGS_AVX2
+  case CrossingsKernel::kAvx2:
+    return FindFirstCrossingAvx2(gate, n.x, n.y, x, y, begin, end, ratio);
+#elif PACER_CROSSINGS_NEON
+  case CrossingsKernel::kNeon:
+    return FindFirstCrossingNeon(gate, n.x, n.y, x, y, begin, end, ratio);
+#endif
+  default:
+    return FindFirstCrossingScalar(gate, n.x, n.y, x, y, begin, end, ratio);
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <pacer/geometry/geometry.hpp>
+
+namespace pacer {
+
+// Segments (gates, timing lines) in structure-of-arrays form, with each
+// segment's normal precomputed, for the batch crossing kernels below.
+template <typename T> struct BasicSegmentBatch {
+  std::vector<T> ax, ay; ///< first endpoints
+  std::vector<T> bx, by; ///< second endpoints
+  std::vector<T> nx, ny; ///< (second - first).Rot()
+
+  BasicSegmentBatch() = default;
+  explicit BasicSegmentBatch(const std::vector<BasicSegment<T>> &segments);
+
+  size_t size() const { return ax.size(); }
+  bool empty() const { return ax.empty(); }
+  BasicSegment<T> operator[](size_t i) const {
+    return BasicSegment<T>{{ax[i], ay[i]}, {bx[i], by[i]}};
+  }
+  void push_back(const BasicSegment<T> &s);
+};
+
+using SegmentBatch = BasicSegmentBatch<double>;
+
+extern template struct BasicSegmentBatch<double>;
+extern template struct BasicSegmentBatch<float>;
+
+template <typename T> struct BasicSegmentHit {
+  uint32_t index;
+  /// As in Segment::Intersects: fst * (1 - ratio) + snd * ratio lies on the
+  /// crossed segment.
+  T ratio;
+};
+
+using SegmentHit = BasicSegmentHit<double>;
+
+// Both kernels evaluate exactly Segment::Intersects() (same operations in the
+// same order, strict rejection of touching/parallel cases), four or two lanes
+// at a time: AVX2 on x86-64 when the CPU has it (picked at runtime), NEON on
+// AArch64, plain scalar code elsewhere (e.g. the ESP32).
+
+/// Instruction sets the kernels come in. The calls below without a kernel
+/// run the fastest one available.
+enum class CrossingsKernel { kScalar, kAvx2, kNeon };
+
+/// Whether `kernel` is compiled in and supported by this CPU. kScalar
+/// always is.
+bool HasCrossingsKernel(CrossingsKernel kernel);
+
+/// Trajectory segment fst -> snd against segments [begin, end) of `batch`:
+/// appends every crossed one to `out`, in index order.
+void FindCrossings(const SegmentBatch &batch, size_t begin, size_t end,
+                   Point fst, Point snd, std::vector<SegmentHit> *out);
+
+/// Single precision, for the targets that lack a double FPU; scalar only.
+void FindCrossings(const BasicSegmentBatch<float> &batch, size_t begin,
+                   size_t end, PointF fst, PointF snd,
+                   std::vector<BasicSegmentHit<float>> *out);
+
+/// As above, on `kernel` (scalar when it isn't available), e.g. to check the
+/// vector kernels against the scalar one.
+void FindCrossings(CrossingsKernel kernel, const SegmentBatch &batch,
+                   size_t begin, size_t end, Point fst, Point snd,
+                   std::vector<SegmentHit> *out);
+
+/// One gate against a polyline given as x/y columns: tests the segments
+/// (x[i - 1], y[i - 1]) -> (x[i], y[i]) for i in [begin, end), begin >= 1.
+/// Returns the first i that crosses `gate` (and its ratio), or `end`.
+size_t FindFirstCrossing(const Segment &gate, const double *x,
+                         const double *y, size_t begin, size_t end,
+                         double *ratio);
+
+size_t FindFirstCrossing(CrossingsKernel kernel, const Segment &gate,
+                         const double *x, const double *y, size_t begin,
+                         size_t end, double *ratio);
+
+} // namespace pacer
@@ -0,0 +1,189 @@
+#include "gate-index.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+template <typename T>
+pacer::BasicGateIndex<T>::BasicGateIndex(std::vector<BasicSegment<T>> gates,
+                                         T cell_size)
+    : gates_(gates) {
+  if (gates.empty()) {
+    return;
+  }
+
+  BasicPoint<T> max = min_ = gates[0].first;
+  for (const BasicSegment<T> &g : gates) {
+    for (BasicPoint<T> p : {g.first, g.second}) {
+      min_.x = std::min(min_.x, p.x);
+      min_.y = std::min(min_.y, p.y);
+      max.x = std::max(max.x, p.x);
+      max.y = std::max(max.y, p.y);
+    }
+  }
+
+  T width = max.x - min_.x, height = max.y - min_.y;
+  cell_size_ = std::max({cell_size, T(1e-3),
+                         std::sqrt(width * height / T(kMaxCells))});
+  // Rounding up each axis can still overshoot the cap on thin tracks.
+  while (true) {
+    cols_ = static_cast<size_t>(width / cell_size_) + 1;
+    rows_ = static_cast<size_t>(height / cell_size_) + 1;
+    if (cols_ * rows_ <= kMaxCells) {
+      break;
+    }
+    cell_size_ *= T(1.1);
+  }
+
+  // Two passes over the gates: count runs per cell, then fill. Gates are
+  // visited in order, so gate i extends a cell's run iff gate i - 1 was the
+  // last one added to that cell.
+  size_t cells = cols_ * rows_;
+  constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> last(cells, kNone);
+  auto for_each_cell = [&](auto visit) {
+    std::fill(last.begin(), last.end(), kNone);
+    for (size_t i = 0; i < gates.size(); ++i) {
+      size_t x0, y0, x1, y1;
+      CellRange(gates[i].first, gates[i].second, &x0, &y0, &x1, &y1);
+      for (size_t y = y0; y <= y1; ++y) {
+        for (size_t x = x0; x <= x1; ++x) {
+          size_t c = y * cols_ + x;
+          uint32_t gate = static_cast<uint32_t>(i);
+          visit(c, gate, last[c] != kNone && last[c] + 1 == gate);
+          last[c] = gate;
+        }
+      }
+    }
+  };
+
+  cell_start_.assign(cells + 1, 0);
+  for_each_cell([&](size_t c, uint32_t, bool extends) {
+    if (!extends) {
+      ++cell_start_[c + 1];
+    }
+  });
+  for (size_t c = 0; c < cells; ++c) {
+    cell_start_[c + 1] += cell_start_[c];
+  }
+
+  cell_runs_.resize(cell_start_.back());
+  std::vector<uint32_t> fill(cell_start_.begin(), cell_start_.end() - 1);
+  for_each_cell([&](size_t c, uint32_t gate, bool extends) {
+    if (extends) {
+      cell_runs_[fill[c] - 1].end = gate + 1;
+    } else {
+      cell_runs_[fill[c]++] = Run{.first = gate, .end = gate + 1};
+    }
+  });
+}
+
+template <typename T>
+void pacer::BasicGateIndex<T>::CellRange(BasicPoint<T> a, BasicPoint<T> b,
+                                         size_t *x0, size_t *y0, size_t *x1,
+                                         size_t *y1) const {
+  auto cell = [&](T v, T origin, size_t count) -> size_t {
+    T c = std::floor((v - origin) / cell_size_);
+    if (!(c > 0)) { // also catches NaN
+      return 0;
+    }
+    return std::min(count - 1, static_cast<size_t>(c));
+  };
+  *x0 = cell(std::min(a.x, b.x), min_.x, cols_);
+  *x1 = cell(std::max(a.x, b.x), min_.x, cols_);
+  *y0 = cell(std::min(a.y, b.y), min_.y, rows_);
+  *y1 = cell(std::max(a.y, b.y), min_.y, rows_);
+}
+
+template <typename T>
+std::optional<size_t> pacer::BasicGateIndex<T>::Nearest(BasicPoint<T> p) const {
+  if (gates_.empty()) {
+    return std::nullopt;
+  }
+
+  size_t cx, cy, unused_x, unused_y;
+  CellRange(p, p, &cx, &cy, &unused_x, &unused_y);
+
+  size_t best = 0;
+  T best_dist = std::numeric_limits<T>::infinity();
+  auto visit = [&](long x, long y) {
+    size_t c = static_cast<size_t>(y) * cols_ + static_cast<size_t>(x);
+    for (uint32_t k = cell_start_[c]; k < cell_start_[c + 1]; ++k) {
+      for (size_t gate = cell_runs_[k].first; gate < cell_runs_[k].end;
+           ++gate) {
+        T dist = DistanceToSegment(gates_[gate], p);
+        if (dist < best_dist || (dist == best_dist && gate < best)) {
+          best_dist = dist;
+          best = gate;
+        }
+      }
+    }
+  };
+
+  // Rings of cells at growing Chebyshev distance r from p's (clamped) cell.
+  // Every point of a gate lies in some cell it is registered in, and every
+  // point of a ring-r cell is more than (r - 1) cells away from p, so once
+  // the best distance fits within r cells no farther ring can beat it.
+  size_t max_ring = std::max(cols_, rows_);
+  for (size_t r = 0; r <= max_ring; ++r) {
+    long lo_x = static_cast<long>(cx) - static_cast<long>(r);
+    long hi_x = static_cast<long>(cx + r);
+    long lo_y = static_cast<long>(cy) - static_cast<long>(r);
+    long hi_y = static_cast<long>(cy + r);
+    long last_x = static_cast<long>(cols_) - 1;
+    long last_y = static_cast<long>(rows_) - 1;
+    for (long y = std::max(lo_y, 0L); y <= std::min(hi_y, last_y); ++y) {
+      if (y == lo_y || y == hi_y) {
+        for (long x = std::max(lo_x, 0L); x <= std::min(hi_x, last_x); ++x) {
+          visit(x, y);
+        }
+        continue;
+      }
+      if (lo_x >= 0) {
+        visit(lo_x, y);
+      }
+      if (hi_x <= last_x) {
+        visit(hi_x, y);
+      }
+    }
+    if (best_dist <= static_cast<T>(r) * cell_size_) {
+      break;
+    }
+  }
+  return best;
+}
+
+template <typename T>
+void pacer::BasicGateIndex<T>::Crossings(BasicPoint<T> fst, BasicPoint<T> snd,
+                                         std::vector<Crossing> *out) const {
+  out->clear();
+  if (gates_.empty()) {
+    return;
+  }
+
+  size_t x0, y0, x1, y1;
+  CellRange(fst, snd, &x0, &y0, &x1, &y1);
+  for (size_t y = y0; y <= y1; ++y) {
+    for (size_t x = x0; x <= x1; ++x) {
+      size_t c = y * cols_ + x;
+      for (uint32_t k = cell_start_[c]; k < cell_start_[c + 1]; ++k) {
+        FindCrossings(gates_, cell_runs_[k].first, cell_runs_[k].end, fst,
+                      snd, out);
+      }
+    }
+  }
+
+  // A gate spanning several visited cells is reported once per cell.
+  std::sort(out->begin(), out->end(),
+            [](const Crossing &a, const Crossing &b) {
+              return a.index < b.index;
+            });
+  out->erase(std::unique(out->begin(), out->end(),
+                         [](const Crossing &a, const Crossing &b) {
+                           return a.index == b.index;
+                         }),
+             out->end());
+}
+
+template class pacer::BasicGateIndex<double>;
+template class pacer::BasicGateIndex<float>;
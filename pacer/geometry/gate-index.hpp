@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <pacer/geometry/crossings.hpp>
+#include <pacer/geometry/geometry.hpp>
+
+namespace pacer {
+
+// Uniform grid over the bounding boxes of a gate sequence (typically
+// ReferenceTrack::DensifiedGates(), ~1 gate per meter) in one local metric
+// frame. Each cell lists the gates whose bounding box overlaps it, so a
+// nearest-gate or crossing query only looks at the handful of gates around
+// the query instead of the whole track. Consecutive gates are neighbours on
+// track, so a cell stores them as runs of gate indices and crossings are
+// tested a run at a time with FindCrossings().
+//
+// The grid resolution is capped (see kMaxCells), so the index stays a few
+// tens of KB even for a long circuit and fits next to the timing state on
+// the ESP32.
+template <typename T> class BasicGateIndex {
+public:
+  /// `index` is the gate crossed.
+  using Crossing = BasicSegmentHit<T>;
+
+  BasicGateIndex() = default;
+
+  /// Builds the grid over `gates`; `cell_size` (meters) is a lower bound,
+  /// raised as needed to respect kMaxCells.
+  explicit BasicGateIndex(std::vector<BasicSegment<T>> gates,
+                          T cell_size = 5.0);
+
+  size_t size() const { return gates_.size(); }
+  bool empty() const { return gates_.empty(); }
+  BasicSegment<T> operator[](size_t gate) const { return gates_[gate]; }
+  const BasicSegmentBatch<T> &Batch() const { return gates_; }
+
+  /// Index of the gate segment closest to `p`; nullopt only when empty.
+  std::optional<size_t> Nearest(BasicPoint<T> p) const;
+
+  /// Every gate crossed by the trajectory segment fst -> snd, sorted by
+  /// gate index. Clears `out` first; reuse it across calls to avoid
+  /// allocating.
+  void Crossings(BasicPoint<T> fst, BasicPoint<T> snd,
+                 std::vector<Crossing> *out) const;
+
+  constexpr static size_t kMaxCells = 4096;
+
+private:
+  /// Cell range [lo, hi] (inclusive, clamped to the grid) covering the
+  /// bounding box of a and b.
+  void CellRange(BasicPoint<T> a, BasicPoint<T> b, size_t *x0, size_t *y0,
+                 size_t *x1, size_t *y1) const;
+
+  BasicSegmentBatch<T> gates_;
+
+  BasicPoint<T> min_;
+  T cell_size_ = 1.0;
+  size_t cols_ = 0, rows_ = 0;
+
+  /// Gates [first, end) overlapping one cell.
+  struct Run {
+    uint32_t first, end;
+  };
+
+  /// CSR layout: gates overlapping cell c are the runs
+  /// cell_runs_[cell_start_[c] .. cell_start_[c + 1]).
+  std::vector<uint32_t> cell_start_;
+  std::vector<Run> cell_runs_;
+};
+
+using GateIndex = BasicGateIndex<double>;
+
+extern template class BasicGateIndex<double>;
+extern template class BasicGateIndex<float>;
+
+} // namespace pacer
@@ -1,18 +1,21 @@
 #include "geometry.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 
 #include <pacer/datatypes/datatypes.hpp>
 
-bool pacer::Segment::Intersects(Point fst, Point snd, double *ratio) const {
-  Point n = (snd - fst).Rot();
+template <typename T>
+bool pacer::BasicSegment<T>::Intersects(BasicPoint<T> fst, BasicPoint<T> snd,
+                                        T *ratio) const {
+  BasicPoint<T> n = (snd - fst).Rot();
   if (n.Scalar(second - fst) * n.Scalar(first - fst) >= 0) {
     return false;
   }
 
-  Point norm = (second - first).Rot();
-  double d1 = norm.Scalar(snd - first), d2 = norm.Scalar(fst - first);
+  BasicPoint<T> norm = (second - first).Rot();
+  T d1 = norm.Scalar(snd - first), d2 = norm.Scalar(fst - first);
   if (d1 * d2 >= 0) {
     return false;
   }
@@ -131,14 +134,242 @@ pacer::CoordinateSystem::CoordinateSystem(GPSSample origin)
   assert(std::abs(Scalar(dx, dy)) < 1e-6);
   assert(std::abs(Scalar(dx, dz)) < 1e-6);
   assert(std::abs(Scalar(dy, dz)) < 1e-6);
+
+  double lat0 = origin.lat * M_PI / 180, lon0 = origin.lon * M_PI / 180;
+  sin_lat0 = std::sin(lat0);
+  cos_lat0 = std::cos(lat0);
+  sin_lon0 = std::sin(lon0);
+  cos_lon0 = std::cos(lon0);
+
+  // Derivatives of CanonicalLocal() at the origin; it is linear in altitude,
+  // so the expansion's error is third order in the angles.
+  double k = 1 + origin.altitude / R_equator;
+  Vec3f d_lon{-R_equator * cos_lat0 * sin_lon0,
+              R_equator * cos_lat0 * cos_lon0, 0};
+  Vec3f d_lat{-R_equator * sin_lat0 * cos_lon0,
+              -R_equator * sin_lat0 * sin_lon0, R_pole * cos_lat0};
+  Vec3f d_alt = local_origin / (k * R_equator);
+  Vec3f d_lon_lon{-R_equator * cos_lat0 * cos_lon0,
+                  -R_equator * cos_lat0 * sin_lon0, 0};
+  Vec3f d_lon_lat{R_equator * sin_lat0 * sin_lon0,
+                  -R_equator * sin_lat0 * cos_lon0, 0};
+  Vec3f d_lat_lat{-R_equator * cos_lat0 * cos_lon0,
+                  -R_equator * cos_lat0 * sin_lon0, -R_pole * sin_lat0};
+  const Vec3f terms[8] = {
+      d_lon * k,           d_lat * k,           d_alt,
+      d_lon_lon * (k / 2), d_lon_lat * k,       d_lat_lat * (k / 2),
+      d_lon / R_equator,   d_lat / R_equator,
+  };
+  for (int i = 0; i < 8; ++i) {
+    tangent[i] = Vec3f{Scalar(terms[i], dx), Scalar(terms[i], dy),
+                       Scalar(terms[i], dz)};
+  }
 }
 double pacer::CoordinateSystem::Distance(const GPSSample &from,
                                          const GPSSample &to) const {
   return std::sqrt((Local(from) - Local(to)).Norm());
 }
-bool pacer::Segment::operator==(const Segment &other) const {
+
+namespace {
+
+// Offsets from the origin (radians) up to which the batch kernels' series
+// are used; past it they fall back to the scalar path. At 0.05 rad the
+// truncated terms are below 1e-17 relative.
+constexpr double kSmallAngle = 0.05;
+
+// Taylor series for a small angle's sin and cos, and for atan of a small
+// ratio: plain multiply-adds, so the loops around them vectorize.
+inline double SmallSin(double d) {
+  double d2 = d * d;
+  return d * (1 - d2 / 6 * (1 - d2 / 20 * (1 - d2 / 42 * (1 - d2 / 72))));
+}
+inline double SmallCos(double d) {
+  double d2 = d * d;
+  return 1 - d2 / 2 *
+                 (1 - d2 / 12 * (1 - d2 / 30 * (1 - d2 / 56 * (1 - d2 / 90))));
+}
+inline double SmallAtan(double t) {
+  double t2 = t * t;
+  return t * (1 - t2 * (1. / 3 - t2 * (1. / 5 - t2 * (1. / 7 - t2 * (1. / 9 -
+                                    t2 * (1. / 11 - t2 / 13))))));
+}
+
+} // namespace
+
+void pacer::CoordinateSystem::LocalBatch(std::span<const GPSSample> points,
+                                         std::span<Vec3f> out,
+                                         Projection projection) const {
+  assert(out.size() == points.size());
+  constexpr double kRad = M_PI / 180;
+  size_t n = points.size();
+
+  if (projection == Projection::kTangentPlane) {
+    for (size_t i = 0; i < n; ++i) {
+      double dlon = (points[i].lon - origin.lon) * kRad;
+      double dlat = (points[i].lat - origin.lat) * kRad;
+      double dalt = points[i].altitude - origin.altitude;
+      out[i] = tangent[0] * dlon + tangent[1] * dlat + tangent[2] * dalt +
+               tangent[3] * (dlon * dlon) + tangent[4] * (dlon * dlat) +
+               tangent[5] * (dlat * dlat) + tangent[6] * (dalt * dlon) +
+               tangent[7] * (dalt * dlat);
+    }
+    return;
+  }
+
+  // sin/cos by angle addition onto the origin's, with the offset's from
+  // the series; same ellipsoid point as CanonicalLocal().
+  bool far = false;
+  for (size_t i = 0; i < n; ++i) {
+    double dlon = (points[i].lon - origin.lon) * kRad;
+    double dlat = (points[i].lat - origin.lat) * kRad;
+    far |= std::abs(dlon) > kSmallAngle || std::abs(dlat) > kSmallAngle;
+    double sin_dlat = SmallSin(dlat), cos_dlat = SmallCos(dlat);
+    double sin_dlon = SmallSin(dlon), cos_dlon = SmallCos(dlon);
+    double sin_lat = sin_lat0 * cos_dlat + cos_lat0 * sin_dlat;
+    double cos_lat = cos_lat0 * cos_dlat - sin_lat0 * sin_dlat;
+    double sin_lon = sin_lon0 * cos_dlon + cos_lon0 * sin_dlon;
+    double cos_lon = cos_lon0 * cos_dlon - sin_lon0 * sin_dlon;
+    double k = 1 + points[i].altitude / R_equator;
+    Vec3f p = Vec3f{R_equator * cos_lat * cos_lon,
+                    R_equator * cos_lat * sin_lon, R_pole * sin_lat} *
+                  k -
+              local_origin;
+    out[i] = Vec3f{Scalar(p, dx), Scalar(p, dy), Scalar(p, dz)};
+  }
+  if (far) {
+    for (size_t i = 0; i < n; ++i) {
+      if (std::abs(points[i].lon - origin.lon) * kRad > kSmallAngle ||
+          std::abs(points[i].lat - origin.lat) * kRad > kSmallAngle) {
+        out[i] = Local(points[i]);
+      }
+    }
+  }
+}
+
+void pacer::CoordinateSystem::GlobalBatch(std::span<const Vec3f> points,
+                                          std::span<GPSSample> out) const {
+  assert(out.size() == points.size());
+  size_t n = points.size();
+
+  // Global()'s atan2s, taken relative to the origin's latitude and
+  // longitude so their arguments are small ratios.
+  struct Ratios {
+    double t_lat, t_lon, a, b;
+    bool small;
+  };
+  auto ratios = [&](Vec3f q) {
+    Vec3f p = local_origin + dx * q[0] + dy * q[1] + dz * q[2];
+    double east = cos_lon0 * p[1] - sin_lon0 * p[0];
+    double meridian = cos_lon0 * p[0] + sin_lon0 * p[1];
+    double a = p[2] / R_pole;
+    double b = std::sqrt(p[0] * p[0] + p[1] * p[1]) / R_equator;
+    double north = a * cos_lat0 - b * sin_lat0;
+    double up = b * cos_lat0 + a * sin_lat0;
+    Ratios r{north / up, east / meridian, a, b, false};
+    r.small = meridian > 0 && up > 0 && std::abs(r.t_lon) <= kSmallAngle &&
+              std::abs(r.t_lat) <= kSmallAngle;
+    return r;
+  };
+
+  bool far = false;
+  for (size_t i = 0; i < n; ++i) {
+    Ratios r = ratios(points[i]);
+    far |= !r.small;
+    double lon = origin.lon + SmallAtan(r.t_lon) * 180 / M_PI;
+    // Global()'s range, for origins next to the antimeridian.
+    lon = lon > 180 ? lon - 360 : lon < -180 ? lon + 360 : lon;
+    out[i] = GPSSample{
+        .lat = origin.lat + SmallAtan(r.t_lat) * 180 / M_PI,
+        .lon = lon,
+        .altitude = (std::sqrt(r.a * r.a + r.b * r.b) - 1) * R_equator,
+        .full_speed = 0,
+        .ground_speed = 0,
+    };
+  }
+  if (far) {
+    for (size_t i = 0; i < n; ++i) {
+      if (!ratios(points[i]).small) {
+        out[i] = Global(points[i]);
+      }
+    }
+  }
+}
+
+void pacer::CoordinateSystem::CumulativeDistances(
+    std::span<const GPSSample> points, std::span<double> out,
+    Projection projection) const {
+  assert(out.size() == points.size());
+  constexpr size_t kChunk = 256;
+  Vec3f local[kChunk];
+  Vec3f prev;
+  double total = 0;
+  for (size_t begin = 0; begin < points.size(); begin += kChunk) {
+    size_t count = std::min(kChunk, points.size() - begin);
+    LocalBatch(points.subspan(begin, count), std::span(local, count),
+               projection);
+    for (size_t i = 0; i < count; ++i) {
+      if (begin + i > 0) {
+        total += std::sqrt((local[i] - prev).Norm());
+      }
+      out[begin + i] = total;
+      prev = local[i];
+    }
+  }
+}
+
+template <typename T>
+bool pacer::BasicSegment<T>::operator==(const BasicSegment &other) const {
   return (std::abs((first - other.first).x) < 1e-6) &&
          (std::abs((second - other.second).x) < 1e-6) &&
          (std::abs((first - other.first).y) < 1e-6) &&
          (std::abs((second - other.second).y) < 1e-6);
 }
+
+template struct pacer::BasicSegment<double>;
+template struct pacer::BasicSegment<float>;
+
+template <typename T>
+T pacer::DistanceToSegment(const BasicSegment<T> &s, BasicPoint<T> p, T *u) {
+  BasicPoint<T> dir = s.second - s.first;
+  T len2 = dir.Norm();
+  T t = len2 > 0 ? (p - s.first).Scalar(dir) / len2 : 0;
+  if (u != nullptr) {
+    *u = t;
+  }
+  t = std::fmin(T(1), std::fmax(T(0), t));
+  return std::sqrt((p - (s.first * (1 - t) + s.second * t)).Norm());
+}
+
+template double pacer::DistanceToSegment(const Segment &, Point, double *);
+template float pacer::DistanceToSegment(const SegmentF &, PointF, float *);
+
+template <typename T>
+pacer::BasicLinearFrame<T>::BasicLinearFrame(const CoordinateSystem &cs) {
+  GPSSample origin = cs.Global(Vec3f{0, 0, 0});
+  lat0 = origin.lat;
+  lon0 = origin.lon;
+
+  // Central differences of the exact frame; over +-1e-4 degrees (~10 m)
+  // the truncation error is far below the frame's own rounding.
+  constexpr double h = 1e-4;
+  auto local = [&](double dlon, double dlat) {
+    return cs.Local(GPSSample{.lat = lat0 + dlat, .lon = lon0 + dlon});
+  };
+  Vec3f d_lon = (local(h, 0) - local(-h, 0)) / (2 * h);
+  Vec3f d_lat = (local(0, h) - local(0, -h)) / (2 * h);
+  m[0][0] = static_cast<T>(d_lon[0]);
+  m[1][0] = static_cast<T>(d_lon[1]);
+  m[0][1] = static_cast<T>(d_lat[0]);
+  m[1][1] = static_cast<T>(d_lat[1]);
+}
+
+template <typename T>
+pacer::GPSSample pacer::BasicLinearFrame<T>::Global(BasicPoint<T> p) const {
+  double det = double(m[0][0]) * m[1][1] - double(m[0][1]) * m[1][0];
+  double dlon = (double(m[1][1]) * p.x - double(m[0][1]) * p.y) / det;
+  double dlat = (double(m[0][0]) * p.y - double(m[1][0]) * p.x) / det;
+  return GPSSample{.lat = lat0 + dlat, .lon = lon0 + dlon};
+}
+
+template struct pacer::BasicLinearFrame<double>;
+template struct pacer::BasicLinearFrame<float>;
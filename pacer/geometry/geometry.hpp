@@ -2,6 +2,7 @@
 
 #include <cstdlib>
 #include <optional>
+#include <span>
 #include <utility>
 
 #include <pacer/datatypes/datatypes.hpp>
@@ -9,22 +10,27 @@
 
 namespace pacer {
 
-struct Point : VectorOperators<Point, double, 2> {
-  double x = 0, y = 0;
+// 2D point over scalar T; see BasicVec3 for when T is float.
+template <typename T>
+struct BasicPoint : VectorOperators<BasicPoint<T>, T, 2> {
+  T x = 0, y = 0;
 
-  Point() = default;
-  Point(double x, double y) : x(x), y(y) {}
+  BasicPoint() = default;
+  BasicPoint(T x, T y) : x(x), y(y) {}
 
-  double operator[](size_t index) const { return index ? y : x; }
-  double &operator[](size_t index) { return index ? y : x; }
+  T operator[](size_t index) const { return index ? y : x; }
+  T &operator[](size_t index) { return index ? y : x; }
 
-  Point Rot() const { return Point{-(*this)[1], (*this)[0]}; }
+  BasicPoint Rot() const { return BasicPoint{-(*this)[1], (*this)[0]}; }
 
-  friend std::ostream &operator<<(std::ostream &os, const Point &p) {
+  friend std::ostream &operator<<(std::ostream &os, const BasicPoint &p) {
     return os << "(" << p.x << ", " << p.y << ")";
   }
 };
 
+using Point = BasicPoint<double>;
+using PointF = BasicPoint<float>;
+
 Point ToPoint(Point x);
 Point ToPoint(GPSSample s);
 Point ToPoint(Vec3f v);
@@ -35,14 +41,30 @@ Point ToPoint(Vec3f v);
 //                static_cast<const Concrete &>(x)[1]};
 // }
 
-struct Segment {
-  Point first, second;
+template <typename T> struct BasicSegment {
+  BasicPoint<T> first, second;
 
   // Returns true if segments intersects, if ratio is non-null, it will satisfy:
   //   fst * (1 - ratio) + snd  lies  on present segment.
-  bool Intersects(Point fst, Point snd, double *ratio) const;
+  bool Intersects(BasicPoint<T> fst, BasicPoint<T> snd, T *ratio) const;
+
+  bool operator==(const BasicSegment &other) const;
+};
+
+using Segment = BasicSegment<double>;
+using SegmentF = BasicSegment<float>;
+
+extern template struct BasicSegment<double>;
+extern template struct BasicSegment<float>;
 
-  bool operator==(const Segment &other) const;
+/// How CoordinateSystem's batch kernels project.
+enum class Projection {
+  /// Same ellipsoid math as Local(), to rounding.
+  kExact,
+  /// Second-order expansion of Local() in lat/lon/altitude around the
+  /// origin: a couple dozen multiply-adds per point and no trig. Within
+  /// 5 km and 100 m of altitude of the origin it is off by under a cm.
+  kTangentPlane,
 };
 
 struct CoordinateSystem {
@@ -80,6 +102,29 @@ struct CoordinateSystem {
 
   double Distance(const GPSSample &from, const GPSSample &to) const;
 
+  /// The sample this frame was built around.
+  GPSSample Origin() const { return origin; }
+
+  //-------------------------------- BATCH ----------------------------------//
+  // Whole-track versions of the above, for loops that project every point.
+  // The origin's trig is computed once per frame; per point, only sin/cos of
+  // its offset from the origin is, with short polynomials the compiler
+  // vectorizes (offsets past a few degrees fall back to Local()/Global()).
+
+  /// out[i] = Local(points[i]); `out` must be as long as `points`.
+  void LocalBatch(std::span<const GPSSample> points, std::span<Vec3f> out,
+                  Projection projection = Projection::kExact) const;
+
+  /// out[i] = Global(points[i]); `out` must be as long as `points`.
+  void GlobalBatch(std::span<const Vec3f> points,
+                   std::span<GPSSample> out) const;
+
+  /// out[0] = 0, out[i] = out[i - 1] + Distance(points[i - 1], points[i]);
+  /// `out` must be as long as `points`.
+  void CumulativeDistances(std::span<const GPSSample> points,
+                           std::span<double> out,
+                           Projection projection = Projection::kExact) const;
+
 private:
   constexpr static double R_equator = 6'378'000;
   constexpr static double R_pole = 6'357'000;
@@ -87,8 +132,60 @@ private:
 
   GPSSample origin;
   Vec3f local_origin, dx, dy, dz;
+
+  /// sin/cos of the origin's latitude and longitude.
+  double sin_lat0 = 0, cos_lat0 = 1, sin_lon0 = 0, cos_lon0 = 1;
+  /// Projection::kTangentPlane coefficients, in the local frame, of dlon,
+  /// dlat, dalt, dlon^2, dlon*dlat, dlat^2, dalt*dlon, dalt*dlat (radians,
+  /// meters).
+  Vec3f tangent[8];
+};
+
+// Equirectangular (linearized) approximation of a CoordinateSystem around its
+// origin: local x/y are an affine function of lon/lat, with the scale taken
+// from the exact frame's Jacobian at the origin. No trig per point — two
+// subtractions and a 2x2 multiply — and, being affine in lon/lat, segment
+// intersection ratios come out exactly as they do on raw lon/lat Points
+// (what pacer::Split() uses). Positions stay within ~0.1 m of the exact
+// frame 1 km from the origin and ~0.5 m at 2 km, growing with the square of
+// the distance, so a track-sized frame should center on the track.
+//
+// With T = float everything after the offset from the origin is single
+// precision: float resolves ~0.1 mm at 1 km, ample for a track-sized frame,
+// whereas raw float degrees would round positions to tens of centimeters.
+template <typename T> struct BasicLinearFrame {
+  BasicLinearFrame() = default;
+  explicit BasicLinearFrame(const CoordinateSystem &cs);
+
+  BasicPoint<T> Local(const GPSSample &s) const {
+    T dlon = static_cast<T>(s.lon - lon0), dlat = static_cast<T>(s.lat - lat0);
+    return BasicPoint<T>{m[0][0] * dlon + m[0][1] * dlat,
+                         m[1][0] * dlon + m[1][1] * dlat};
+  }
+
+  /// Inverse of Local(); altitude and speed are zero.
+  GPSSample Global(BasicPoint<T> p) const;
+
+  double lat0 = 0, lon0 = 0;
+  /// Meters per degree: {x, y} = m * {dlon, dlat}.
+  T m[2][2] = {{1, 0}, {0, 1}};
 };
 
+using LinearFrame = BasicLinearFrame<double>;
+
+extern template struct BasicLinearFrame<double>;
+extern template struct BasicLinearFrame<float>;
+
+/// Distance from `p` to segment `s`. If `u` is non-null it receives the
+/// unclamped projection parameter of `p` onto the line through `s` (0 at
+/// s.first, 1 at s.second), which keeps its meaning outside the segment.
+template <typename T>
+T DistanceToSegment(const BasicSegment<T> &s, BasicPoint<T> p,
+                    T *u = nullptr);
+
+extern template double DistanceToSegment(const Segment &, Point, double *);
+extern template float DistanceToSegment(const SegmentF &, PointF, float *);
+
 Point Interpolate(Point from, Point to, double ratio);
 GPSSample Interpolate(GPSSample from, GPSSample to, double ratio);
 
@@ -0,0 +1,116 @@
+#include "clock-model.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Running least-squares line through (sample, time) points, in coordinates
+// relative to the first one so the sums stay small.
+class LineFit {
+public:
+  LineFit(const pacer::ClockAnchor &first, double default_period_ms)
+      : x0_(first.sample), y0_(first.time_ms),
+        default_period_ms_(default_period_ms) {
+    Add(first);
+  }
+
+  void Add(const pacer::ClockAnchor &a) {
+    double x = static_cast<double>(a.sample - x0_), y = a.time_ms - y0_;
+    n_ += 1;
+    sx_ += x;
+    sy_ += y;
+    sxx_ += x * x;
+    sxy_ += x * y;
+  }
+
+  /// Period of the fit; the default until two distinct samples pin it.
+  double Period() const {
+    double det = n_ * sxx_ - sx_ * sx_;
+    if (det <= 0) {
+      return default_period_ms_;
+    }
+    return (n_ * sxy_ - sx_ * sy_) / det;
+  }
+
+  /// Fitted time of `sample`.
+  double TimeMs(size_t sample) const {
+    double period = Period();
+    double intercept = (sy_ - period * sx_) / n_;
+    return y0_ + intercept +
+           period * (static_cast<double>(sample) - static_cast<double>(x0_));
+  }
+
+  size_t Base() const { return x0_; }
+
+private:
+  size_t x0_;
+  double y0_, default_period_ms_;
+  double n_ = 0, sx_ = 0, sy_ = 0, sxx_ = 0, sxy_ = 0;
+};
+
+// Median rate between consecutive anchors: what a stretch with a single
+// anchor gets, and a sanity reference robust to the odd bad anchor.
+double MedianPeriod(std::span<const pacer::ClockAnchor> anchors) {
+  std::vector<double> periods;
+  for (size_t i = 1; i < anchors.size(); ++i) {
+    if (anchors[i].sample > anchors[i - 1].sample) {
+      double p = (anchors[i].time_ms - anchors[i - 1].time_ms) /
+                 static_cast<double>(anchors[i].sample - anchors[i - 1].sample);
+      if (p > 0) {
+        periods.push_back(p);
+      }
+    }
+  }
+  if (periods.empty()) {
+    return 0;
+  }
+  auto mid = periods.begin() + periods.size() / 2;
+  std::nth_element(periods.begin(), mid, periods.end());
+  return *mid;
+}
+
+} // namespace
+
+pacer::ClockModel pacer::ClockModel::Fit(std::span<const ClockAnchor> anchors,
+                                         double tolerance_ms) {
+  ClockModel model;
+  double default_period = MedianPeriod(anchors);
+  if (default_period <= 0) {
+    return model;
+  }
+
+  auto close = [&](const LineFit &fit) {
+    model.segments_.push_back(Segment{
+        .first_sample = fit.Base(),
+        .t0_ms = fit.TimeMs(fit.Base()),
+        .period_ms = fit.Period(),
+    });
+  };
+  auto off = [&](const LineFit &fit, const ClockAnchor &a) {
+    return std::abs(fit.TimeMs(a.sample) - a.time_ms) > tolerance_ms;
+  };
+
+  LineFit fit(anchors.front(), default_period);
+  for (size_t i = 1; i < anchors.size(); ++i) {
+    if (!off(fit, anchors[i])) {
+      fit.Add(anchors[i]);
+    } else if (i + 1 < anchors.size() && off(fit, anchors[i + 1])) {
+      // Two in a row off the line: the clock really jumped here.
+      close(fit);
+      fit = LineFit(anchors[i], default_period);
+    }
+    // Otherwise a lone bad anchor; the next one is back on the line.
+  }
+  close(fit);
+  return model;
+}
+
+double pacer::ClockModel::TimeMs(size_t sample) const {
+  auto it = std::upper_bound(
+      segments_.begin(), segments_.end(), sample,
+      [](size_t s, const Segment &seg) { return s < seg.first_sample; });
+  const Segment &seg = it == segments_.begin() ? segments_.front() : *(it - 1);
+  return seg.t0_ms + seg.period_ms * (static_cast<double>(sample) -
+                                      static_cast<double>(seg.first_sample));
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace pacer {
+
+/// A known time for one fix of a file's GPS stream: fix `sample` (index in
+/// file order) was taken at `time_ms`.
+struct ClockAnchor {
+  size_t sample = 0;
+  double time_ms = 0;
+};
+
+// Per-fix clock for a GPS stream whose fixes only come with a time per
+// batch, like GPS5 with one GPSU per payload. The receiver samples at a
+// fixed rate, so within a stretch of uninterrupted recording fix times are
+// a line in the fix index, least-squares fitted to every anchor of the
+// stretch at once. A single anchor is only good to its own jitter;
+// hundreds of them pin both the phase and the rate to well under a
+// millisecond.
+//
+// A stretch ends where the anchors jump off the line (the receiver lost
+// its fix, the camera dropped frames); the next one gets its own fit.
+class ClockModel {
+public:
+  // Fix n of the segment was taken at t0_ms + period_ms * (n - first_sample).
+  struct Segment {
+    size_t first_sample = 0; ///< fixes from here up to the next segment
+    double t0_ms = 0, period_ms = 0;
+  };
+
+  ClockModel() = default;
+
+  /// Fits anchors sorted by sample; empty if they don't pin down a rate
+  /// (fewer than two distinct samples). Anchors more than `tolerance_ms` off
+  /// the running fit start a new segment when the anchor after them agrees,
+  /// and are dropped as outliers when it doesn't.
+  static ClockModel Fit(std::span<const ClockAnchor> anchors,
+                        double tolerance_ms = 250);
+
+  bool empty() const { return segments_.empty(); }
+  const std::vector<Segment> &Segments() const { return segments_; }
+
+  /// Time of fix `sample`, extrapolated from the segment it falls in.
+  /// The model must not be empty.
+  double TimeMs(size_t sample) const;
+
+private:
+  std::vector<Segment> segments_;
+};
+
+} // namespace pacer
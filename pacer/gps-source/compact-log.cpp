@@ -0,0 +1,194 @@
+#include "compact-log.hpp"
+
+#include <cstring>
+
+namespace {
+
+constexpr uint8_t kMagic[4] = {'P', 'C', 'L', 'G'};
+constexpr uint16_t kVersion = 1;
+
+// Fields that move smoothly from fix to fix (clocks, position) are predicted
+// to repeat their last step; the rest to stay where they were.
+constexpr bool kLinear[pacer::CompactLogPredictor::kFields] = {
+    true, true, true, true, false, false, false, false, false, false};
+
+uint64_t ZigZag(int64_t v) {
+  return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+int64_t UnZigZag(uint64_t v) {
+  return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+// Wrapping arithmetic: corrupt input mustn't be undefined behavior, and the
+// encoder and decoder wrap alike.
+int64_t Add(int64_t a, int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) +
+                              static_cast<uint64_t>(b));
+}
+int64_t Sub(int64_t a, int64_t b) {
+  return static_cast<int64_t>(static_cast<uint64_t>(a) -
+                              static_cast<uint64_t>(b));
+}
+
+uint8_t *PutVarint(uint64_t v, uint8_t *out) {
+  while (v >= 0x80) {
+    *out++ = static_cast<uint8_t>(v) | 0x80;
+    v >>= 7;
+  }
+  *out++ = static_cast<uint8_t>(v);
+  return out;
+}
+
+bool GetVarint(const uint8_t **p, const uint8_t *end, uint64_t *v) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64 && *p < end; shift += 7) {
+    uint8_t b = *(*p)++;
+    result |= uint64_t{b & 0x7Fu} << shift;
+    if (!(b & 0x80)) {
+      *v = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+void PutU16(uint16_t v, uint8_t *out) {
+  out[0] = static_cast<uint8_t>(v);
+  out[1] = static_cast<uint8_t>(v >> 8);
+}
+uint16_t GetU16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+// The keyframe's fields that change what a fix means; a change forces a new
+// keyframe rather than going stale until the next one.
+bool SameFixState(const uGnssDecUbxNavPvt_t &a, const uGnssDecUbxNavPvt_t &b) {
+  return a.fixType == b.fixType && a.flags == b.flags &&
+         a.flags2 == b.flags2 && a.valid == b.valid;
+}
+
+// Writes the delta fields back over a copy of the keyframe.
+void SetValues(const int64_t v[pacer::CompactLogPredictor::kFields],
+               uGnssDecUbxNavPvt_t *pvt) {
+  using F = pacer::CompactLogField;
+  pvt->iTOW = static_cast<uint32_t>(v[size_t(F::kITOW)]);
+  pvt->lat = static_cast<int32_t>(v[size_t(F::kLat)]);
+  pvt->lon = static_cast<int32_t>(v[size_t(F::kLon)]);
+  pvt->height = static_cast<int32_t>(v[size_t(F::kHeight)]);
+  pvt->gSpeed = static_cast<int32_t>(v[size_t(F::kGSpeed)]);
+  pvt->velN = static_cast<int32_t>(v[size_t(F::kVelN)]);
+  pvt->velE = static_cast<int32_t>(v[size_t(F::kVelE)]);
+  pvt->velD = static_cast<int32_t>(v[size_t(F::kVelD)]);
+  pvt->headMot = static_cast<int32_t>(v[size_t(F::kHeadMot)]);
+}
+
+} // namespace
+
+void pacer::CompactLogValues(int64_t timestamp_ms,
+                             const uGnssDecUbxNavPvt_t &pvt,
+                             int64_t out[CompactLogPredictor::kFields]) {
+  using F = CompactLogField;
+  out[size_t(F::kTimestamp)] = timestamp_ms;
+  out[size_t(F::kITOW)] = pvt.iTOW;
+  out[size_t(F::kLat)] = pvt.lat;
+  out[size_t(F::kLon)] = pvt.lon;
+  out[size_t(F::kHeight)] = pvt.height;
+  out[size_t(F::kGSpeed)] = pvt.gSpeed;
+  out[size_t(F::kVelN)] = pvt.velN;
+  out[size_t(F::kVelE)] = pvt.velE;
+  out[size_t(F::kVelD)] = pvt.velD;
+  out[size_t(F::kHeadMot)] = pvt.headMot;
+}
+
+void pacer::CompactLogPredictor::Reset(int64_t timestamp_ms,
+                                       const uGnssDecUbxNavPvt_t &pvt) {
+  CompactLogValues(timestamp_ms, pvt, last_);
+  std::memset(delta_, 0, sizeof(delta_));
+}
+
+int64_t pacer::CompactLogPredictor::Predict(size_t f) const {
+  return kLinear[f] ? Add(last_[f], delta_[f]) : last_[f];
+}
+
+void pacer::CompactLogPredictor::Update(size_t f, int64_t value) {
+  delta_[f] = Sub(value, last_[f]);
+  last_[f] = value;
+}
+
+size_t pacer::CompactLogEncoder::Header(uint8_t *out) {
+  std::memcpy(out, kMagic, sizeof(kMagic));
+  PutU16(kVersion, out + 4);
+  PutU16(sizeof(uGnssDecUbxNavPvt_t), out + 6);
+  return kHeaderSize;
+}
+
+size_t pacer::CompactLogEncoder::Append(int64_t timestamp_ms,
+                                        const uGnssDecUbxNavPvt_t &pvt,
+                                        uint8_t *out) {
+  if (since_keyframe_ == 0 || since_keyframe_ >= keyframe_interval_ ||
+      !SameFixState(pvt, keyframe_)) {
+    out[0] = kKeyframe;
+    std::memcpy(out + 1, &timestamp_ms, sizeof(timestamp_ms));
+    std::memcpy(out + 1 + sizeof(timestamp_ms), &pvt, sizeof(pvt));
+    keyframe_ = pvt;
+    predictor_.Reset(timestamp_ms, pvt);
+    since_keyframe_ = 1;
+    return kMaxRecordSize;
+  }
+
+  int64_t values[CompactLogPredictor::kFields];
+  CompactLogValues(timestamp_ms, pvt, values);
+  uint8_t *p = out;
+  *p++ = kDelta;
+  for (size_t f = 0; f < CompactLogPredictor::kFields; ++f) {
+    p = PutVarint(ZigZag(Sub(values[f], predictor_.Predict(f))), p);
+    predictor_.Update(f, values[f]);
+  }
+  ++since_keyframe_;
+  return p - out;
+}
+
+bool pacer::CompactLogDecoder::IsCompactLog(std::span<const uint8_t> bytes) {
+  return bytes.size() >= CompactLogEncoder::kHeaderSize &&
+         std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) == 0 &&
+         GetU16(bytes.data() + 4) == kVersion &&
+         GetU16(bytes.data() + 6) == sizeof(uGnssDecUbxNavPvt_t);
+}
+
+bool pacer::CompactLogDecoder::Next(const uint8_t **p, const uint8_t *end,
+                                    int64_t *timestamp_ms,
+                                    uGnssDecUbxNavPvt_t *pvt) {
+  const uint8_t *q = *p;
+  uint8_t tag = *q++;
+  if (tag == CompactLogEncoder::kKeyframe) {
+    if (static_cast<size_t>(end - q) < CompactLogEncoder::kMaxRecordSize - 1) {
+      return false;
+    }
+    std::memcpy(timestamp_ms, q, sizeof(*timestamp_ms));
+    std::memcpy(&keyframe_, q + sizeof(*timestamp_ms), sizeof(keyframe_));
+    *pvt = keyframe_;
+    predictor_.Reset(*timestamp_ms, keyframe_);
+    have_keyframe_ = true;
+    *p = q + CompactLogEncoder::kMaxRecordSize - 1;
+    return true;
+  }
+  if (tag != CompactLogEncoder::kDelta || !have_keyframe_) {
+    return false;
+  }
+
+  int64_t values[CompactLogPredictor::kFields];
+  for (size_t f = 0; f < CompactLogPredictor::kFields; ++f) {
+    uint64_t residual;
+    if (!GetVarint(&q, end, &residual)) {
+      return false;
+    }
+    values[f] = Add(predictor_.Predict(f), UnZigZag(residual));
+  }
+  // Only now the record is known whole: a truncated one leaves no trace.
+  for (size_t f = 0; f < CompactLogPredictor::kFields; ++f) {
+    predictor_.Update(f, values[f]);
+  }
+  *timestamp_ms = values[size_t(CompactLogField::kTimestamp)];
+  *pvt = keyframe_;
+  SetValues(values, pvt);
+  *p = q;
+  return true;
+}
@@ -0,0 +1,130 @@
+#include "dat-file.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "ubx-parser.hpp"
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PACER_HAS_MMAP 1
+#else
+#define PACER_HAS_MMAP 0
+#endif
+
+pacer::MappedFile::MappedFile(const char *filename) {
+#if PACER_HAS_MMAP
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(std::string("Unable to open file: ") + filename);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error(std::string("Unable to stat file: ") + filename);
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  if (size_ > 0) {
+    void *p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      // Sessions are read front to back.
+      madvise(p, size_, MADV_SEQUENTIAL);
+      data_ = static_cast<const std::byte *>(p);
+      mapped_ = true;
+    }
+  }
+  close(fd);
+  if (mapped_ || size_ == 0) {
+    return;
+  }
+  // Some filesystems (FUSE, network mounts) refuse mmap; read instead.
+#endif
+
+  FILE *f = fopen(filename, "rb");
+  if (!f) {
+    throw std::runtime_error(std::string("Unable to open file: ") + filename);
+  }
+  fseek(f, 0, SEEK_END);
+  long end = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  size_ = end > 0 ? static_cast<size_t>(end) : 0;
+  buffer_ = std::make_unique<std::byte[]>(size_);
+  size_ = fread(buffer_.get(), 1, size_, f);
+  fclose(f);
+  data_ = buffer_.get();
+}
+
+pacer::MappedFile::~MappedFile() { Reset(); }
+
+pacer::MappedFile::MappedFile(MappedFile &&other) noexcept {
+  *this = std::move(other);
+}
+
+pacer::MappedFile &pacer::MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    Reset();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    mapped_ = std::exchange(other.mapped_, false);
+    buffer_ = std::move(other.buffer_);
+  }
+  return *this;
+}
+
+void pacer::MappedFile::Reset() {
+#if PACER_HAS_MMAP
+  if (mapped_) {
+    munmap(const_cast<std::byte *>(data_), size_);
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+  buffer_.reset();
+}
+
+pacer::DatFile::DatFile(const char *filename, DatVersion version)
+    : file_(filename), version_(version) {
+  prefix_ = version == DatVersion::WITH_TIMESTAMP ? sizeof(int64_t) : 0;
+  stride_ = prefix_ + sizeof(uGnssDecUbxNavPvt_t);
+
+  // Written records are never all zeros (a fix carries a time and position),
+  // and the unwritten tail is nothing but, so the boundary can be bisected
+  // without touching the whole preallocation.
+  auto zero = [&](size_t i) {
+    const std::byte *record = file_.data() + i * stride_;
+    return std::all_of(record, record + stride_,
+                       [](std::byte b) { return b == std::byte{0}; });
+  };
+  size_t lo = 0, hi = file_.size() / stride_;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (zero(mid)) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  size_ = lo;
+}
+
+int64_t pacer::DatFile::Timestamp(size_t i) const {
+  if (prefix_ == 0) {
+    return 0;
+  }
+  // Only 4-byte aligned at odd records (stride 100), so copy it out.
+  int64_t timestamp;
+  std::memcpy(&timestamp, file_.data() + i * stride_, sizeof(timestamp));
+  return timestamp;
+}
+
+pacer::GPSSample pacer::DatFile::Sample(size_t i) const {
+  return ToGPSSample(Pvt(i));
+}
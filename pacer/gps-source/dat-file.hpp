@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ranges>
+
+#include <pacer/datatypes/datatypes.hpp>
+#include <pacer/gps-source/gps-source.hpp>
+#include <pacer/gps-source/ubx-nav-pvt.hpp>
+
+namespace pacer {
+
+// Read-only view of a whole file's bytes. Memory-mapped where the platform
+// has mmap (pages are faulted in on first touch, so opening is O(1) no matter
+// the file size); elsewhere the file is read into one heap buffer. Either
+// way the bytes are suitably aligned for any fundamental type at offset 0.
+class MappedFile {
+public:
+  MappedFile() = default;
+
+  /// Throws std::runtime_error if the file can't be opened or mapped.
+  explicit MappedFile(const char *filename);
+  ~MappedFile();
+
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const std::byte *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  void Reset();
+
+  const std::byte *data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  std::unique_ptr<std::byte[]> buffer_; ///< read() fallback storage
+};
+
+// Random-access, zero-copy view of a .dat session log: fixed-size records of
+// an optional int64 timestamp (DatVersion::WITH_TIMESTAMP) followed by a raw
+// uGnssDecUbxNavPvt_t. Records are decoded only when touched, so opening a
+// multi-hour log costs a map() call, and the column views below let callers
+// walk e.g. only lat/lon without materializing GPSSample-s.
+//
+// A trailing partial record (the logger lost power mid-write) is ignored, and
+// so is a tail of all-zero records: the firmware preallocates its log in
+// zero-filled extents ahead of the data.
+class DatFile {
+public:
+  DatFile() = default;
+
+  /// Throws std::runtime_error if the file can't be opened.
+  explicit DatFile(const char *filename,
+                   DatVersion version = DatVersion::WITH_TIMESTAMP);
+
+  size_t size() const { return size_; }
+  bool empty() const { return size() == 0; }
+
+  DatVersion Version() const { return version_; }
+
+  /// Bytes per record: sizeof(uGnssDecUbxNavPvt_t), plus 8 with timestamps.
+  size_t Stride() const { return stride_; }
+
+  /// Start of the mapped records, for callers building strided views (e.g.
+  /// the Python bindings' numpy columns).
+  const std::byte *data() const { return file_.data(); }
+
+  /// Record `i`'s NAV-PVT payload, in place in the mapping. Both strides
+  /// are multiples of 4, so every payload keeps the struct's alignment.
+  const uGnssDecUbxNavPvt_t &Pvt(size_t i) const {
+    return *reinterpret_cast<const uGnssDecUbxNavPvt_t *>(
+        file_.data() + i * stride_ + prefix_);
+  }
+
+  /// Logger timestamp prefix of record `i` (milliseconds); 0 for
+  /// DatVersion::JUST_DATA files.
+  int64_t Timestamp(size_t i) const;
+
+  /// Record `i` decoded the way ReadDatFile() always has: timestamp_ms is
+  /// the receiver's iTOW, speeds are the 2D ground speed.
+  GPSSample Sample(size_t i) const;
+
+private:
+  template <class F> auto Column(F field) const {
+    return std::views::iota(size_t{0}, size()) |
+           std::views::transform(
+               [this, field](size_t i) { return field(Pvt(i)); });
+  }
+
+public:
+  /// Lazily decoded columns: random-access ranges of size() elements that
+  /// decode one field per access.
+  auto Lat() const {
+    return Column([](const uGnssDecUbxNavPvt_t &p) { return p.lat / 1e7; });
+  }
+  auto Lon() const {
+    return Column([](const uGnssDecUbxNavPvt_t &p) { return p.lon / 1e7; });
+  }
+  /// 2D ground speed, m/s.
+  auto Speed() const {
+    return Column(
+        [](const uGnssDecUbxNavPvt_t &p) { return p.gSpeed / 1000.0; });
+  }
+  /// iTOW, milliseconds.
+  auto TimeMs() const {
+    return Column(
+        [](const uGnssDecUbxNavPvt_t &p) { return int64_t{p.iTOW}; });
+  }
+  auto Samples() const {
+    return std::views::iota(size_t{0}, size()) |
+           std::views::transform([this](size_t i) { return Sample(i); });
+  }
+
+private:
+  MappedFile file_;
+  DatVersion version_ = DatVersion::WITH_TIMESTAMP;
+  size_t prefix_ = 0, stride_ = sizeof(uGnssDecUbxNavPvt_t);
+  size_t size_ = 0; ///< records before any zero tail
+};
+
+} // namespace pacer
@@ -0,0 +1,363 @@
+#include "gpmf-reader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "GPMF_common.h"
+#include "GPMF_parser.h"
+#include "demo/GPMF_mp4reader.h"
+
+namespace {
+
+union GPSUData {
+  struct {
+    char y[2], m[2], d[2], h[2], min[2], s[2], _, ms[3];
+  } str;
+  char data[16];
+
+  int64_t Timestamp() const {
+    int64_t y = 2000 + (str.y[0] - '0') * 10 + (str.y[1] - '0');
+    int64_t m = (str.m[0] - '0') * 10 + (str.m[1] - '0');
+    int64_t d = (str.d[0] - '0') * 10 + (str.d[1] - '0');
+    int64_t hour = (str.h[0] - '0') * 10 + (str.h[1] - '0');
+    int64_t minute = (str.min[0] - '0') * 10 + (str.min[1] - '0');
+    int64_t second = (str.s[0] - '0') * 10 + (str.s[1] - '0');
+    int64_t milliseconds =
+        (str.ms[0] - '0') * 100 + (str.ms[1] - '0') * 10 + (str.ms[2] - '0');
+
+    // https://howardhinnant.github.io/date_algorithms.html
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400); // [0, 399]
+    const unsigned doy =
+        (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;        // [0, 365]
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy; // [0, 146096]
+    int64_t days_since_1970 = era * 146097 + static_cast<int64_t>(doe) - 719468;
+
+    return days_since_1970 * 24 * 60 * 60 * 1000 +
+           1000 * (hour * 60 * 60 + minute * 60 + second) + milliseconds;
+  }
+};
+
+// GPS5 carries no per-fix clock: every fix of the batch gets the stream's
+// GPSU time, the last one if there are several (as the decoder always has).
+// 0 when there's none.
+int64_t GPSUTimestamp(GPMF_stream *ms) {
+  GPMF_stream gpsu_stream;
+  GPMF_CopyState(ms, &gpsu_stream);
+  if (GPMF_OK != GPMF_FindPrev(&gpsu_stream, STR2FOURCC("GPSU"),
+                               GPMF_LEVELS(GPMF_CURRENT_LEVEL |
+                                           GPMF_TOLERANT))) {
+    return 0;
+  }
+  // GPSU is a 16-byte ASCII "yymmddhhmmss.sss" per entry, concatenated,
+  // whether typed as one 'U' date per entry or as a char string.
+  const char *gpsu_data = static_cast<const char *>(GPMF_RawData(&gpsu_stream));
+  uint32_t gpsu_size =
+      GPMF_Repeat(&gpsu_stream) * GPMF_StructSize(&gpsu_stream);
+  if (gpsu_size < 16) {
+    return 0;
+  }
+  GPSUData t;
+  memcpy(t.data, gpsu_data + (gpsu_size / 16 - 1) * 16, 16);
+  return t.Timestamp();
+}
+
+// How the channels of a 3-axis IMU stream map onto the camera's X, Y and Z
+// axes, from the stream's ORIN: one letter per channel, lower case when the
+// channel points the opposite way (e.g. "ZXY" or "YxZ"). Without a valid
+// ORIN the channels are taken to be X, Y, Z already.
+struct ImuAxes {
+  int axis[3] = {0, 1, 2};
+  double sign[3] = {1, 1, 1};
+
+  void Apply(const double *v, double *xyz) const {
+    for (int c = 0; c < 3; ++c) {
+      xyz[axis[c]] = sign[c] * v[c];
+    }
+  }
+};
+
+ImuAxes ImuOrientation(GPMF_stream *ms) {
+  GPMF_stream orin_stream;
+  GPMF_CopyState(ms, &orin_stream);
+  if (GPMF_OK != GPMF_FindPrev(&orin_stream, STR2FOURCC("ORIN"),
+                               GPMF_LEVELS(GPMF_CURRENT_LEVEL |
+                                           GPMF_TOLERANT)) ||
+      GPMF_Repeat(&orin_stream) * GPMF_StructSize(&orin_stream) < 3) {
+    return {};
+  }
+  const char *orin = static_cast<const char *>(GPMF_RawData(&orin_stream));
+  ImuAxes axes;
+  bool seen[3] = {};
+  for (int c = 0; c < 3; ++c) {
+    char letter = orin[c];
+    bool negated = letter >= 'x' && letter <= 'z';
+    int axis = (negated ? letter - 'x' : letter - 'X');
+    if (axis < 0 || axis > 2 || seen[axis]) {
+      return {};
+    }
+    seen[axis] = true;
+    axes.axis[c] = axis;
+    axes.sign[c] = negated ? -1 : 1;
+  }
+  return axes;
+}
+
+// The stream's samples, scaled to doubles into `scratch` (grown as needed,
+// never shrunk). False if the stream can't be scaled.
+bool ScaledData(GPMF_stream *ms, uint32_t samples, uint32_t elements,
+                std::vector<double> *scratch) {
+  scratch->resize(std::max<size_t>(scratch->size(),
+                                   size_t{samples} * elements));
+  uint32_t buffersize = static_cast<uint32_t>(scratch->size() * sizeof(double));
+  return GPMF_OK == GPMF_ScaledData(ms, scratch->data(), buffersize, 0,
+                                    samples, GPMF_TYPE_DOUBLE);
+}
+
+} // namespace
+
+pacer::GPMFPayloadIndex::GPMFPayloadIndex(size_t mp4handle) {
+  uint32_t count = GetNumberPayloads(mp4handle);
+  start_.reserve(count);
+  end_.reserve(count);
+  double in, out;
+  for (uint32_t k = 0; k < count &&
+                       GetPayloadTime(mp4handle, k, &in, &out) == GPMF_OK &&
+                       in + 1e-9 < out;
+       ++k) {
+    start_.push_back(in);
+    end_.push_back(out);
+  }
+}
+
+size_t pacer::GPMFPayloadIndex::Find(double t) const {
+  if (empty() || t >= end_.back()) {
+    return size();
+  }
+  auto it = std::upper_bound(start_.begin(), start_.end(), t);
+  return it == start_.begin() ? 0 : (it - start_.begin()) - 1;
+}
+
+pacer::GPMFDecoder::~GPMFDecoder() { Release(); }
+
+pacer::GPMFDecoder::GPMFDecoder(GPMFDecoder &&other) noexcept
+    : mp4handle_(std::exchange(other.mp4handle_, 0)),
+      resource_(std::exchange(other.resource_, 0)),
+      decoded_(std::exchange(other.decoded_, kNone)),
+      decoded_status_(other.decoded_status_), imu_(other.imu_),
+      scratch_(std::move(other.scratch_)), samples_(std::move(other.samples_)),
+      accel_(std::move(other.accel_)), gyro_(std::move(other.gyro_)) {}
+
+pacer::GPMFDecoder &
+pacer::GPMFDecoder::operator=(GPMFDecoder &&other) noexcept {
+  if (this != &other) {
+    Release();
+    mp4handle_ = std::exchange(other.mp4handle_, 0);
+    resource_ = std::exchange(other.resource_, 0);
+    decoded_ = std::exchange(other.decoded_, kNone);
+    decoded_status_ = other.decoded_status_;
+    imu_ = other.imu_;
+    scratch_ = std::move(other.scratch_);
+    samples_ = std::move(other.samples_);
+    accel_ = std::move(other.accel_);
+    gyro_ = std::move(other.gyro_);
+  }
+  return *this;
+}
+
+void pacer::GPMFDecoder::Release() {
+  if (resource_) {
+    FreePayloadResource(mp4handle_, resource_);
+    resource_ = 0;
+  }
+  decoded_ = kNone;
+}
+
+void pacer::GPMFDecoder::SetImu(bool imu) {
+  if (imu != imu_) {
+    imu_ = imu;
+    decoded_ = kNone;
+  }
+}
+
+std::span<const pacer::GPMFSample>
+pacer::GPMFDecoder::Decode(size_t mp4handle, uint32_t index,
+                           uint32_t *status) {
+  uint32_t ignored;
+  uint32_t &ret = status ? *status : ignored;
+  if (mp4handle == mp4handle_ && index == decoded_) {
+    ret = decoded_status_;
+    return samples_;
+  }
+  decoded_ = kNone;
+
+  // The resource is a buffer GetPayloadResource() grows in place when handed
+  // back; it belongs to whichever file it was allocated for.
+  if (mp4handle != mp4handle_) {
+    Release();
+    mp4handle_ = mp4handle;
+  }
+  uint32_t payloadsize = GetPayloadSize(mp4handle, index);
+  resource_ = GetPayloadResource(mp4handle, resource_, payloadsize);
+  uint32_t *payload = GetPayload(mp4handle, resource_, index);
+  if (payload == nullptr) {
+    // No resource, or the read failed.
+    samples_.clear();
+    accel_.clear();
+    gyro_.clear();
+    ret = GPMF_ERROR_MEMORY;
+    return {};
+  }
+
+  ret = Walk(payload, payloadsize);
+  decoded_ = index;
+  decoded_status_ = ret;
+  return samples_;
+}
+
+std::span<const pacer::GPMFSample>
+pacer::GPMFDecoder::DecodePayload(uint32_t *payload, uint32_t size,
+                                  uint32_t *status) {
+  decoded_ = kNone;
+  uint32_t ret = Walk(payload, size);
+  if (status) {
+    *status = ret;
+  }
+  return samples_;
+}
+
+uint32_t pacer::GPMFDecoder::Walk(uint32_t *payload, uint32_t size) {
+  samples_.clear();
+  accel_.clear();
+  gyro_.clear();
+
+  GPMF_stream metadata_stream, *ms = &metadata_stream;
+  uint32_t ret = GPMF_Init(ms, payload, size);
+  if (ret != GPMF_OK) {
+    return ret;
+  }
+
+  while (GPMF_OK ==
+         GPMF_FindNext(ms, STR2FOURCC("STRM"),
+                       GPMF_LEVELS(GPMF_RECURSE_LEVELS | GPMF_TOLERANT))) {
+    ret = GPMF_SeekToSamples(ms);
+    if (ret != GPMF_OK) {
+      break;
+    }
+
+    uint32_t key = GPMF_Key(ms);
+    uint32_t samples = GPMF_Repeat(ms);
+    uint32_t elements = GPMF_ElementsInStruct(ms);
+    if (samples == 0 || GPMF_Type(ms) == GPMF_TYPE_STRING_ASCII) {
+      continue;
+    }
+    std::vector<GPMFImuSample> *imu = nullptr;
+    if (key == STR2FOURCC("ACCL")) {
+      imu = &accel_;
+    } else if (key == STR2FOURCC("GYRO")) {
+      imu = &gyro_;
+    }
+    bool gps9 = key == STR2FOURCC("GPS9");
+    if (imu) {
+      if (!imu_ || elements < 3 ||
+          !ScaledData(ms, samples, elements, &scratch_)) {
+        continue;
+      }
+      ImuAxes axes = ImuOrientation(ms);
+      for (uint32_t i = 0; i < samples; ++i) {
+        double xyz[3];
+        axes.Apply(scratch_.data() + size_t{i} * elements, xyz);
+        imu->push_back(GPMFImuSample{.x = xyz[0],
+                                     .y = xyz[1],
+                                     .z = xyz[2],
+                                     .index = i,
+                                     .count = samples});
+      }
+      continue;
+    }
+    if ((!gps9 && key != STR2FOURCC("GPS5")) || elements < (gps9 ? 7u : 5u)) {
+      continue;
+    }
+
+    int64_t timestamp = gps9 ? 0 : GPSUTimestamp(ms);
+    // SCAL is applied here; the SIUN/UNIT strings only name the units,
+    // which are fixed for GPS5/GPS9 (deg, deg, m, m/s, m/s, ...).
+    if (!ScaledData(ms, samples, elements, &scratch_)) {
+      continue;
+    }
+
+    for (uint32_t i = 0; i < samples; ++i) {
+      const double *v = scratch_.data() + size_t{i} * elements;
+      GPSSample gps{.lat = v[0], .lon = v[1], .altitude = v[2]};
+      if (gps9) {
+        // GPS9: lat, lon, alt, 2D speed, 3D speed, days since 2000, secs
+        // since midnight (ms precision), DOP, fix (0, 2D or 3D).
+        gps.ground_speed = v[3];
+        gps.full_speed = v[4];
+        constexpr int64_t epoch_2000 =
+            946684800000LL; // ms since epoch for 2000-01-01T00:00:00Z
+        gps.timestamp_ms = epoch_2000 + static_cast<int64_t>(
+                                            v[5] * 86400000.0 + v[6] * 1000.0);
+      } else {
+        // GPS5: lat, lon, alt, 2D speed, 3D speed, mapped in that order onto
+        // GPSSample's fields as this decoder always has.
+        gps.full_speed = v[3];
+        gps.ground_speed = v[4];
+        gps.timestamp_ms = timestamp;
+      }
+      samples_.push_back(GPMFSample{.gps = gps, .index = i, .count = samples});
+    }
+  }
+  return ret;
+}
+
+pacer::GPMFReader::GPMFReader(const char *filename, bool imu)
+    : mp4handle_(OpenMP4Source(const_cast<char *>(filename), MOV_GPMF_TRAK_TYPE,
+                               MOV_GPMF_TRAK_SUBTYPE, 0)) {
+  if (mp4handle_ == 0) {
+    throw std::runtime_error(std::string("Failed to open file: ") + filename);
+  }
+  index_ = GPMFPayloadIndex(mp4handle_);
+  decoder_.SetImu(imu);
+}
+
+pacer::GPMFReader::~GPMFReader() { Close(); }
+
+pacer::GPMFReader::GPMFReader(GPMFReader &&other) noexcept
+    : mp4handle_(std::exchange(other.mp4handle_, 0)),
+      index_(std::move(other.index_)), decoder_(std::move(other.decoder_)) {}
+
+pacer::GPMFReader &pacer::GPMFReader::operator=(GPMFReader &&other) noexcept {
+  if (this != &other) {
+    Close();
+    mp4handle_ = std::exchange(other.mp4handle_, 0);
+    index_ = std::move(other.index_);
+    decoder_ = std::move(other.decoder_);
+  }
+  return *this;
+}
+
+void pacer::GPMFReader::Close() {
+  // The payload resource goes before the source it was allocated for.
+  decoder_ = GPMFDecoder{};
+  if (mp4handle_) {
+    CloseSource(mp4handle_);
+    mp4handle_ = 0;
+  }
+}
+
+double pacer::GPMFReader::Duration() const { return GetDuration(mp4handle_); }
+
+void pacer::GPMFReader::Iterator::Advance(size_t k) {
+  pos_ = 0;
+  batch_ = {};
+  for (payload_ = k; payload_ < reader_->PayloadCount(); ++payload_) {
+    batch_ = reader_->Payload(payload_);
+    if (!batch_.empty()) {
+      break;
+    }
+  }
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <pacer/datatypes/datatypes.hpp>
+
+namespace pacer {
+
+/// A GPS fix decoded from a GPMF payload, with its place in the payload's
+/// batch (payload spans get spread over a batch by index).
+struct GPMFSample {
+  GPSSample gps;
+  uint32_t index = 0; ///< within its GPS stream's batch
+  uint32_t count = 0; ///< fixes in that batch
+};
+
+/// A 3-axis IMU reading (ACCL in m/s², GYRO in rad/s), with its place in the
+/// payload's batch like GPMFSample. The stream's ORIN puts the axes in the
+/// camera's frame whatever order the sensor writes them in: x across the
+/// camera (lateral when it faces forward), y vertical, z along the lens
+/// (longitudinal).
+struct GPMFImuSample {
+  double x = 0, y = 0, z = 0;
+  uint32_t index = 0;
+  uint32_t count = 0;
+};
+
+// Time spans of a file's payloads, read from the MP4 index once so seeking
+// is a binary search instead of a GetPayloadTime() walk. Covers the
+// payloads up to the first one without a time span, like GPMFSource::IsEnd().
+class GPMFPayloadIndex {
+public:
+  GPMFPayloadIndex() = default;
+  explicit GPMFPayloadIndex(size_t mp4handle);
+
+  size_t size() const { return start_.size(); }
+  bool empty() const { return start_.empty(); }
+
+  std::pair<double, double> Span(size_t k) const {
+    return {start_[k], end_[k]};
+  }
+
+  /// Payload covering time `t`: the last one starting at or before it (0
+  /// for anything before the first), or size() from the end of the last.
+  size_t Find(double t) const;
+
+private:
+  std::vector<double> start_, end_;
+};
+
+// Decodes the GPS5/GPS9 streams of one MP4 payload at a time, and with
+// SetImu(true) the ACCL and GYRO streams too, in the same walk over the
+// payload's GPMF. The payload resource, the scaled-data scratch and the
+// decoded samples are kept across calls and only ever grow, so walking a
+// whole file allocates a handful of times rather than per payload.
+class GPMFDecoder {
+public:
+  GPMFDecoder() = default;
+  ~GPMFDecoder();
+
+  GPMFDecoder(GPMFDecoder &&other) noexcept;
+  GPMFDecoder &operator=(GPMFDecoder &&other) noexcept;
+  GPMFDecoder(const GPMFDecoder &) = delete;
+  GPMFDecoder &operator=(const GPMFDecoder &) = delete;
+
+  /// Fixes of payload `index` of `mp4handle`, valid until the next call.
+  /// `status` (if non-null) gets the GPMF error that stopped the walk, or
+  /// GPMF_OK. Asking for the payload decoded last returns it again without
+  /// reading the file.
+  std::span<const GPMFSample> Decode(size_t mp4handle, uint32_t index,
+                                     uint32_t *status = nullptr);
+
+  /// Same as Decode(), for a raw GPMF payload the caller has read (e.g. from
+  /// another container, or built in a test). Nothing is cached.
+  std::span<const GPMFSample> DecodePayload(uint32_t *payload, uint32_t size,
+                                            uint32_t *status = nullptr);
+
+  /// Whether Decode() also extracts IMU streams (off by default: at ~200 Hz
+  /// they're most of the decoding work).
+  void SetImu(bool imu);
+
+  /// IMU readings of the payload decoded last; empty unless SetImu(true).
+  std::span<const GPMFImuSample> Accel() const { return accel_; }
+  std::span<const GPMFImuSample> Gyro() const { return gyro_; }
+
+private:
+  void Release();
+  /// Decodes `payload` into samples_, accel_ and gyro_; returns the GPMF
+  /// status.
+  uint32_t Walk(uint32_t *payload, uint32_t size);
+
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  size_t mp4handle_ = 0, resource_ = 0;
+  uint32_t decoded_ = kNone, decoded_status_ = 0; ///< what samples_ holds
+  bool imu_ = false;
+  std::vector<double> scratch_;
+  std::vector<GPMFSample> samples_;
+  std::vector<GPMFImuSample> accel_, gyro_;
+};
+
+// Pull-based reader over the GPS stream of a GPMF (.mp4 etc.) file: either
+// payload by payload (Payload()), or as one input range of every fix in file
+// order, decoded lazily as iteration reaches each payload:
+//
+//   GPMFReader reader("GX010001.MP4");
+//   for (const GPMFSample &s : reader) { ... }
+//
+// Decoded fixes live in the reader's buffers, so a reference is only valid
+// until the iteration (or a Payload() call) moves to another payload.
+class GPMFReader {
+public:
+  /// Throws std::runtime_error if the file can't be opened. With `imu`,
+  /// decoding a payload also extracts its ACCL/GYRO readings.
+  explicit GPMFReader(const char *filename, bool imu = false);
+  ~GPMFReader();
+
+  GPMFReader(GPMFReader &&other) noexcept;
+  GPMFReader &operator=(GPMFReader &&other) noexcept;
+  GPMFReader(const GPMFReader &) = delete;
+  GPMFReader &operator=(const GPMFReader &) = delete;
+
+  /// Payloads with a non-empty time span, the ones GPMFSource walks.
+  size_t PayloadCount() const { return index_.size(); }
+  std::pair<double, double> PayloadTimeSpan(size_t k) const {
+    return index_.Span(k);
+  }
+  const GPMFPayloadIndex &Index() const { return index_; }
+  double Duration() const;
+
+  /// Fixes of payload `k`, valid until the next decode.
+  std::span<const GPMFSample> Payload(size_t k) {
+    return decoder_.Decode(mp4handle_, static_cast<uint32_t>(k));
+  }
+  /// IMU readings of the payload decoded last (see the constructor).
+  std::span<const GPMFImuSample> Accel() const { return decoder_.Accel(); }
+  std::span<const GPMFImuSample> Gyro() const { return decoder_.Gyro(); }
+
+  class Iterator {
+  public:
+    using value_type = GPMFSample;
+    using difference_type = std::ptrdiff_t;
+
+    Iterator() = default;
+
+    const GPMFSample &operator*() const { return batch_[pos_]; }
+    const GPMFSample *operator->() const { return &batch_[pos_]; }
+
+    /// Payload the current fix came from.
+    size_t payload() const { return payload_; }
+
+    Iterator &operator++() {
+      if (++pos_ == batch_.size()) {
+        Advance(payload_ + 1);
+      }
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+
+    friend bool operator==(const Iterator &it, std::default_sentinel_t) {
+      return it.reader_ == nullptr ||
+             it.payload_ >= it.reader_->PayloadCount();
+    }
+
+  private:
+    friend class GPMFReader;
+
+    Iterator(GPMFReader *reader, size_t payload) : reader_(reader) {
+      Advance(payload);
+    }
+
+    /// Decodes from payload `k` on until one has fixes (or the file ends).
+    void Advance(size_t k);
+
+    GPMFReader *reader_ = nullptr;
+    size_t payload_ = 0, pos_ = 0;
+    std::span<const GPMFSample> batch_;
+  };
+
+  /// Every fix from payload 0 on. Single pass: the iterators share the
+  /// reader's buffers.
+  Iterator begin() { return Iterator(this, 0); }
+  std::default_sentinel_t end() const { return std::default_sentinel; }
+
+private:
+  void Close();
+
+  size_t mp4handle_ = 0;
+  GPMFPayloadIndex index_;
+  GPMFDecoder decoder_;
+};
+
+static_assert(std::input_iterator<GPMFReader::Iterator>);
+static_assert(std::ranges::input_range<GPMFReader>);
+
+} // namespace pacer
@@ -1,41 +1,17 @@
 #include "gps-source.hpp"
 
-#include "ubx-nav-pvt.hpp"
+#include "dat-file.hpp"
 
 void pacer::ReadDatFile(const char *filename, void *data,
                         void (*on_sample)(GPSSample sample, double time,
                                           void *data),
                         DatVersion version) {
-
-  FILE *f = fopen(filename, "rb");
-
-  int64_t timestamp;
-  uGnssDecUbxNavPvt_t gps;
-
-  while (!feof(f)) {
-    if (version == DatVersion::WITH_TIMESTAMP)
-      fread(&timestamp, sizeof(timestamp), 1, f);
-
-    fread(&gps, sizeof(gps), 1, f);
-
-    GPSSample s{
-        .lat = static_cast<double>(gps.lat) / 1e7,
-        .lon = static_cast<double>(gps.lon) / 1e7,
-        .altitude = gps.height / 1000.0,     // mm to m
-        .full_speed = gps.gSpeed / 1000.0,   // mm/s to m/s
-        .ground_speed = gps.gSpeed / 1000.0, // mm/s to m/s
-        .timestamp_ms = gps.iTOW,
-    };
-
-    if (on_sample) {
-      if (version == DatVersion::WITH_TIMESTAMP) {
-        on_sample(s, gps.iTOW / 1e3, data);
-      } else {
-        double timestamp = gps.iTOW / 1e3;
-        on_sample(s, timestamp, data);
-      }
-    }
+  DatFile file(filename, version);
+  if (!on_sample) {
+    return;
+  }
+  for (size_t i = 0; i < file.size(); ++i) {
+    GPSSample s = file.Sample(i);
+    on_sample(s, s.timestamp_ms / 1e3, data);
   }
-
-  fclose(f);
 }
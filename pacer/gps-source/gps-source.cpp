@@ -1,14 +1,27 @@
 #include "gps-source.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cmath>
 #include <cstdint>
 #include <fstream>
+#include <future>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <sys/types.h>
+#include <system_error>
+#include <thread>
 #include <vector>
 
+#include "clock-model.hpp"
+#include "compact-log.hpp"
+#include "dat-file.hpp"
+#include "session-cache.hpp"
+#include "ubx-parser.hpp"
+
 #include "GPMF_common.h"
 #include "GPMF_parser.h"
 #include "demo/GPMF_mp4reader.h"
@@ -23,46 +36,36 @@ GPMFSource::GPMFSource(const char *filename)
     throw std::runtime_error(
         (std::string("Failed to open file: ") + std::string(filename)).c_str());
   }
+  payloads_ = GPMFPayloadIndex(mp4handle_);
 }
 
 GPMFSource::~GPMFSource() noexcept {
+  decoder_ = GPMFDecoder{};
   if (mp4handle_) {
     CloseSource(mp4handle_);
   }
 }
 
-GPMFSource::GPMFSource(size_t mp4handle) : mp4handle_(mp4handle) {}
+GPMFSource::GPMFSource(size_t mp4handle)
+    : mp4handle_(mp4handle), payloads_(mp4handle) {}
 
 uint32_t GPMFSource::Seek(double target) {
-  double in, out;
-  uint32_t ret = GPMF_OK;
-  do {
-    ret = GetPayloadTime(mp4handle_, index_, &in, &out);
-    if (ret == GPMF_OK) {
-      if (out <= target)
-        ++index_;
-      if (target < in)
-        --index_;
-    }
-  } while (ret == GPMF_OK && in < out && ((target > out) || (target < in)));
-  if (!(in < out)) {
-    --index_;
+  index_ = static_cast<uint32_t>(payloads_.Find(target));
+  if (index_ == payloads_.size()) {
+    double in, out;
+    return GetPayloadTime(mp4handle_, index_, &in, &out);
   }
-
-  return ret;
+  return GPMF_OK;
 }
 
 void GPMFSource::Next() { ++index_; }
 
-bool GPMFSource::IsEnd() {
-  double in, out;
-  if (GetPayloadTime(mp4handle_, index_, &in, &out) != GPMF_OK) {
-    return true;
-  }
-  return in + 1e-9 >= out;
-}
+bool GPMFSource::IsEnd() { return index_ >= payloads_.size(); }
 
 std::pair<double, double> GPMFSource::CurrentTimeSpan() const {
+  if (index_ < payloads_.size()) {
+    return payloads_.Span(index_);
+  }
   double in, out;
   GetPayloadTime(mp4handle_, index_, &in, &out);
   return {in, out};
@@ -70,284 +73,82 @@ std::pair<double, double> GPMFSource::CurrentTimeSpan() const {
 
 double GPMFSource::GetTotalDuration() const { return GetDuration(mp4handle_); }
 
-union GPSUData {
-  struct {
-    char y[2], m[2], d[2], h[2], min[2], s[2], _, ms[3];
-  } str;
-  char data[16];
-
-  int64_t Timestamp() const {
-    int64_t y = 2000 + (str.y[0] - '0') * 10 + (str.y[1] - '0');
-    int64_t m = (str.m[0] - '0') * 10 + (str.m[1] - '0');
-    int64_t d = (str.d[0] - '0') * 10 + (str.d[1] - '0');
-    int64_t hour = (str.h[0] - '0') * 10 + (str.h[1] - '0');
-    int64_t minute = (str.min[0] - '0') * 10 + (str.min[1] - '0');
-    int64_t second = (str.s[0] - '0') * 10 + (str.s[1] - '0');
-    int64_t milliseconds =
-        (str.ms[0] - '0') * 100 + (str.ms[1] - '0') * 10 + (str.ms[2] - '0');
-
-    // https://howardhinnant.github.io/date_algorithms.html
-    y -= m <= 2;
-    const int64_t era = (y >= 0 ? y : y - 399) / 400;
-    const unsigned yoe = static_cast<unsigned>(y - era * 400); // [0, 399]
-    const unsigned doy =
-        (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;        // [0, 365]
-    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy; // [0, 146096]
-    int64_t days_since_1970 = era * 146097 + static_cast<int64_t>(doe) - 719468;
-
-    return days_since_1970 * 24 * 60 * 60 * 1000 +
-           1000 * (hour * 60 * 60 + minute * 60 + second) + milliseconds;
-  }
-};
-
 uint32_t GPMFSource::Samples(void *data,
                              void (*on_sample)(void * /*data*/,
                                                GPSSample /*sample*/,
                                                size_t /*current_index*/,
                                                size_t /*total_records*/)) {
-  uint32_t payloadsize = GetPayloadSize(mp4handle_, index_);
-  size_t payloadres = 0;
-  payloadres = GetPayloadResource(mp4handle_, payloadres, payloadsize);
-  uint32_t *payload = GetPayload(mp4handle_, payloadres, index_);
-
-  if (payload == nullptr) {
-    printf("No payload\n");
-    return 1;
-  }
-
-  GPMF_stream metadata_stream, *ms = &metadata_stream;
-  auto ret = GPMF_Init(ms, payload, payloadsize);
-  if (ret != GPMF_OK) {
-    printf("No init\n");
-    return ret;
+  uint32_t ret = GPMF_OK;
+  for (const GPMFSample &s : decoder_.Decode(mp4handle_, index_, &ret)) {
+    on_sample(data, s.gps, s.index, s.count);
   }
+  return ret;
+}
 
-  while (GPMF_OK ==
-         GPMF_FindNext(ms, STR2FOURCC("STRM"),
-                       GPMF_LEVELS(GPMF_RECURSE_LEVELS | GPMF_TOLERANT))) {
-
-    if (ret != GPMF_OK) {
-      printf("No FindNext gps data\n");
-      return ret;
-    }
-
-    ret = GPMF_SeekToSamples(ms);
-    if (ret != GPMF_OK) {
-      // printf("No Seek to Samples\n");
-      return ret;
-    }
-
-    char *rawdata = (char *)GPMF_RawData(ms);
-    uint32_t key = GPMF_Key(ms);
-    GPMF_SampleType type = GPMF_Type(ms);
-    uint32_t samples = GPMF_Repeat(ms);
-    uint32_t elements = GPMF_ElementsInStruct(ms);
-
-    // printf("Key: %c%c%c%c, Samples: %d, Elements: %d\n", PRINTF_4CC(key),
-    //        samples, elements);
-    // Extract GPSU data from GPS5 stream
-    // To do this, you need to search for the GPSU key at the same level as
-    // GPS5. Typically, GPSU contains a timestamp for each GPS5 sample. You can
-    // use GPMF_FindPrev or GPMF_FindNext to locate GPSU.
-
-    // Example: Find GPSU at the same level as GPS5
-    GPMF_stream gpsu_stream;
-
-    if (key == STR2FOURCC("GPS9")) {
-      // printf("Found GPS9 stream, skipping...\n");
-      // lat, long, alt, 2D speed, 3D speed, days since 2000, secs since
-      // midnight (ms precision), DOP, fix (0, 2D or 3D)
-      //  Parse GPS9 data: lat, long, alt, 2D speed, 3D speed, days since 2000,
-      //  secs since midnight (ms precision), DOP, fix
-      if (samples) {
-        uint32_t buffersize = samples * elements * sizeof(double);
-        double *tmpbuffer = (double *)malloc(buffersize);
-        if (tmpbuffer) {
-          if (GPMF_OK == GPMF_ScaledData(ms, tmpbuffer, buffersize, 0, samples,
-                                         GPMF_TYPE_DOUBLE)) {
-            for (uint32_t i = 0; i < samples; ++i) {
-              GPSSample gps{};
-              // GPS9: [lat, lon, alt, 2D speed, 3D speed, days since 2000, secs
-              // since midnight, DOP, fix]
-              gps.lat = tmpbuffer[i * elements + 0];
-              gps.lon = tmpbuffer[i * elements + 1];
-              gps.altitude = tmpbuffer[i * elements + 2];
-              gps.ground_speed = tmpbuffer[i * elements + 3];
-              gps.full_speed = tmpbuffer[i * elements + 4];
-              // Timestamp calculation from days since 2000 and seconds since
-              // midnight
-              double days_since_2000 = tmpbuffer[i * elements + 5];
-              double secs_since_midnight = tmpbuffer[i * elements + 6];
-              // Convert days since 2000-01-01 to ms since epoch
-              constexpr int64_t epoch_2000 =
-                  946684800000LL; // ms since epoch for 2000-01-01T00:00:00Z
-              int64_t ms_since_2000 = static_cast<int64_t>(
-                  days_since_2000 * 86400000.0 + secs_since_midnight * 1000.0);
-              gps.timestamp_ms = epoch_2000 + ms_since_2000;
-              // gps.dop = tmpbuffer[i * elements + 7];
-              // gps.fix = static_cast<int>(tmpbuffer[i * elements + 8]);
-              on_sample(data, gps, i, samples);
-            }
-          }
-          free(tmpbuffer);
-        }
-      }
-    }
-
-    if (key == STR2FOURCC("GPS5")) {
-      int64_t timestamp = 0;
-      std::vector<int64_t> gpsu_timestamps;
-      GPMF_CopyState(ms, &gpsu_stream);
-      if (GPMF_OK ==
-          GPMF_FindPrev(&gpsu_stream, STR2FOURCC("GPSU"),
-                        GPMF_LEVELS(GPMF_CURRENT_LEVEL | GPMF_TOLERANT))) {
-        char *gpsu_data = (char *)GPMF_RawData(&gpsu_stream);
-        uint32_t gpsu_size =
-            GPMF_Repeat(&gpsu_stream) * GPMF_ElementsInStruct(&gpsu_stream);
-
-        // GPSU is usually a 16-byte ASCII timestamp per sample, e.g.
-        // "2017-01-01 12:34:56.000" If there are multiple samples, gpsu_data
-        // contains concatenated timestamps.
-        for (uint32_t k = 0; k < gpsu_size; k += 16) {
-          GPSUData t;
-          memcpy(t.data, gpsu_data + k, 16);
-          gpsu_timestamps.push_back(t.Timestamp());
-        }
-        if (!gpsu_timestamps.empty()) {
-          timestamp = gpsu_timestamps.back();
-        }
-      }
-
-      if (samples) {
-        uint32_t buffersize = samples * elements * sizeof(double);
-        GPMF_stream find_stream;
-        double *ptr, *tmpbuffer = (double *)malloc(buffersize);
-
-#define MAX_UNITS 64
-#define MAX_UNITLEN 8
-        char units[MAX_UNITS][MAX_UNITLEN] = {""};
-        uint32_t unit_samples = 1;
-
-        char complextype[MAX_UNITS] = {""};
-        uint32_t type_samples = 1;
-
-        if (tmpbuffer) {
-          uint32_t i, j;
-
-          // Search for any units to display
-          GPMF_CopyState(ms, &find_stream);
-          if (GPMF_OK == GPMF_FindPrev(
-                             &find_stream, GPMF_KEY_SI_UNITS,
-                             GPMF_LEVELS(GPMF_CURRENT_LEVEL | GPMF_TOLERANT)) ||
-              GPMF_OK == GPMF_FindPrev(
-                             &find_stream, GPMF_KEY_UNITS,
-                             GPMF_LEVELS(GPMF_CURRENT_LEVEL | GPMF_TOLERANT))) {
-            char *data = (char *)GPMF_RawData(&find_stream);
-            uint32_t ssize = GPMF_StructSize(&find_stream);
-            if (ssize > MAX_UNITLEN - 1)
-              ssize = MAX_UNITLEN - 1;
-            unit_samples = GPMF_Repeat(&find_stream);
-
-            for (i = 0; i < unit_samples && i < MAX_UNITS; i++) {
-              memcpy(units[i], data, ssize);
-              units[i][ssize] = 0;
-              data += ssize;
-            }
-          }
-
-          // GPMF_FormattedData(ms, tmpbuffer, buffersize, 0, samples); //
-          // Output data in LittleEnd, but no scale
-          if (GPMF_OK ==
-              GPMF_ScaledData(ms, tmpbuffer, buffersize, 0, samples,
-                              GPMF_TYPE_DOUBLE)) // Output scaled data as floats
-          {
-            ptr = tmpbuffer;
-            int pos = 0;
-            union {
-              GPSSample gps;
-              double values[5];
-            } r = {};
-
-            for (i = 0; i < samples; i++) {
-              r.gps.timestamp_ms = timestamp;
-
-              // printf("  %c%c%c%c (%d,%d) ", PRINTF_4CC(key), samples,
-              // elements);
-
-              for (j = 0; j < elements; j++) {
-                if (type == GPMF_TYPE_STRING_ASCII) {
-                  // printf("%c", rawdata[pos]);
-                  pos++;
-                  ++ptr;
-                } else if (type_samples == 0) // no TYPE structure
-                {
-                  // printf("%.3f%s, ", *ptr, units[j % unit_samples]);
-                  ++ptr;
-                } else if (complextype[j] != 'F') {
-                  r.values[j % unit_samples] = *ptr;
-                  if ((j + 1) % unit_samples == 0) {
-                    on_sample(data, r.gps, i, samples);
-                  }
-
-                  // printf("%.3f%s, ", *ptr, units[j % unit_samples]);
-                  ++ptr;
-                  pos += GPMF_SizeofType((GPMF_SampleType)complextype[j]);
-                } else if (type_samples && complextype[j] == GPMF_TYPE_FOURCC) {
-                  ptr++;
-
-                  // printf("%c%c%c%c, ", rawdata[pos], rawdata[pos + 1],
-                  //        rawdata[pos + 2], rawdata[pos + 3]);
-                  pos += GPMF_SizeofType((GPMF_SampleType)complextype[j]);
-                }
-              }
-
-              // printf("\n");
-            }
-          }
-          free(tmpbuffer);
-        }
-      }
-    }
+ChainedGPSSource::ChainedGPSSource(std::vector<RawGPSSource *> sources)
+    : sources_(std::move(sources)) {
+  offsets_.reserve(sources_.size() + 1);
+  offsets_.push_back(0);
+  for (RawGPSSource *source : sources_) {
+    offsets_.push_back(offsets_.back() + source->GetTotalDuration());
   }
-
-  return ret;
 }
 
-uint32_t SequentialGPSSource::Samples(
+uint32_t ChainedGPSSource::Samples(
     void *data,
     void (*on_sample)(void * /*data*/, GPSSample /*sample*/,
                       size_t /*current_index*/, size_t /*total_records*/)) {
-  return current_->Samples(data, on_sample);
-}
-bool SequentialGPSSource::IsEnd() {
-  return current_ == right_ && current_->IsEnd();
+  if (sources_.empty()) {
+    return 0;
+  }
+  return sources_[current_]->Samples(data, on_sample);
 }
-double SequentialGPSSource::GetTotalDuration() const {
-  return left_->GetTotalDuration() + right_->GetTotalDuration();
+
+bool ChainedGPSSource::IsEnd() {
+  return sources_.empty() ||
+         (current_ + 1 == sources_.size() && sources_[current_]->IsEnd());
 }
-uint32_t SequentialGPSSource::Seek(double target) {
-  if (auto left_duration = left_->GetTotalDuration(); target < left_duration) {
-    if (current_ == right_)
-      right_->Seek(0);
-    return (current_ = left_)->Seek(target);
-  } else {
-    target -= left_->GetTotalDuration();
-    return (current_ = right_)->Seek(target);
+
+double ChainedGPSSource::GetTotalDuration() const { return offsets_.back(); }
+
+uint32_t ChainedGPSSource::Seek(double target) {
+  if (sources_.empty()) {
+    return 0;
   }
+  // Chapter k covers [offsets_[k], offsets_[k + 1]); anything past the end
+  // goes to the last one.
+  size_t k = std::upper_bound(offsets_.begin() + 1, offsets_.end() - 1,
+                              target) -
+             (offsets_.begin() + 1);
+  // Chapters entered later through Next() are rewound then, wherever they
+  // were left.
+  current_ = k;
+  uint32_t ret = sources_[k]->Seek(target - offsets_[k]);
+  // Landed exactly on a chapter's end: continue into the next one.
+  while (current_ + 1 < sources_.size() && sources_[current_]->IsEnd()) {
+    ret = sources_[++current_]->Seek(0);
+  }
+  return ret;
 }
-void SequentialGPSSource::Next() {
-  if (current_ == left_ && current_->IsEnd())
-    current_ = right_;
-  return current_->Next();
+
+void ChainedGPSSource::Next() {
+  if (sources_.empty()) {
+    return;
+  }
+  sources_[current_]->Next();
+  while (current_ + 1 < sources_.size() && sources_[current_]->IsEnd()) {
+    sources_[++current_]->Seek(0);
+  }
 }
-auto SequentialGPSSource::CurrentTimeSpan() const -> std::pair<double, double> {
-  auto [start, end] = current_->CurrentTimeSpan();
-  if (current_ == right_) {
-    auto left_len = left_->GetTotalDuration();
-    return {start + left_len, end + left_len};
+
+auto ChainedGPSSource::CurrentTimeSpan() const -> std::pair<double, double> {
+  if (sources_.empty()) {
+    return {0, 0};
   }
-  return {start, end};
+  auto [start, end] = sources_[current_]->CurrentTimeSpan();
+  return {start + offsets_[current_], end + offsets_[current_]};
 }
+
 uint32_t RawGPSSource::Samples(void *data,
                                void (*on_sample)(void * /*data*/,
                                                  GPSSample /*sample*/,
@@ -376,56 +177,235 @@ static bool HasExtension(const std::string &filename, const std::string &ext) {
   return lower_ext == ext;
 }
 
+// Whether payload samples [first, end) share one embedded timestamp, the way
+// GPS5 fixes all carry their payload's GPSU. GPS9 fixes are timed one by
+// one and never match; untimed samples (0) are left to the span clock.
+template <class Session>
+static bool SharesBatchTime(const Session &session, size_t first, size_t end) {
+  if (end - first < 2 || session.Sample(first).timestamp_ms == 0) {
+    return false;
+  }
+  for (size_t i = first + 1; i < end; ++i) {
+    if (session.Sample(i).timestamp_ms != session.Sample(first).timestamp_ms) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Replays a decoded GPMF file (GPMFSession or its SessionCache). Fixes that
+// share a per-payload timestamp get their own from a ClockModel fitted to
+// all of the file's payload timestamps, taken as the time of each payload's
+// first fix. Samples without an embedded clock get one synthesized from
+// their payload's span, shifted by `offset_s` so consecutive files stay
+// ordered.
+template <class Session>
+static void EmitGPMFSession(const Session &session, double offset_s,
+                            const std::function<void(GPSSample)> &on_sample) {
+  auto payload_end = [&](size_t k) {
+    return k + 1 < session.PayloadCount()
+               ? session.GetPayload(k + 1).first_sample
+               : session.size();
+  };
+
+  std::vector<char> batch_timed(session.PayloadCount());
+  std::vector<ClockAnchor> anchors;
+  for (size_t k = 0; k < session.PayloadCount(); ++k) {
+    size_t first = session.GetPayload(k).first_sample;
+    if (SharesBatchTime(session, first, payload_end(k))) {
+      batch_timed[k] = true;
+      anchors.push_back(ClockAnchor{
+          .sample = first,
+          .time_ms = static_cast<double>(session.Sample(first).timestamp_ms),
+      });
+    }
+  }
+  ClockModel clock = ClockModel::Fit(anchors);
+
+  for (size_t k = 0; k < session.PayloadCount(); ++k) {
+    GPMFSession::Payload payload = session.GetPayload(k);
+    size_t end = payload_end(k);
+    for (size_t i = payload.first_sample; i < end; ++i) {
+      GPSSample sample = session.Sample(i);
+      if (batch_timed[k] && !clock.empty()) {
+        sample.timestamp_ms = std::llround(clock.TimeMs(i));
+      } else if (sample.timestamp_ms == 0) {
+        double t = offset_s + payload.start_s + session.PayloadOffset(i);
+        sample.timestamp_ms = static_cast<int64_t>(t * 1000);
+      }
+      on_sample(sample);
+    }
+  }
+}
+
+namespace {
+
+// NAV-PVT fixes of a raw receiver capture (.ubx): the UART byte stream as
+// is, NMEA and other UBX messages included. Corrupt frames are skipped.
+std::vector<GPSSample> ReadUbxFile(const char *filename) {
+  MappedFile file(filename);
+  std::vector<GPSSample> fixes;
+  UbxParser parser;
+  parser.FeedNavPvt(
+      {reinterpret_cast<const uint8_t *>(file.data()), file.size()},
+      [&](const uGnssDecUbxNavPvt_t &pvt) {
+        fixes.push_back(ToGPSSample(pvt));
+      });
+  return fixes;
+}
+
+// Fixes of a compact session log (.pcl), converted like .dat records.
+std::vector<GPSSample> ReadCompactLogFile(const char *filename) {
+  MappedFile file(filename);
+  std::span<const uint8_t> bytes(
+      reinterpret_cast<const uint8_t *>(file.data()), file.size());
+  if (!CompactLogDecoder::IsCompactLog(bytes)) {
+    throw std::runtime_error("not a compact session log");
+  }
+  std::vector<GPSSample> fixes;
+  // Deltas run 15-20 bytes; over-reserving beats regrowing.
+  fixes.reserve(bytes.size() / 16);
+  CompactLogDecoder().Decode(
+      bytes, [&](int64_t, const uGnssDecUbxNavPvt_t &pvt) {
+        fixes.push_back(ToGPSSample(pvt));
+      });
+  return fixes;
+}
+
+// One input of LoadGPSFiles(), decoded but not yet replayed. Exactly one of
+// dat/fixes/cache/session is set unless the file was skipped or failed.
+struct LoadedFile {
+  bool skipped = false;
+  std::string error;
+  std::optional<DatFile> dat;
+  std::optional<std::vector<GPSSample>> fixes; ///< .ubx and .pcl
+  SessionCache cache;
+  std::optional<GPMFSession> session;
+};
+
+LoadedFile LoadFile(const std::string &filename) {
+  LoadedFile file;
+  if (filename.empty()) {
+    file.skipped = true;
+    return file;
+  }
+  try {
+    if (!std::ifstream(filename).is_open()) {
+      file.error = filename + ": not found";
+      return file;
+    }
+    if (HasExtension(filename, ".dat")) {
+      file.dat.emplace(filename.c_str(), DatVersion::WITH_TIMESTAMP);
+      return file;
+    }
+    if (HasExtension(filename, ".ubx")) {
+      file.fixes = ReadUbxFile(filename.c_str());
+      return file;
+    }
+    if (HasExtension(filename, ".pcl")) {
+      file.fixes = ReadCompactLogFile(filename.c_str());
+      return file;
+    }
+
+    // The sidecar cache spares re-walking every GPMF payload on each load;
+    // it's rebuilt whenever the source changes.
+    file.cache = SessionCache::Open(filename);
+    if (!file.cache.valid()) {
+      file.session = DecodeGPMFFile(filename.c_str());
+      SessionCache::Write(filename, *file.session);
+    }
+  } catch (const std::exception &e) {
+    file.error = filename + ": " + e.what();
+  }
+  return file;
+}
+
+} // namespace
+
 size_t LoadGPSFiles(const std::vector<std::string> &filenames,
                     const std::function<void(GPSSample)> &on_sample,
                     std::vector<std::string> *errors) {
+  // Files decode independently on a pool of workers, picked up in order;
+  // this thread replays each one as soon as it (and everything before it)
+  // is ready, so on_sample sees exactly the sequential order and clocks.
+  size_t n = filenames.size();
+  std::vector<std::promise<LoadedFile>> decoded(n);
+  std::vector<std::future<LoadedFile>> ready;
+  for (auto &promise : decoded) {
+    ready.push_back(promise.get_future());
+  }
+
+  // An exception escaping a worker would terminate; anything LoadFile()
+  // doesn't report as an error is handed to the replay loop instead, which
+  // rethrows it. `stop` is raised when the replay bails out, so the workers
+  // it then joins don't decode the remaining files first.
+  std::atomic<size_t> next{0};
+  std::atomic<bool> stop{false};
+  auto work = [&] {
+    for (size_t i; !stop.load(std::memory_order_relaxed) &&
+                   (i = next.fetch_add(1)) < n;) {
+      try {
+        decoded[i].set_value(LoadFile(filenames[i]));
+      } catch (...) {
+        decoded[i].set_exception(std::current_exception());
+      }
+    }
+  };
+
+  // Declared after the promises: on unwind the workers are joined first.
+  std::vector<std::jthread> workers;
+  size_t num_workers =
+      std::min<size_t>(n, std::max(1u, std::thread::hardware_concurrency()));
+  if (num_workers > 1) {
+    try {
+      for (size_t k = 0; k < num_workers; ++k) {
+        workers.emplace_back(work);
+      }
+    } catch (const std::system_error &) {
+      // No (more) threads on this platform; whoever started carries on.
+    }
+  }
+  if (workers.empty()) {
+    work();
+  }
+
   size_t loaded_files = 0;
   // Clock for files that predate timestamped samples: synthesized from the
   // MP4 chunk spans and chained across files so they stay ordered.
   double fallback_offset_s = 0.0;
 
-  for (const auto &filename : filenames) {
-    if (filename.empty())
-      continue;
-    if (!std::ifstream(filename).is_open()) {
-      if (errors)
-        errors->push_back(filename + ": not found");
+  struct StopOnUnwind {
+    std::atomic<bool> &stop;
+    ~StopOnUnwind() { stop = true; }
+  } stop_on_unwind{stop};
+
+  for (auto &future : ready) {
+    LoadedFile file = future.get();
+    if (file.skipped) {
       continue;
     }
-
-    if (HasExtension(filename, ".dat")) {
-      ReadDatFile(
-          filename.c_str(),
-          [&](GPSSample sample, double) { on_sample(sample); },
-          DatVersion::WITH_TIMESTAMP);
-      ++loaded_files;
+    if (!file.error.empty()) {
+      if (errors)
+        errors->push_back(file.error);
       continue;
     }
 
-    try {
-      GPMFSource source(filename.c_str());
-      source.Seek(0);
-      double file_duration_s = 0.0;
-      while (!source.IsEnd()) {
-        auto [start, end] = source.CurrentTimeSpan();
-        source.RawGPSSource::Samples(
-            [&](GPSSample sample, size_t current, size_t total) {
-              if (sample.timestamp_ms == 0) {
-                double t = fallback_offset_s + start +
-                           (total ? (end - start) * current / total : 0.0);
-                sample.timestamp_ms = static_cast<int64_t>(t * 1000);
-              }
-              on_sample(sample);
-            });
-        file_duration_s = std::max(file_duration_s, end);
-        source.Next();
+    if (file.dat) {
+      for (size_t i = 0; i < file.dat->size(); ++i) {
+        on_sample(file.dat->Sample(i));
       }
-      fallback_offset_s += file_duration_s;
-      ++loaded_files;
-    } catch (const std::exception &e) {
-      if (errors)
-        errors->push_back(filename + ": " + e.what());
+    } else if (file.fixes) {
+      for (const GPSSample &sample : *file.fixes) {
+        on_sample(sample);
+      }
+    } else if (file.cache.valid()) {
+      EmitGPMFSession(file.cache, fallback_offset_s, on_sample);
+      fallback_offset_s += file.cache.Duration();
+    } else {
+      EmitGPMFSession(*file.session, fallback_offset_s, on_sample);
+      fallback_offset_s += file.session->Duration();
     }
+    ++loaded_files;
   }
 
   return loaded_files;
@@ -11,6 +11,7 @@
 #include <vector>
 
 #include <pacer/datatypes/datatypes.hpp>
+#include <pacer/gps-source/gpmf-reader.hpp>
 
 namespace pacer {
 
@@ -68,11 +69,8 @@ public:
 
 // Handler for GPMF track inside MP4 container.
 //
-// Allows for traversing media file and getting GPS data out of it.
-//
-// TODO: Provide even more low-level access to underlying samples,
-//       might be useful to keep buffer for data in some sort of iterator
-//       with option to iterate over GPSSample-s on top of it.
+// Allows for traversing media file and getting GPS data out of it. See
+// GPMFReader for pulling samples without the callback.
 class GPMFSource : public RawGPSSource {
 public:
   explicit GPMFSource(size_t mp4handle);
@@ -94,7 +92,8 @@ public:
                                      size_t /*current_index*/,
                                      size_t /*total_records*/)) override;
 
-  // Seeks to data chunk covering target.
+  // Seeks to data chunk covering target: a binary search over the payload
+  // spans, indexed when the file is opened.
   uint32_t Seek(double target) override;
 
   // Proceeds to next piece of data.
@@ -112,14 +111,19 @@ public:
 private:
   uint32_t index_ = 0;
   size_t mp4handle_;
+  GPMFPayloadIndex payloads_;
+  GPMFDecoder decoder_;
 };
 
-class SequentialGPSSource : public RawGPSSource {
+// Several sources played back to back as one timeline, e.g. the chapters
+// of a GoPro recording. Chapter start offsets are prefix sums of the
+// durations taken once at construction (the sources don't grow), so
+// Seek() and CurrentTimeSpan() find their chapter by binary search rather
+// than walking a chain.
+class ChainedGPSSource : public RawGPSSource {
 public:
-  SequentialGPSSource(RawGPSSource *left, RawGPSSource *right)
-      : left_{left}, right_{right}, current_{left_} {}
-
-  virtual ~SequentialGPSSource() override = default;
+  // Sources are borrowed and must outlive the chain.
+  explicit ChainedGPSSource(std::vector<RawGPSSource *> sources);
 
   double GetTotalDuration() const override;
 
@@ -137,8 +141,22 @@ public:
   // Returns current samples' time span.
   std::pair<double, double> CurrentTimeSpan() const override;
 
+  size_t SourceCount() const { return sources_.size(); }
+
+  // Index of the chapter being played.
+  size_t CurrentSource() const { return current_; }
+
 private:
-  RawGPSSource *left_, *right_, *current_;
+  std::vector<RawGPSSource *> sources_;
+  std::vector<double> offsets_; ///< chapter starts, then the total duration
+  size_t current_ = 0;
+};
+
+// Two sources back to back; a ChainedGPSSource of both.
+class SequentialGPSSource : public ChainedGPSSource {
+public:
+  SequentialGPSSource(RawGPSSource *left, RawGPSSource *right)
+      : ChainedGPSSource({left, right}) {}
 };
 
 enum class DatVersion {
@@ -146,6 +164,9 @@ enum class DatVersion {
   WITH_TIMESTAMP = 1,
 };
 
+/// Streams every record of a .dat log to `on_sample` (see DatFile for
+/// random access without the callback). Throws std::runtime_error if the
+/// file can't be opened.
 void ReadDatFile(const char *filename, void *data,
                  void (*on_sample)(GPSSample sample, double time, void *data),
                  DatVersion version);
@@ -162,11 +183,17 @@ void ReadDatFile(const char *filename, F on_sample,
       version);
 }
 
-/// Loads GPS samples from a mix of .dat and GPMF (.mp4 etc.) files, in the
-/// given order. Samples that predate embedded timestamps get a clock
-/// synthesized from the MP4 chunk spans, chained across files so they stay
-/// ordered. Missing/unreadable files are reported through `errors` (if
-/// non-null). Returns the number of files samples were loaded from.
+/// Loads GPS samples from a mix of .dat, compact session logs (.pcl), raw
+/// UBX captures (.ubx) and GPMF (.mp4 etc.) files, in the given order.
+/// Samples that predate embedded timestamps get a clock synthesized from
+/// the MP4 chunk spans, chained across files so they stay ordered.
+/// Missing/unreadable files are reported through `errors` (if non-null).
+/// Returns the number of files samples were loaded from.
+///
+/// Files are decoded in parallel, but `on_sample` is only ever called from
+/// the calling thread, in file order. An exception from `on_sample` (or an
+/// unexpected one from a decoder) propagates to the caller; files not yet
+/// picked up by a worker are then not decoded.
 size_t LoadGPSFiles(const std::vector<std::string> &filenames,
                     const std::function<void(GPSSample)> &on_sample,
                     std::vector<std::string> *errors = nullptr);
@@ -0,0 +1,247 @@
+#include "log-follower.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/stat.h>
+
+#if __has_include(<sys/inotify.h>)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define PACER_HAS_INOTIFY 1
+#else
+#define PACER_HAS_INOTIFY 0
+#endif
+
+namespace {
+
+// Fallback poll interval, and the read size when catching up on a backlog.
+constexpr int kPollIntervalMs = 100;
+constexpr size_t kReadChunk = 64 * 1024;
+
+constexpr size_t kDatRecord = sizeof(int64_t) + sizeof(uGnssDecUbxNavPvt_t);
+
+bool HasExtension(const std::string &filename, const char *ext) {
+  size_t n = std::strlen(ext);
+  if (filename.size() < n) {
+    return false;
+  }
+  return std::equal(
+      filename.end() - n, filename.end(), ext,
+      [](unsigned char a, char b) { return std::tolower(a) == b; });
+}
+
+} // namespace
+
+pacer::LogFollower::LogFollower(std::string filename,
+                                [[maybe_unused]] bool inotify)
+    : filename_(std::move(filename)) {
+  if (HasExtension(filename_, ".dat")) {
+    format_ = Format::kDat;
+  } else if (HasExtension(filename_, ".pcl")) {
+    format_ = Format::kCompact;
+  } else if (HasExtension(filename_, ".ubx")) {
+    format_ = Format::kUbx;
+  } else {
+    throw std::runtime_error(
+        filename_ + ": only .dat, .pcl and .ubx logs can be followed");
+  }
+
+#if PACER_HAS_INOTIFY
+  // Watch the directory rather than the file: it may not exist yet, and
+  // sync tools replace files by renaming a new copy over them.
+  inotify_fd_ = inotify ? inotify_init1(IN_NONBLOCK | IN_CLOEXEC) : -1;
+  if (inotify_fd_ >= 0) {
+    std::filesystem::path dir =
+        std::filesystem::path(filename_).parent_path();
+    if (dir.empty()) {
+      dir = ".";
+    }
+    if (inotify_add_watch(inotify_fd_, dir.c_str(),
+                          IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE |
+                              IN_MOVED_TO) < 0) {
+      close(inotify_fd_);
+      inotify_fd_ = -1;
+    }
+  }
+#endif
+}
+
+pacer::LogFollower::~LogFollower() {
+#if PACER_HAS_INOTIFY
+  if (inotify_fd_ >= 0) {
+    close(inotify_fd_);
+  }
+#endif
+}
+
+auto pacer::LogFollower::Identify(const std::string &filename) -> FileId {
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0) {
+    return {};
+  }
+  return {static_cast<uint64_t>(st.st_dev), static_cast<uint64_t>(st.st_ino)};
+}
+
+void pacer::LogFollower::Restart() {
+  offset_ = 0;
+  pending_.clear();
+  header_read_ = false;
+  compact_.Reset();
+  ubx_.Reset();
+}
+
+bool pacer::LogFollower::AtZeroTail() const {
+  switch (format_) {
+  case Format::kDat:
+    return pending_.size() >= kDatRecord &&
+           std::all_of(pending_.begin(), pending_.begin() + kDatRecord,
+                       [](uint8_t b) { return b == 0; });
+  case Format::kCompact:
+    // Neither the header nor any record starts with a zero byte.
+    return !pending_.empty() && pending_[0] == 0;
+  case Format::kUbx:
+    break;
+  }
+  return false;
+}
+
+size_t pacer::LogFollower::Drain(
+    const std::function<void(GPSSample)> &on_sample) {
+  size_t samples = 0;
+  size_t used = 0;
+  if (AtZeroTail()) {
+    return 0;
+  }
+  switch (format_) {
+  case Format::kDat:
+    for (; pending_.size() - used >= kDatRecord; used += kDatRecord) {
+      if (std::all_of(pending_.begin() + used,
+                      pending_.begin() + used + kDatRecord,
+                      [](uint8_t b) { return b == 0; })) {
+        break; // the zero tail
+      }
+      uGnssDecUbxNavPvt_t pvt;
+      std::memcpy(&pvt, pending_.data() + used + sizeof(int64_t), sizeof(pvt));
+      on_sample(ToGPSSample(pvt));
+      ++samples;
+    }
+    break;
+  case Format::kCompact:
+    if (!header_read_) {
+      if (pending_.size() < CompactLogEncoder::kHeaderSize) {
+        return 0;
+      }
+      if (!CompactLogDecoder::IsCompactLog(pending_)) {
+        throw std::runtime_error(filename_ + ": not a compact session log");
+      }
+      header_read_ = true;
+      used = CompactLogEncoder::kHeaderSize;
+    }
+    used += compact_.DecodeRecords(
+        std::span(pending_).subspan(used),
+        [&](int64_t, const uGnssDecUbxNavPvt_t &pvt) {
+          on_sample(ToGPSSample(pvt));
+          ++samples;
+        });
+    break;
+  case Format::kUbx:
+    // The parser keeps partial frames itself.
+    ubx_.FeedNavPvt(pending_, [&](const uGnssDecUbxNavPvt_t &pvt) {
+      on_sample(ToGPSSample(pvt));
+      ++samples;
+    });
+    used = pending_.size();
+    break;
+  }
+  pending_.erase(pending_.begin(), pending_.begin() + used);
+  return samples;
+}
+
+pacer::LogFollower::PollResult
+pacer::LogFollower::Poll(const std::function<void(GPSSample)> &on_sample) {
+  PollResult result;
+  // Opened afresh each time, so a file replaced under its name is followed
+  // too; the open is nothing next to a frame's worth of work. A replacement
+  // may well be longer than what was read of the old file, so it's told by
+  // its inode rather than its size. The name is looked up before the open:
+  // a file swapped in between is read now and caught again next time.
+  FileId id = Identify(filename_);
+  std::ifstream file(filename_, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    return result;
+  }
+  uint64_t size = static_cast<uint64_t>(file.tellg());
+  if (size < offset_ || (offset_ > 0 && id != file_id_)) {
+    Restart();
+    result.restarted = true;
+  }
+  file_id_ = id;
+  file.seekg(static_cast<std::streamoff>(offset_));
+
+  while (offset_ < size) {
+    size_t chunk = static_cast<size_t>(std::min<uint64_t>(kReadChunk,
+                                                          size - offset_));
+    size_t old = pending_.size();
+    pending_.resize(old + chunk);
+    file.read(reinterpret_cast<char *>(pending_.data() + old), chunk);
+    size_t got = static_cast<size_t>(file.gcount());
+    pending_.resize(old + got);
+    offset_ += got;
+    result.samples += Drain(on_sample);
+    if (AtZeroTail()) {
+      // Preallocated but not written yet: it is rewritten in place, without
+      // the file growing, so pick up from here next time.
+      offset_ -= pending_.size();
+      pending_.clear();
+      break;
+    }
+    if (got < chunk) {
+      break;
+    }
+  }
+  return result;
+}
+
+bool pacer::LogFollower::Wait(int timeout_ms) {
+#if PACER_HAS_INOTIFY
+  if (inotify_fd_ >= 0) {
+    std::string name = std::filesystem::path(filename_).filename().string();
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(timeout_ms);
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+      auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now());
+      pollfd pfd{.fd = inotify_fd_, .events = POLLIN, .revents = 0};
+      if (poll(&pfd, 1, std::max<int>(0, static_cast<int>(left.count()))) <=
+          0) {
+        return false;
+      }
+      // Events for the directory's other files don't count.
+      bool ours = false;
+      ssize_t n;
+      while ((n = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+        for (char *p = buffer; p < buffer + n;) {
+          auto *event = reinterpret_cast<inotify_event *>(p);
+          ours |= event->len > 0 && name == event->name;
+          p += sizeof(inotify_event) + event->len;
+        }
+      }
+      if (ours) {
+        return true;
+      }
+    }
+  }
+#endif
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(std::min(timeout_ms, kPollIntervalMs)));
+  return true;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <pacer/datatypes/datatypes.hpp>
+#include <pacer/gps-source/compact-log.hpp>
+#include <pacer/gps-source/ubx-parser.hpp>
+
+namespace pacer {
+
+// Tails a session log that is still being written (a .dat or .pcl synced
+// off the logger, a .ubx capture of the receiver's stream), handing out
+// each new fix once its record is complete. Every Poll() reads only the
+// bytes appended since the last one, so feeding Laps::AddPoint() and
+// calling Laps::Update() costs in proportion to the new fixes, not to the
+// session so far.
+//
+//   LogFollower follower("SESS_003.pcl");
+//   while (follower.Wait(1000)) {
+//     follower.Poll([&](GPSSample s) { laps.AddPoint(s); });
+//     laps.Update();
+//   }
+//
+// Wait() sleeps on inotify where the platform has it, and polls the file
+// otherwise. A file truncated, or replaced under its name (told by its
+// inode), is read again from the start. The firmware preallocates its
+// .dat/.pcl logs with zeros ahead of the data; a zero tail reads as "not
+// written yet" and is read again on the next Poll().
+class LogFollower {
+public:
+  /// Throws std::runtime_error for a format that can't be tailed (GPMF
+  /// files are only readable once complete). The file needn't exist yet.
+  /// With `inotify` false, Wait() polls even where inotify is available.
+  explicit LogFollower(std::string filename, bool inotify = true);
+  ~LogFollower();
+
+  LogFollower(const LogFollower &) = delete;
+  LogFollower &operator=(const LogFollower &) = delete;
+
+  struct PollResult {
+    size_t samples = 0;
+    /// The file got shorter or was replaced by another one (rewritten, not
+    /// appended to): everything is read again from the start, so fixes
+    /// handed out before are stale.
+    bool restarted = false;
+  };
+
+  /// Calls `on_sample` for every fix completed since the last call, in file
+  /// order. Throws std::runtime_error if the file isn't the format its name
+  /// says.
+  PollResult Poll(const std::function<void(GPSSample)> &on_sample);
+
+  /// Blocks for up to `timeout_ms` until the file may have changed; false
+  /// on a timeout. Without inotify it sleeps for the poll interval (capped
+  /// by the timeout) and returns true.
+  bool Wait(int timeout_ms);
+
+  const std::string &Filename() const { return filename_; }
+
+  /// Bytes of the file read so far.
+  uint64_t Offset() const { return offset_; }
+
+private:
+  enum class Format { kDat, kCompact, kUbx };
+
+  /// Which file is behind the name: device and inode, zero where the
+  /// platform doesn't say.
+  struct FileId {
+    uint64_t dev = 0, ino = 0;
+
+    bool operator==(const FileId &) const = default;
+  };
+  static FileId Identify(const std::string &filename);
+
+  void Restart();
+
+  /// Decodes the whole records at the start of pending_ and drops them.
+  size_t Drain(const std::function<void(GPSSample)> &on_sample);
+
+  /// True if pending_ starts with zeros where a record should be: space the
+  /// logger preallocated but hasn't written yet.
+  bool AtZeroTail() const;
+
+  std::string filename_;
+  Format format_;
+  uint64_t offset_ = 0;
+  FileId file_id_;               ///< of the file offset_ is into
+  std::vector<uint8_t> pending_; ///< read, not yet decoded (< one record)
+  bool header_read_ = false;     ///< .pcl only
+  CompactLogDecoder compact_;
+  UbxParser ubx_;
+  int inotify_fd_ = -1;
+};
+
+} // namespace pacer
@@ -0,0 +1,300 @@
+#include "session-cache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+#include "gpmf-reader.hpp"
+#include "gps-source.hpp"
+
+namespace fs = std::filesystem;
+
+struct pacer::SessionCache::Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t path_size; ///< source path bytes following the header
+  uint64_t source_size;
+  int64_t source_mtime;
+  uint64_t sample_count;
+  uint64_t payload_count;
+  double duration_s;
+  uint64_t accel_count;
+  uint64_t gyro_count;
+};
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'A', 'C', 'E', 'R', 'G', 'C', '\0'};
+constexpr size_t kSampleColumns = 7;
+constexpr size_t kPayloadColumns = 3;
+constexpr size_t kImuColumns = 4;
+
+size_t Padded(size_t n) { return (n + 7) & ~size_t{7}; }
+
+struct SourceKey {
+  std::string path;
+  uint64_t size = 0;
+  int64_t mtime = 0;
+};
+
+bool GetSourceKey(const std::string &source, SourceKey *key) {
+  std::error_code ec;
+  fs::path path = fs::absolute(source, ec);
+  if (ec) {
+    return false;
+  }
+  key->path = path.string();
+  key->size = fs::file_size(path, ec);
+  if (ec) {
+    return false;
+  }
+  auto mtime = fs::last_write_time(path, ec);
+  if (ec) {
+    return false;
+  }
+  key->mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+  return true;
+}
+
+} // namespace
+
+pacer::GPMFSession pacer::DecodeGPMFFile(const char *filename) {
+  GPMFSession session;
+  GPMFReader reader(filename, /*imu=*/true);
+  session.payloads.reserve(reader.PayloadCount());
+  for (size_t k = 0; k < reader.PayloadCount(); ++k) {
+    auto [start, end] = reader.PayloadTimeSpan(k);
+    session.payloads.push_back(GPMFSession::Payload{
+        .start_s = start,
+        .end_s = end,
+        .first_sample = session.samples.size(),
+    });
+    for (const GPMFSample &s : reader.Payload(k)) {
+      session.samples.push_back(s.gps);
+      session.payload_offset_s.push_back(
+          s.count ? (end - start) * s.index / s.count : 0.0);
+    }
+    for (auto [imu, channel] : {std::pair{reader.Accel(), &session.accel},
+                                std::pair{reader.Gyro(), &session.gyro}}) {
+      for (const GPMFImuSample &r : imu) {
+        channel->time_s.push_back(start + (end - start) * r.index / r.count);
+        channel->x.push_back(r.x);
+        channel->y.push_back(r.y);
+        channel->z.push_back(r.z);
+      }
+    }
+    session.duration_s = std::max(session.duration_s, end);
+  }
+  return session;
+}
+
+std::string pacer::SessionCache::PathFor(const std::string &source) {
+  return source + ".pacer-cache";
+}
+
+pacer::SessionCache pacer::SessionCache::Open(const std::string &source) {
+  SourceKey key;
+  if (!GetSourceKey(source, &key)) {
+    return {};
+  }
+
+  SessionCache cache;
+  try {
+    cache.file_ = MappedFile(PathFor(source).c_str());
+  } catch (const std::exception &) {
+    return {};
+  }
+
+  const std::byte *data = cache.file_.data();
+  size_t size = cache.file_.size();
+  if (size < sizeof(Header)) {
+    return {};
+  }
+  const auto *header = reinterpret_cast<const Header *>(data);
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header->version != kVersion || header->path_size != key.path.size() ||
+      header->source_size != key.size || header->source_mtime != key.mtime) {
+    return {};
+  }
+
+  size_t path_offset = sizeof(Header);
+  size_t columns_offset = path_offset + Padded(header->path_size);
+  if (size < columns_offset ||
+      std::memcmp(data + path_offset, key.path.data(), key.path.size()) != 0) {
+    return {};
+  }
+  // The counts come off disk: bound each by the entries the file can hold
+  // before multiplying, so a corrupt header can't wrap the size check.
+  uint64_t entries = (size - columns_offset) / 8, needed = 0;
+  for (auto [count, columns] :
+       {std::pair{header->sample_count, kSampleColumns},
+        std::pair{header->payload_count, kPayloadColumns},
+        std::pair{header->accel_count, kImuColumns},
+        std::pair{header->gyro_count, kImuColumns}}) {
+    if (count > entries / columns) {
+      return {};
+    }
+    needed += count * columns;
+  }
+  if (size != columns_offset + 8 * needed) {
+    return {};
+  }
+
+  const std::byte *column = data + columns_offset;
+  auto next = [&](size_t count) {
+    const std::byte *start = column;
+    column += 8 * count;
+    return start;
+  };
+  size_t n = header->sample_count, m = header->payload_count;
+  cache.lat_ = reinterpret_cast<const double *>(next(n));
+  cache.lon_ = reinterpret_cast<const double *>(next(n));
+  cache.altitude_ = reinterpret_cast<const double *>(next(n));
+  cache.full_speed_ = reinterpret_cast<const double *>(next(n));
+  cache.ground_speed_ = reinterpret_cast<const double *>(next(n));
+  cache.timestamp_ = reinterpret_cast<const int64_t *>(next(n));
+  cache.payload_offset_ = reinterpret_cast<const double *>(next(n));
+  cache.payload_start_ = reinterpret_cast<const double *>(next(m));
+  cache.payload_end_ = reinterpret_cast<const double *>(next(m));
+  cache.payload_first_ = reinterpret_cast<const uint64_t *>(next(m));
+  auto imu = [&](size_t count) {
+    ImuColumns c{.size = count};
+    c.time_s = reinterpret_cast<const double *>(next(count));
+    c.x = reinterpret_cast<const double *>(next(count));
+    c.y = reinterpret_cast<const double *>(next(count));
+    c.z = reinterpret_cast<const double *>(next(count));
+    return c;
+  };
+  cache.accel_ = imu(header->accel_count);
+  cache.gyro_ = imu(header->gyro_count);
+  // Consumers index samples through first_sample.
+  for (size_t k = 0; k < m; ++k) {
+    if (cache.payload_first_[k] > n) {
+      return {};
+    }
+  }
+  cache.header_ = header;
+  return cache;
+}
+
+bool pacer::SessionCache::Write(const std::string &source,
+                                const GPMFSession &session) {
+  SourceKey key;
+  if (!GetSourceKey(source, &key)) {
+    return false;
+  }
+
+  std::string path = PathFor(source);
+  std::string tmp_path = path + ".tmp";
+  FILE *f = fopen(tmp_path.c_str(), "wb");
+  if (!f) {
+    return false;
+  }
+
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.path_size = static_cast<uint32_t>(key.path.size());
+  header.source_size = key.size;
+  header.source_mtime = key.mtime;
+  header.sample_count = session.samples.size();
+  header.payload_count = session.payloads.size();
+  header.duration_s = session.duration_s;
+  header.accel_count = session.accel.size();
+  header.gyro_count = session.gyro.size();
+
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+  const char padding[8] = {};
+  ok = ok && fwrite(key.path.data(), 1, key.path.size(), f) == key.path.size();
+  size_t pad = Padded(key.path.size()) - key.path.size();
+  ok = ok && fwrite(padding, 1, pad, f) == pad;
+
+  // One column at a time, gathered through a small staging buffer.
+  auto column = [&](size_t count, auto get) {
+    using T = decltype(get(size_t{0}));
+    static_assert(sizeof(T) == 8);
+    T buffer[512];
+    for (size_t i = 0; ok && i < count; i += std::size(buffer)) {
+      size_t chunk = std::min(std::size(buffer), count - i);
+      for (size_t k = 0; k < chunk; ++k) {
+        buffer[k] = get(i + k);
+      }
+      ok = fwrite(buffer, sizeof(T), chunk, f) == chunk;
+    }
+  };
+  const auto &samples = session.samples;
+  const auto &payloads = session.payloads;
+  column(samples.size(), [&](size_t i) { return samples[i].lat; });
+  column(samples.size(), [&](size_t i) { return samples[i].lon; });
+  column(samples.size(), [&](size_t i) { return samples[i].altitude; });
+  column(samples.size(), [&](size_t i) { return samples[i].full_speed; });
+  column(samples.size(), [&](size_t i) { return samples[i].ground_speed; });
+  column(samples.size(),
+         [&](size_t i) { return int64_t{samples[i].timestamp_ms}; });
+  column(samples.size(),
+         [&](size_t i) { return session.payload_offset_s[i]; });
+  column(payloads.size(), [&](size_t k) { return payloads[k].start_s; });
+  column(payloads.size(), [&](size_t k) { return payloads[k].end_s; });
+  column(payloads.size(),
+         [&](size_t k) { return uint64_t{payloads[k].first_sample}; });
+  for (const ImuChannel *imu : {&session.accel, &session.gyro}) {
+    for (const std::vector<double> *c : {&imu->time_s, &imu->x, &imu->y,
+                                         &imu->z}) {
+      column(c->size(), [&](size_t i) { return (*c)[i]; });
+    }
+  }
+
+  ok = (fclose(f) == 0) && ok;
+  std::error_code ec;
+  if (ok) {
+    fs::rename(tmp_path, path, ec);
+  }
+  if (!ok || ec) {
+    fs::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+size_t pacer::SessionCache::size() const {
+  return header_ ? header_->sample_count : 0;
+}
+
+pacer::GPSSample pacer::SessionCache::Sample(size_t i) const {
+  return GPSSample{
+      .lat = lat_[i],
+      .lon = lon_[i],
+      .altitude = altitude_[i],
+      .full_speed = full_speed_[i],
+      .ground_speed = ground_speed_[i],
+      .timestamp_ms = timestamp_[i],
+  };
+}
+
+double pacer::SessionCache::PayloadOffset(size_t i) const {
+  return payload_offset_[i];
+}
+
+size_t pacer::SessionCache::PayloadCount() const {
+  return header_ ? header_->payload_count : 0;
+}
+
+pacer::GPMFSession::Payload pacer::SessionCache::GetPayload(size_t k) const {
+  return GPMFSession::Payload{
+      .start_s = payload_start_[k],
+      .end_s = payload_end_[k],
+      .first_sample = payload_first_[k],
+  };
+}
+
+double pacer::SessionCache::Duration() const {
+  return header_ ? header_->duration_s : 0;
+}
+
+pacer::ImuColumns pacer::SessionCache::Accel() const { return accel_; }
+
+pacer::ImuColumns pacer::SessionCache::Gyro() const { return gyro_; }
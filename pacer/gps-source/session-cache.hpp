@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <pacer/datatypes/datatypes.hpp>
+#include <pacer/gps-source/dat-file.hpp>
+
+namespace pacer {
+
+// A 3-axis IMU stream (see GPMFImuSample), columnar. Times are seconds into
+// the file, spread evenly over each payload's span the way GPS samples'
+// payload_offset_s are, so both line up on the payload clock.
+struct ImuChannel {
+  std::vector<double> time_s, x, y, z;
+
+  size_t size() const { return time_s.size(); }
+};
+
+/// Columns of an ImuChannel, in memory or mapped from a SessionCache.
+struct ImuColumns {
+  const double *time_s = nullptr, *x = nullptr, *y = nullptr, *z = nullptr;
+  size_t size = 0;
+};
+
+// A GPMF file's GPS stream, decoded once: samples in file order plus the MP4
+// payload spans they came from. Samples without an embedded clock
+// (timestamp_ms == 0) get one synthesized from their payload's span by the
+// caller (see LoadGPSFiles()), since it chains across files.
+struct GPMFSession {
+  struct Payload {
+    double start_s = 0, end_s = 0; ///< span within the file
+    size_t first_sample = 0;       ///< samples of a payload are contiguous
+  };
+
+  std::vector<GPSSample> samples;
+  /// Per sample: synthesized offset from its payload's start_s, spread
+  /// evenly over the span by index within the payload.
+  std::vector<double> payload_offset_s;
+  std::vector<Payload> payloads;
+  double duration_s = 0; ///< latest payload end
+  ImuChannel accel, gyro; ///< empty for cameras without an IMU
+
+  size_t size() const { return samples.size(); }
+  GPSSample Sample(size_t i) const { return samples[i]; }
+  double PayloadOffset(size_t i) const { return payload_offset_s[i]; }
+  size_t PayloadCount() const { return payloads.size(); }
+  Payload GetPayload(size_t k) const { return payloads[k]; }
+  double Duration() const { return duration_s; }
+  ImuColumns Accel() const { return Columns(accel); }
+  ImuColumns Gyro() const { return Columns(gyro); }
+
+private:
+  static ImuColumns Columns(const ImuChannel &c) {
+    return {c.time_s.data(), c.x.data(), c.y.data(), c.z.data(), c.size()};
+  }
+};
+
+/// Walks every payload of a GPMF (.mp4 etc.) file through GPMFReader,
+/// GPS and IMU streams in the same pass. Throws std::runtime_error if the
+/// file can't be opened.
+GPMFSession DecodeGPMFFile(const char *filename);
+
+// Sidecar cache of a decoded GPMFSession, `<source>.pacer-cache` next to the
+// source file. Columnar and 8-byte aligned throughout, so it's read by
+// mapping it (see MappedFile) and indexing columns in place — no parsing.
+// Keyed by the source's absolute path, size and mtime: any change to the
+// source makes Open() miss and the cache gets rebuilt. SessionCache exposes
+// the same accessors as GPMFSession, so consumers can take either.
+//
+// Layout (native endianness; the cache never leaves the machine):
+//   Header, source path (padded to 8 bytes), then sample columns lat, lon,
+//   altitude, full_speed, ground_speed, timestamp_ms, payload_offset_s and
+//   payload columns start_s, end_s, first_sample, then accel and gyro
+//   columns time_s, x, y, z; each column 8 bytes per entry.
+class SessionCache {
+public:
+  constexpr static uint32_t kVersion = 3;
+
+  /// Mapped cache for `source`, or an empty (!valid()) cache if there is
+  /// none, it's stale, or it's unreadable.
+  static SessionCache Open(const std::string &source);
+
+  /// Writes the cache for `source`, atomically replacing any previous one.
+  /// Returns false (and leaves no partial file) if it can't be written, e.g.
+  /// on a read-only SD card; callers just carry on uncached.
+  static bool Write(const std::string &source, const GPMFSession &session);
+
+  static std::string PathFor(const std::string &source);
+
+  bool valid() const { return header_ != nullptr; }
+
+  size_t size() const;
+  GPSSample Sample(size_t i) const;
+  double PayloadOffset(size_t i) const;
+  size_t PayloadCount() const;
+  GPMFSession::Payload GetPayload(size_t k) const;
+  double Duration() const;
+  ImuColumns Accel() const;
+  ImuColumns Gyro() const;
+
+  struct Header;
+
+private:
+  MappedFile file_;
+  const Header *header_ = nullptr;
+  /// Column bases, see the layout above.
+  const double *lat_ = nullptr, *lon_ = nullptr, *altitude_ = nullptr,
+               *full_speed_ = nullptr, *ground_speed_ = nullptr,
+               *payload_offset_ = nullptr, *payload_start_ = nullptr,
+               *payload_end_ = nullptr;
+  const int64_t *timestamp_ = nullptr;
+  const uint64_t *payload_first_ = nullptr;
+  ImuColumns accel_, gyro_;
+};
+
+} // namespace pacer
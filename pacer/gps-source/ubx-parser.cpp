@@ -0,0 +1,72 @@
+#include "ubx-parser.hpp"
+
+namespace {
+
+uint16_t GetU2(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+uint32_t GetU4(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+int32_t GetI4(const uint8_t *p) { return (int32_t)GetU4(p); }
+int16_t GetI2(const uint8_t *p) { return (int16_t)GetU2(p); }
+
+} // namespace
+
+void pacer::UbxChecksum(const uint8_t *data, size_t len, uint8_t *ck_a,
+                        uint8_t *ck_b) {
+  uint8_t a = 0, b = 0;
+  for (size_t i = 0; i < len; ++i) {
+    a += data[i];
+    b += a;
+  }
+  *ck_a = a;
+  *ck_b = b;
+}
+
+// Offsets per the u-blox interface manual (UBX-NAV-PVT, 92-byte payload).
+void pacer::DecodeNavPvt(const uint8_t *p, uGnssDecUbxNavPvt_t *out) {
+  out->iTOW = GetU4(p + 0);
+  out->year = GetU2(p + 4);
+  out->month = p[6];
+  out->day = p[7];
+  out->hour = p[8];
+  out->min = p[9];
+  out->sec = p[10];
+  out->valid = p[11];
+  out->tAcc = GetU4(p + 12);
+  out->nano = GetI4(p + 16);
+  out->fixType = (uGnssDecUbxNavPvtFixType_t)p[20];
+  out->flags = p[21];
+  out->flags2 = p[22];
+  out->numSV = p[23];
+  out->lon = GetI4(p + 24);
+  out->lat = GetI4(p + 28);
+  out->height = GetI4(p + 32);
+  out->hMSL = GetI4(p + 36);
+  out->hAcc = GetU4(p + 40);
+  out->vAcc = GetU4(p + 44);
+  out->velN = GetI4(p + 48);
+  out->velE = GetI4(p + 52);
+  out->velD = GetI4(p + 56);
+  out->gSpeed = GetI4(p + 60);
+  out->headMot = GetI4(p + 64);
+  out->sAcc = GetU4(p + 68);
+  out->headAcc = GetU4(p + 72);
+  out->pDOP = GetU2(p + 76);
+  out->flags3 = GetU2(p + 78);
+  // p+80..83 reserved
+  out->headVeh = GetI4(p + 84);
+  out->magDec = GetI2(p + 88);
+  out->magAcc = GetU2(p + 90);
+}
+
+pacer::GPSSample pacer::ToGPSSample(const uGnssDecUbxNavPvt_t &pvt) {
+  return GPSSample{
+      .lat = static_cast<double>(pvt.lat) / 1e7,
+      .lon = static_cast<double>(pvt.lon) / 1e7,
+      .altitude = pvt.height / 1000.0,     // mm to m
+      .full_speed = pvt.gSpeed / 1000.0,   // mm/s to m/s
+      .ground_speed = pvt.gSpeed / 1000.0, // mm/s to m/s
+      .timestamp_ms = static_cast<int64_t>(pvt.iTOW),
+  };
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+// Incremental UBX framing and NAV-PVT decoding, shared by the firmware's
+// UART reader and the desktop's raw capture (.ubx) loader. Portable and
+// allocation-free: no platform headers, one fixed buffer per parser.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include <pacer/datatypes/datatypes.hpp>
+#include <pacer/gps-source/ubx-nav-pvt.hpp>
+
+namespace pacer {
+
+inline constexpr uint8_t kUbxSync1 = 0xB5, kUbxSync2 = 0x62;
+inline constexpr uint8_t kUbxClassNav = 0x01, kUbxIdNavPvt = 0x07;
+inline constexpr size_t kUbxNavPvtLen = 92;
+
+/// UBX 8-bit Fletcher checksum of `len` bytes (class, id, length, payload).
+void UbxChecksum(const uint8_t *data, size_t len, uint8_t *ck_a,
+                 uint8_t *ck_b);
+
+/// Decodes a NAV-PVT payload (at least kUbxNavPvtLen bytes, little-endian
+/// wire layout) field by field: the wire fixType is one byte, while the
+/// shared struct keeps it as an enum, so it can't be a memcpy.
+void DecodeNavPvt(const uint8_t *payload, uGnssDecUbxNavPvt_t *out);
+
+/// NAV-PVT as the timing code sees it: degrees, meters, m/s, and the
+/// receiver's iTOW as timestamp_ms.
+GPSSample ToGPSSample(const uGnssDecUbxNavPvt_t &pvt);
+
+// Splits a UBX byte stream, fed in arbitrary chunks, into checksummed
+// frames. Sync bytes are found with memchr, so runs of non-UBX bytes (NMEA,
+// line noise) are skipped at memory speed. A bad checksum or an impossible
+// length resyncs from the byte after the false sync, so a frame hidden
+// behind a corrupt one is still found.
+//
+// Frames lying entirely inside a chunk are handed out in place, without a
+// copy; only a frame split across chunks goes through the parser's buffer.
+class UbxParser {
+public:
+  static constexpr size_t kMaxPayload = 1024;
+
+  struct Frame {
+    uint8_t cls = 0, id = 0;
+    std::span<const uint8_t> payload; ///< valid during the callback only
+  };
+
+  struct Stats {
+    uint64_t frames = 0;
+    uint64_t checksum_errors = 0;
+    uint64_t oversized = 0;     ///< length field above kMaxPayload
+    uint64_t skipped_bytes = 0; ///< not part of any good frame
+  };
+
+  /// Calls `on_frame(const Frame &)` for every good frame completed by
+  /// `bytes`, in stream order.
+  template <class F> void Feed(std::span<const uint8_t> bytes, F &&on_frame);
+
+  /// Feed() that decodes the NAV-PVT frames for `on_pvt(const
+  /// uGnssDecUbxNavPvt_t &)` and ignores the rest.
+  template <class F>
+  void FeedNavPvt(std::span<const uint8_t> bytes, F &&on_pvt) {
+    Feed(bytes, [&](const Frame &frame) {
+      if (frame.cls == kUbxClassNav && frame.id == kUbxIdNavPvt &&
+          frame.payload.size() >= kUbxNavPvtLen) {
+        uGnssDecUbxNavPvt_t pvt;
+        DecodeNavPvt(frame.payload.data(), &pvt);
+        on_pvt(pvt);
+      }
+    });
+  }
+
+  /// Drops a partially received frame, e.g. after the line was reconfigured.
+  void Reset() { have_ = 0; }
+
+  const Stats &GetStats() const { return stats_; }
+
+private:
+  static constexpr size_t kHeader = 6, kOverhead = 8; // + 2 checksum bytes
+
+  /// Hands out every frame complete within `data`; returns how many bytes
+  /// were consumed. What's left starts with a sync but is an incomplete
+  /// frame (at most kOverhead + kMaxPayload - 1 bytes).
+  template <class F> size_t Scan(const uint8_t *data, size_t n, F &on_frame);
+
+  Stats stats_;
+  size_t have_ = 0; ///< bytes of an incomplete frame in buffer_
+  uint8_t buffer_[kOverhead + kMaxPayload];
+};
+
+template <class F>
+size_t UbxParser::Scan(const uint8_t *data, size_t n, F &on_frame) {
+  size_t pos = 0;
+  while (pos < n) {
+    const void *sync = std::memchr(data + pos, kUbxSync1, n - pos);
+    if (!sync) {
+      stats_.skipped_bytes += n - pos;
+      return n;
+    }
+    size_t at = static_cast<const uint8_t *>(sync) - data;
+    stats_.skipped_bytes += at - pos;
+    pos = at;
+
+    size_t avail = n - pos;
+    if (avail < 2) {
+      return pos;
+    }
+    if (data[pos + 1] != kUbxSync2) {
+      ++stats_.skipped_bytes;
+      ++pos;
+      continue;
+    }
+    if (avail < kHeader) {
+      return pos;
+    }
+    size_t len = data[pos + 4] | (size_t{data[pos + 5]} << 8);
+    if (len > kMaxPayload) {
+      ++stats_.oversized;
+      ++stats_.skipped_bytes;
+      ++pos;
+      continue;
+    }
+    if (avail < kOverhead + len) {
+      return pos;
+    }
+    uint8_t ck_a, ck_b;
+    UbxChecksum(data + pos + 2, 4 + len, &ck_a, &ck_b);
+    if (data[pos + kHeader + len] != ck_a ||
+        data[pos + kHeader + len + 1] != ck_b) {
+      ++stats_.checksum_errors;
+      ++stats_.skipped_bytes;
+      ++pos;
+      continue;
+    }
+    ++stats_.frames;
+    on_frame(Frame{.cls = data[pos + 2],
+                   .id = data[pos + 3],
+                   .payload = {data + pos + kHeader, len}});
+    pos += kOverhead + len;
+  }
+  return pos;
+}
+
+template <class F>
+void UbxParser::Feed(std::span<const uint8_t> bytes, F &&on_frame) {
+  const uint8_t *p = bytes.data();
+  size_t n = bytes.size();
+
+  // Finish the buffered frame first, topping it up only as far as its own
+  // length so the buffer never holds more than one frame.
+  while (have_ > 0 && n > 0) {
+    size_t want = kHeader;
+    if (have_ >= kHeader) {
+      size_t len = buffer_[4] | (size_t{buffer_[5]} << 8);
+      want = len > kMaxPayload ? have_ : kOverhead + len;
+    }
+    size_t take = std::min(want - std::min(want, have_), n);
+    std::memcpy(buffer_ + have_, p, take);
+    have_ += take;
+    p += take;
+    n -= take;
+
+    size_t used = Scan(buffer_, have_, on_frame);
+    std::memmove(buffer_, buffer_ + used, have_ - used);
+    have_ -= used;
+  }
+  if (have_ > 0) {
+    return; // all of `bytes` went into the buffered frame
+  }
+
+  size_t used = Scan(p, n, on_frame);
+  std::memcpy(buffer_, p + used, n - used);
+  have_ = n - used;
+}
+
+} // namespace pacer
@@ -49,6 +49,7 @@ void pacer::LapsDisplay::SetMapFrame(const CoordinateSystem &frame) {
   // Invalidate bounds so the next SetupMap refits the axes in the new frame.
   bounds = {{1, 1}, {0, 0}};
   if (laps) {
+    laps->KeepLocalPoints(true);
     laps->SetCoordinateSystem(cs);
   }
 }
@@ -66,6 +67,8 @@ void pacer::LapsDisplay::SetupMap() {
           .altitude = 0,
       });
     }
+    // The map trace plots from the local columns.
+    laps->KeepLocalPoints(true);
     laps->SetCoordinateSystem(cs);
     auto min_ = cs.Local(GPSSample{
         .lat = bounds.first.y,
@@ -121,6 +124,12 @@ void pacer::LapsDisplay::PlotMapItems() {
       "trace",
       [](int index, void *data) {
         auto &ld = *reinterpret_cast<LapsDisplay *>(data);
+        // SetupMap() puts laps in our frame, which keeps the points
+        // projected; no per-frame trig over the whole session.
+        if (ld.laps->HasLocalPoints()) {
+          Point p = ld.laps->LocalPoint(index);
+          return ImPlotPoint(p.x, p.y);
+        }
         return ld.ToImPlotPoint(ld.laps->GetPoint(index));
       },
       reinterpret_cast<void *>(this), (int)laps->PointCount());
@@ -331,22 +340,72 @@ std::optional<double> pacer::DeltaLapsComparision::HoverDistance() const {
   return hover_distance_;
 }
 
+pacer::DeltaLapsComparision::DeltaLapsComparision()
+    : pool_(std::make_unique<ResamplePool>()) {}
+
+pacer::DeltaLapsComparision::~DeltaLapsComparision() = default;
+
 void pacer::DeltaLapsComparision::RefreshResampled(const Laps &laps) {
   if (resample_frame_ == ImGui::GetFrameCount()) {
     return;
   }
   resample_frame_ = ImGui::GetFrameCount();
 
-  resampled_laps_.clear();
+  // reference_track is a plain member the app may replace at any point, so
+  // it's compared against the snapshot rather than tracked through setters.
+  if (!resample_track_ || !resample_track_->Matches(reference_track)) {
+    resample_track_ =
+        ResamplePool::Track::Make(reference_track, ++track_version_);
+    pool_->DropQueued();
+    pending_.clear();
+    resampled_laps_.clear();
+  }
+
+  for (ResamplePool::Result &result : pool_->TakeResults()) {
+    auto pending = pending_.find(result.lap_id);
+    if (pending == pending_.end() || pending->second != result.key) {
+      continue; // superseded while in flight
+    }
+    pending_.erase(pending);
+    resampled_laps_[result.lap_id] =
+        ResampledEntry{.key = result.key, .lap = std::move(result.lap)};
+  }
+
   best_lap_id_ = -1;
   for (int lap_id : selected_laps) {
-    resampled_laps_[lap_id] = reference_track.Resample(laps.GetLap(lap_id));
+    ResamplePool::Key key{
+        .track_version = resample_track_->version,
+        .laps_version = laps.Version(),
+        .sample_count = laps.SampleCount(lap_id),
+    };
+    auto cached = resampled_laps_.find(lap_id);
+    if (cached != resampled_laps_.end() && cached->second.key != key) {
+      resampled_laps_.erase(cached);
+      cached = resampled_laps_.end();
+    }
+    auto pending = pending_.find(lap_id);
+    bool queued = pending != pending_.end() && pending->second == key;
+    if (cached == resampled_laps_.end() && !queued) {
+      pending_[lap_id] = key;
+      pool_->Submit(ResamplePool::Job{
+          .lap_id = lap_id,
+          .key = key,
+          .lap = laps.GetLap(lap_id),
+          .track = resample_track_,
+      });
+    }
+
     if (best_lap_id_ == -1 || laps.LapTime(lap_id) < laps.LapTime(best_lap_id_)) {
       best_lap_id_ = lap_id;
     }
   }
 }
 
+const pacer::Lap *pacer::DeltaLapsComparision::ResampledLap(int lap_id) const {
+  auto it = resampled_laps_.find(lap_id);
+  return it != resampled_laps_.end() ? &it->second.lap : nullptr;
+}
+
 void pacer::DeltaLapsComparision::DrawReferenceTrackLoader(
     Laps &laps, LapsDisplay &display) {
   bool load = reference_track_picker.Draw("reference_track");
@@ -467,7 +526,10 @@ void pacer::DeltaLapsComparision::Display(const Laps &laps) {
       ImPlot::SetupAxis(ImAxis_X1, "", ImPlotAxisFlags_NoTickLabels);
 
       for (int lap_id : lap_ids) {
-        const Lap &lap = resampled_laps_[lap_id];
+        const Lap *lap = ResampledLap(lap_id);
+        if (!lap) {
+          continue;
+        }
         ImPlot::SetNextLineStyle(LapColor(lap_id));
         ImPlot::PlotLineG(
             std::format("lap {}", lap_id).c_str(),
@@ -476,13 +538,17 @@ void pacer::DeltaLapsComparision::Display(const Laps &laps) {
               return ImPlotPoint{lap.cum_distances[index],
                                  lap.points[index].full_speed * 3.6};
             },
-            (void *)&lap, (int)lap.Count());
+            (void *)lap, (int)lap->Count());
       }
 
       if (auto d = HoverDistance()) {
         plot_cursor(*d);
         for (size_t i = 0; i < lap_ids.size(); ++i) {
-          if (auto s = SampleAtDistance(resampled_laps_[lap_ids[i]], *d)) {
+          const Lap *lap = ResampledLap(lap_ids[i]);
+          if (!lap) {
+            continue;
+          }
+          if (auto s = SampleAtDistance(*lap, *d)) {
             ImPlot::Annotation(*d, s->full_speed * 3.6, LapColor(lap_ids[i]),
                                annotation_offset(i), true, "%.1f km/h",
                                s->full_speed * 3.6);
@@ -498,22 +564,27 @@ void pacer::DeltaLapsComparision::Display(const Laps &laps) {
       ImPlot::SetNextAxesToFit();
     }
     if (ImPlot::BeginPlot("Delta", ImVec2(), ImPlotFlags_NoTitle)) {
-      if (best_lap_id_ != -1) {
-        auto &best_lap = resampled_laps_[best_lap_id_];
+      if (const Lap *best = ResampledLap(best_lap_id_)) {
+        const Lap &best_lap = *best;
 
         for (int lap_id : lap_ids) {
-          auto &lap = resampled_laps_[lap_id];
+          const Lap *resampled = ResampledLap(lap_id);
+          if (!resampled) {
+            continue;
+          }
+          const Lap &lap = *resampled;
           int plot_count = static_cast<int>(
               std::min(lap.points.size(), best_lap.points.size()));
           if (plot_count <= 0)
             continue;
 
-          std::tuple<Lap &, Lap &> data{lap, best_lap};
+          std::tuple<const Lap &, const Lap &> data{lap, best_lap};
           ImPlot::SetNextLineStyle(LapColor(lap_id));
           ImPlot::PlotLineG(
               std::format("lap {}", lap_id).c_str(),
               [](int index, void *data) -> ImPlotPoint {
-                auto [lap, best_lap] = *(std::tuple<Lap &, Lap &> *)data;
+                auto [lap, best_lap] =
+                    *(std::tuple<const Lap &, const Lap &> *)data;
                 auto lap_time = (lap.points[index].timestamp_ms -
                                  lap.points[0].timestamp_ms) /
                                 1000.0;
@@ -532,8 +603,11 @@ void pacer::DeltaLapsComparision::Display(const Laps &laps) {
         if (auto d = HoverDistance()) {
           plot_cursor(*d);
           for (size_t i = 0; i < lap_ids.size(); ++i) {
-            if (auto delta = DeltaAtDistance(resampled_laps_[lap_ids[i]],
-                                             best_lap, *d)) {
+            const Lap *lap = ResampledLap(lap_ids[i]);
+            if (!lap) {
+              continue;
+            }
+            if (auto delta = DeltaAtDistance(*lap, best_lap, *d)) {
               ImPlot::Annotation(*d, *delta, LapColor(lap_ids[i]),
                                  annotation_offset(i), true, "%+.2fs", *delta);
             }
@@ -652,20 +726,25 @@ void pacer::DeltaLapsComparision::PlotComparisonMap(const Laps &laps) {
   std::vector<int> lap_ids(selected_laps.begin(), selected_laps.end());
   std::sort(lap_ids.begin(), lap_ids.end());
 
+  // Redrawn every frame, so projected in one batch; the tangent plane's
+  // sub-cm error is far below a pixel.
+  std::vector<Vec3f> projected;
   for (int lap_id : lap_ids) {
-    const Lap &lap = resampled_laps_[lap_id];
-    auto data = std::pair{this, &lap};
+    const Lap *lap = ResampledLap(lap_id);
+    if (!lap) {
+      continue;
+    }
+    projected.resize(lap->points.size());
+    cs.LocalBatch(lap->points, projected, Projection::kTangentPlane);
     ImPlot::SetNextLineStyle(LapColor(lap_id), 2.0f);
     ImPlot::PlotLineG(
         std::format("lap {}", lap_id).c_str(),
         [](int index, void *data) -> ImPlotPoint {
-          auto &[self, lap] =
-              *reinterpret_cast<std::pair<DeltaLapsComparision *, const Lap *>
-                                    *>(data);
-          Vec3f p = self->cs.Local(lap->points[index]);
+          const Vec3f &p =
+              (*reinterpret_cast<const std::vector<Vec3f> *>(data))[index];
           return ImPlotPoint{p[0], p[1]};
         },
-        &data, (int)lap.Count());
+        &projected, (int)lap->Count());
   }
 
   // Hovering inside the track picks the distance for every view: project
@@ -679,7 +758,7 @@ void pacer::DeltaLapsComparision::PlotComparisonMap(const Laps &laps) {
           reference_track.cs.Global(Vec3f{ref_local.x, ref_local.y, 0}));
       return Point{p[0], p[1]};
     };
-    std::vector<Segment> gates = reference_track.DensifiedGates();
+    std::vector<Segment> gates = resample_track_->densified;
     for (Segment &gate : gates) {
       gate = Segment{to_local(gate.first), to_local(gate.second)};
     }
@@ -687,8 +766,7 @@ void pacer::DeltaLapsComparision::PlotComparisonMap(const Laps &laps) {
       size_t k = static_cast<size_t>(*pos);
       double t = *pos - static_cast<double>(k);
 
-      const Lap *best =
-          best_lap_id_ != -1 ? &resampled_laps_[best_lap_id_] : nullptr;
+      const Lap *best = ResampledLap(best_lap_id_);
       // Resample() emits the crossing of gate k at point index k + 1.
       if (best && k + 2 < best->cum_distances.size()) {
         SetHoverDistance(best->cum_distances[k + 1] * (1 - t) +
@@ -711,7 +789,11 @@ void pacer::DeltaLapsComparision::PlotComparisonMap(const Laps &laps) {
   // the speed/delta plots.
   if (auto d = HoverDistance()) {
     for (int lap_id : lap_ids) {
-      if (auto s = SampleAtDistance(resampled_laps_[lap_id], *d)) {
+      const Lap *lap = ResampledLap(lap_id);
+      if (!lap) {
+        continue;
+      }
+      if (auto s = SampleAtDistance(*lap, *d)) {
         Vec3f p = cs.Local(*s);
         double x = p[0], y = p[1];
         ImPlot::SetNextMarkerStyle(ImPlotMarker_Circle, 6, LapColor(lap_id),
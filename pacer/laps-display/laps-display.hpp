@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -7,6 +9,7 @@
 
 #include "implot.h"
 
+#include <pacer/laps-display/resample-pool.hpp>
 #include <pacer/laps/laps.hpp>
 #include <pacer/reference-track/reference-track.hpp>
 #include <pacer/ui/track-picker.hpp>
@@ -59,6 +62,9 @@ struct LapsDisplay {
 };
 
 struct DeltaLapsComparision {
+  DeltaLapsComparision();
+  ~DeltaLapsComparision();
+
   ReferenceTrack reference_track;
   CoordinateSystem cs;
 
@@ -116,14 +122,34 @@ struct DeltaLapsComparision {
   std::optional<double> HoverDistance() const;
 
 private:
-  /// Re-resamples the selected laps and picks the best lap, at most once per
-  /// frame; both Display and PlotComparisonMap call it so each window works
-  /// on current data even when the other one is not drawn.
+  /// Brings the resampled selected laps up to date and picks the best lap,
+  /// at most once per frame; both Display and PlotComparisonMap call it so
+  /// each window works on current data even when the other one is not
+  /// drawn. Resampling itself runs on background workers: laps missing
+  /// from the cache are queued, and finished ones are picked up here, so
+  /// the views fill in over a few frames instead of stalling one.
   void RefreshResampled(const Laps &laps);
 
-  /// Laps resampled against the reference track, refreshed once per frame
-  /// and shared between the delta plots and the comparison map.
-  std::unordered_map<int, Lap> resampled_laps_;
+  /// Resampled `lap_id` if it's ready, else nullptr.
+  const Lap *ResampledLap(int lap_id) const;
+
+  struct ResampledEntry {
+    ResamplePool::Key key;
+    Lap lap;
+  };
+
+  std::unique_ptr<ResamplePool> pool_;
+
+  /// reference_track as the workers see it; replaced (and the cache
+  /// dropped) whenever reference_track changes.
+  std::shared_ptr<const ResamplePool::Track> resample_track_;
+  uint64_t track_version_ = 0;
+
+  /// Resampled laps by lap id, kept across selection changes; entries whose
+  /// key no longer matches are replaced on the next refresh.
+  std::unordered_map<int, ResampledEntry> resampled_laps_;
+  /// Laps queued or in flight, by lap id.
+  std::unordered_map<int, ResamplePool::Key> pending_;
   int resample_frame_ = -1;
   /// Lap (among selected) with the smallest lap time; -1 when none. Its
   /// cum_distances define the delta plot's x-axis / hover distance domain.
@@ -0,0 +1,72 @@
+#include "resample-pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+std::shared_ptr<const pacer::ResamplePool::Track>
+pacer::ResamplePool::Track::Make(const ReferenceTrack &track,
+                                 uint64_t version) {
+  std::vector<Segment> densified = track.DensifiedGates();
+  GateIndex gates(densified);
+  return std::make_shared<const Track>(Track{
+      .track = track,
+      .densified = std::move(densified),
+      .gates = std::move(gates),
+      .version = version,
+  });
+}
+
+bool pacer::ResamplePool::Track::Matches(const ReferenceTrack &other) const {
+  // Everything Resample() depends on. The frame is compared by its origin:
+  // tracks in different frames differ in their local segments anyway.
+  GPSSample origin = track.cs.Origin(), other_origin = other.cs.Origin();
+  return track.gate_extension_m == other.gate_extension_m &&
+         origin.lat == other_origin.lat && origin.lon == other_origin.lon &&
+         track.segments == other.segments;
+}
+
+pacer::ResamplePool::ResamplePool(unsigned workers) {
+  for (unsigned i = 0; i < workers; ++i) {
+    workers_.emplace_back([this](std::stop_token stop) { Run(stop); });
+  }
+}
+
+unsigned pacer::ResamplePool::DefaultWorkers() {
+  return std::clamp(std::thread::hardware_concurrency(), 2u, 5u) - 1;
+}
+
+void pacer::ResamplePool::Submit(Job job) {
+  {
+    std::lock_guard lock(mutex_);
+    jobs_.push_back(std::move(job));
+  }
+  cv_.notify_one();
+}
+
+void pacer::ResamplePool::DropQueued() {
+  std::lock_guard lock(mutex_);
+  jobs_.clear();
+}
+
+auto pacer::ResamplePool::TakeResults() -> std::vector<Result> {
+  std::lock_guard lock(mutex_);
+  return std::exchange(results_, {});
+}
+
+void pacer::ResamplePool::Run(std::stop_token stop) {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock lock(mutex_);
+      if (!cv_.wait(lock, stop, [&] { return !jobs_.empty(); })) {
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    Lap lap = job.track->track.Resample(job.lap, job.track->gates);
+    std::lock_guard lock(mutex_);
+    results_.push_back(
+        Result{.lap_id = job.lap_id, .key = job.key, .lap = std::move(lap)});
+  }
+}
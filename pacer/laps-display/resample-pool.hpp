@@ -0,0 +1,87 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include <pacer/geometry/gate-index.hpp>
+#include <pacer/laps/laps.hpp>
+#include <pacer/reference-track/reference-track.hpp>
+
+namespace pacer {
+
+// A few worker threads resampling laps off the UI thread. Jobs carry their
+// own copy of the lap and share the track snapshot, so workers never touch
+// Laps or the caller's state.
+class ResamplePool {
+public:
+  /// What the workers resample against: a copy of a reference track with
+  /// its gates densified and indexed once.
+  struct Track {
+    ReferenceTrack track;
+    std::vector<Segment> densified; ///< track.DensifiedGates()
+    GateIndex gates;
+    uint64_t version = 0;
+
+    /// Snapshot of `track`, tagged with `version`.
+    static std::shared_ptr<const Track> Make(const ReferenceTrack &track,
+                                             uint64_t version);
+
+    /// Whether resampling against `other` gives the same laps as against
+    /// this snapshot.
+    bool Matches(const ReferenceTrack &other) const;
+  };
+
+  /// Identifies a resampled lap's contents, see Laps::Version().
+  struct Key {
+    uint64_t track_version = 0;
+    uint64_t laps_version = 0;
+    size_t sample_count = 0;
+
+    bool operator==(const Key &) const = default;
+  };
+
+  struct Job {
+    int lap_id;
+    Key key;
+    Lap lap;
+    std::shared_ptr<const Track> track;
+  };
+
+  struct Result {
+    int lap_id;
+    Key key;
+    Lap lap;
+  };
+
+  /// Starts `workers` threads; by default one per core, leaving a core for
+  /// the UI thread, between 1 and 4.
+  explicit ResamplePool(unsigned workers = DefaultWorkers());
+
+  void Submit(Job job);
+
+  /// Drops jobs no worker has started yet.
+  void DropQueued();
+
+  /// Results finished since the last call, in completion order.
+  std::vector<Result> TakeResults();
+
+  static unsigned DefaultWorkers();
+
+private:
+  void Run(std::stop_token stop);
+
+  std::mutex mutex_;
+  std::condition_variable_any cv_;
+  std::deque<Job> jobs_;
+  std::vector<Result> results_;
+  /// Last, so the workers are stopped and joined before the queues go.
+  std::vector<std::jthread> workers_;
+};
+
+} // namespace pacer
@@ -1,76 +1,99 @@
 #include "laps.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
+#include <optional>
+#include <span>
 
 #include <pacer/datatypes/datatypes.hpp>
+#include <pacer/geometry/crossings.hpp>
 #include <pacer/geometry/geometry.hpp>
 
 void pacer::Laps::Update() {
-  if (!points_dirty_ && sectors.start_line == dirty_start_line_ &&
-      sectors.sector_lines == dirty_sector_lines_)
-    return;
-
-  points_dirty_ = false;
-  dirty_start_line_ = sectors.start_line;
-  dirty_sector_lines_ = sectors.sector_lines;
-
-  laps_.clear();
-  sectors_.clear();
-
-  GPSSample previous;
+  if (needs_resplit_ || sectors.start_line != dirty_start_line_ ||
+      sectors.sector_lines != dirty_sector_lines_) {
+    needs_resplit_ = false;
+    ++version_;
+    dirty_start_line_ = sectors.start_line;
+    dirty_sector_lines_ = sectors.sector_lines;
+
+    // Timing lines live in the local frame; convert them once per change
+    // rather than once per sample.
+    auto to_global = [&](Segment x) -> Segment {
+      auto gps_first = cs_.Global(Vec3f{x.first.x, x.first.y, 0});
+      auto gps_second = cs_.Global(Vec3f{x.second.x, x.second.y, 0});
+      return Segment{.first = {gps_first.lon, gps_first.lat},
+                     .second = {gps_second.lon, gps_second.lat}};
+    };
+    global_start_line_ = to_global(sectors.start_line);
+    global_sector_lines_.clear();
+    for (const Segment &line : sectors.sector_lines) {
+      global_sector_lines_.push_back(to_global(line));
+    }
 
-  int sector_index = -1;
-  auto sector_line = [&] {
-    return sector_index == -1 ? sectors.start_line
-                              : sectors.sector_lines[sector_index];
-  };
+    laps_.clear();
+    sectors_.clear();
+    split_points_ = 0;
+    sector_index_ = -1;
+  }
 
-  auto to_global = [&](Segment x) -> Segment {
-    auto gps_first = cs_.Global(Vec3f{x.first.x, x.first.y, 0});
-    auto gps_second = cs_.Global(Vec3f{x.second.x, x.second.y, 0});
-    return Segment{.first = {gps_first.lon, gps_first.lat},
-                   .second = {gps_second.lon, gps_second.lat}};
+  // Points are append-only between resplits: pick up where the last call
+  // stopped, extending the open lap/sector chunk. Each timing line is
+  // scanned ahead to its next crossing (see FindFirstCrossing()); crossings
+  // are then applied in point order, the start line first on a tie.
+  const double *lon = points_.lon.data(), *lat = points_.lat.data();
+  size_t n = points_.size();
+  auto sector_line = [&]() -> const Segment & {
+    return sector_index_ == -1 ? global_start_line_
+                               : global_sector_lines_[sector_index_];
   };
-
-  for (size_t i = 0; i < points_.size(); ++i) {
-    GPSSample current = points_[i];
-
-    auto lap_split = Split(to_global(sectors.start_line), previous, current);
-    auto sector_split = Split(to_global(sector_line()), previous, current);
-
-    previous = current;
-
-    if (lap_split) {
+  double lap_ratio = 0, sector_ratio = 0;
+  size_t begin = std::max<size_t>(split_points_, 1);
+  size_t lap_at = FindFirstCrossing(global_start_line_, lon, lat, begin,
+                                    std::max(begin, n), &lap_ratio);
+  size_t sector_at = FindFirstCrossing(sector_line(), lon, lat, begin,
+                                       std::max(begin, n), &sector_ratio);
+  while (std::min(lap_at, sector_at) < n) {
+    size_t i = std::min(lap_at, sector_at);
+
+    if (lap_at == i) {
+      GPSSample split = Interpolate(points_[i - 1], points_[i], lap_ratio);
       if (!laps_.empty()) {
-        laps_.back().finish = *lap_split;
+        laps_.back().finish = split;
         laps_.back().finish_index = i;
       }
 
-      laps_.push_back(LapChunk{.start = *lap_split,
-                               .finish = *lap_split,
+      laps_.push_back(LapChunk{.start = split,
+                               .finish = split,
                                .start_index = i,
                                .finish_index = i});
+      lap_at = FindFirstCrossing(global_start_line_, lon, lat, i + 1, n,
+                                 &lap_ratio);
     }
 
-    if (sector_split) {
+    if (sector_at == i) {
+      GPSSample split = Interpolate(points_[i - 1], points_[i], sector_ratio);
       if (!sectors_.empty()) {
-        sectors_.back().finish = *sector_split;
+        sectors_.back().finish = split;
         sectors_.back().finish_index = i;
       }
 
       sectors_.push_back(LapChunk{
-          .start = *sector_split,
-          .finish = *sector_split,
+          .start = split,
+          .finish = split,
           .start_index = i,
           .finish_index = i,
       });
 
-      sector_index += 1;
-      if (sector_index == sectors.sector_lines.size())
-        sector_index = -1;
+      sector_index_ += 1;
+      if (sector_index_ == static_cast<int>(global_sector_lines_.size()))
+        sector_index_ = -1;
+      sector_at =
+          FindFirstCrossing(sector_line(), lon, lat, i + 1, n, &sector_ratio);
     }
   }
+  split_points_ = points_.size();
 }
 
 pacer::Segment pacer::Laps::PickRandomStart() const {
@@ -81,8 +104,8 @@ pacer::Segment pacer::Laps::PickRandomStart() const {
   size_t mid = points_.size() / 2;
   size_t snd_idx = std::min(points_.size() - 1, mid + (size_t)20);
 
-  auto fst = points_[mid];
-  auto snd = points_[snd_idx];
+  GPSSample fst = points_[mid];
+  GPSSample snd = points_[snd_idx];
 
   auto s1 = cs_.Local(fst);
   auto s2 = cs_.Local(snd);
@@ -105,14 +128,11 @@ auto pacer::Laps::MinMax() const -> std::pair<Point, Point> {
   if (points_.empty())
     return {Point{0, 0}, Point{0, 0}};
 
-  Point min{points_[0].lon, points_[0].lat}, max = min;
-  for (const auto &p : points_) {
-    min.x = std::min(min.x, p.lon);
-    max.x = std::max(max.x, p.lon);
-    min.y = std::min(min.y, p.lat);
-    max.y = std::max(max.y, p.lat);
-  }
-  return {min, max};
+  auto [min_lon, max_lon] =
+      std::minmax_element(points_.lon.begin(), points_.lon.end());
+  auto [min_lat, max_lat] =
+      std::minmax_element(points_.lat.begin(), points_.lat.end());
+  return {Point{*min_lon, *min_lat}, Point{*max_lon, *max_lat}};
 }
 
 double pacer::Laps::LapChunk::Time() const {
@@ -193,8 +213,10 @@ pacer::Lap pacer::Laps::GetLap(size_t lap) const {
   if (lap >= laps_.size())
     return {};
   std::vector<GPSSample> points{laps_[lap].start};
-  points.insert(points.end(), points_.begin() + laps_[lap].start_index,
-                points_.begin() + laps_[lap].finish_index);
+  points.reserve(laps_[lap].Count() + 2);
+  for (size_t i = laps_[lap].start_index; i < laps_[lap].finish_index; ++i) {
+    points.push_back(points_[i]);
+  }
   points.push_back(laps_[lap].finish);
   auto l = Lap{.points = points, .cum_distances = {}};
   l.FillDistances(cs_);
@@ -228,9 +250,15 @@ size_t pacer::Laps::LapsCount() const { return laps_.size(); }
 void pacer::Laps::ClearSectors() { sectors.sector_lines.clear(); }
 
 void pacer::Laps::AddPoint(GPSSample s) {
+  Vec3f local = cs_.Local(s);
   if (!points_.empty()) {
     cum_point_dist_.push_back(cum_point_dist_.back() +
-                              cs_.Distance(points_.back(), s));
+                              std::sqrt((local - last_local_).Norm()));
+  }
+  last_local_ = local;
+  if (HasLocalPoints()) {
+    local_x_.push_back(static_cast<float>(local[0]));
+    local_y_.push_back(static_cast<float>(local[1]));
   }
   points_.push_back(s);
 }
@@ -241,31 +269,105 @@ pacer::GPSSample pacer::Laps::GetPoint(size_t row) const {
   return points_[row];
 }
 
+pacer::Point pacer::Laps::LocalPoint(size_t row) const {
+  return Point{local_x_[row], local_y_[row]};
+}
+
+bool pacer::Laps::HasLocalPoints() const { return has_local_; }
+
+void pacer::Laps::KeepLocalPoints(bool keep) {
+  if (keep_local_ == keep) {
+    return;
+  }
+  keep_local_ = keep;
+  // Only SetCoordinateSystem() fills the columns in.
+  has_local_ = false;
+  local_x_ = {};
+  local_y_ = {};
+}
+
 void pacer::Laps::SetCoordinateSystem(CoordinateSystem coordinate_system) {
   cs_ = coordinate_system;
-  // Ensure cum_point_dist_ has the same size as points_ and is initialized
-  cum_point_dist_.assign(points_.size(), 0.0);
-  for (size_t i = 0; i + 1 < points_.size(); ++i) {
-    cum_point_dist_[i + 1] =
-        cum_point_dist_[i] + cs_.Distance(points_[i], points_[i + 1]);
+  has_local_ = keep_local_;
+  // The timing lines are local to cs_, so their global position moved.
+  needs_resplit_ = true;
+
+  // One projection per point serves both the cumulative distances and,
+  // when kept, the local columns.
+  // Never empty, even without points: AddPoint() extends from back().
+  cum_point_dist_.assign(std::max<size_t>(points_.size(), 1), 0.0);
+  local_x_.resize(has_local_ ? points_.size() : 0);
+  local_y_.resize(has_local_ ? points_.size() : 0);
+  // Gathered out of the columns a chunk at a time for cs_.LocalBatch().
+  constexpr size_t kChunk = 256;
+  GPSSample samples[kChunk];
+  Vec3f locals[kChunk];
+  for (size_t begin = 0; begin < points_.size(); begin += kChunk) {
+    size_t count = std::min(kChunk, points_.size() - begin);
+    for (size_t j = 0; j < count; ++j) {
+      samples[j] = points_[begin + j];
+    }
+    cs_.LocalBatch(std::span(samples, count), std::span(locals, count));
+    for (size_t j = 0; j < count; ++j) {
+      size_t i = begin + j;
+      if (i > 0) {
+        cum_point_dist_[i] = cum_point_dist_[i - 1] +
+                             std::sqrt((locals[j] - last_local_).Norm());
+      }
+      if (has_local_) {
+        local_x_[i] = static_cast<float>(locals[j][0]);
+        local_y_[i] = static_cast<float>(locals[j][1]);
+      }
+      last_local_ = locals[j];
+    }
   }
 }
+
+pacer::GPSSample pacer::Laps::PointColumns::operator[](size_t i) const {
+  return GPSSample{
+      .lat = lat[i],
+      .lon = lon[i],
+      .altitude = altitude[i],
+      .full_speed = full_speed[i],
+      .ground_speed = ground_speed[i],
+      .timestamp_ms = timestamp_ms[i],
+  };
+}
+
+void pacer::Laps::PointColumns::push_back(const GPSSample &s) {
+  lat.push_back(s.lat);
+  lon.push_back(s.lon);
+  timestamp_ms.push_back(s.timestamp_ms);
+  altitude.push_back(s.altitude);
+  full_speed.push_back(s.full_speed);
+  ground_speed.push_back(s.ground_speed);
+}
+
+void pacer::Laps::PointColumns::clear() {
+  lat.clear();
+  lon.clear();
+  timestamp_ms.clear();
+  altitude.clear();
+  full_speed.clear();
+  ground_speed.clear();
+}
+
 size_t pacer::Laps::RecordedSectors() const { return sectors_.size(); }
 
 size_t pacer::Lap::Count() const { return points.size(); }
 
 void pacer::Lap::FillDistances(const CoordinateSystem &cs) {
-  cum_distances = std::vector<double>{0};
-  for (size_t i = 1; i < points.size(); ++i) {
-    cum_distances.push_back(cum_distances.back() +
-                            cs.Distance(points[i - 1], points[i]));
-  }
+  cum_distances.resize(std::max<size_t>(points.size(), 1));
+  cum_distances[0] = 0;
+  cs.CumulativeDistances(points, std::span(cum_distances).first(points.size()));
 }
 double pacer::Lap::LapTime() const {
   return (points.back().timestamp_ms - points.front().timestamp_ms) / 1000.0;
 }
 void pacer::Laps::ClearPoints() {
   points_.clear();
+  local_x_.clear();
+  local_y_.clear();
   // keep a single zero entry so AddPoint and SetCoordinateSystem behave
   // consistently (cum_point_dist_[0] == 0)
   cum_point_dist_.assign(1, 0.0);
@@ -274,5 +376,7 @@ void pacer::Laps::ClearPoints() {
   // re-applied unchanged (their frame can outlive the data now).
   laps_.clear();
   sectors_.clear();
-  points_dirty_ = true;
+  split_points_ = 0;
+  needs_resplit_ = true;
+  ++version_;
 }
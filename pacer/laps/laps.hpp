@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 #include <pacer/datatypes/datatypes.hpp>
@@ -26,9 +27,18 @@ struct Sectors {
 };
 
 struct Laps {
-  /// Updates all laps given updated start_line and sector_lines
+  /// Updates all laps given updated start_line and sector_lines. Cheap when
+  /// only points were appended since the last call: just the new points are
+  /// split, extending the last open lap and sector. A change of timing
+  /// lines, coordinate system or ClearPoints() re-splits everything.
   void Update();
 
+  /// Bumped whenever existing laps may have changed: on every re-split and
+  /// on ClearPoints(). In between, Update() only appends laps and closes
+  /// the open one, so (Version(), lap, SampleCount(lap)) identifies a lap's
+  /// contents — e.g. for caching work derived from GetLap().
+  uint64_t Version() const { return version_; }
+
   /// Picks a starting point for start_line.
   /// Default implementation builds segment perpendicular to median segment.
   Segment PickRandomStart() const;
@@ -73,6 +83,20 @@ struct Laps {
   GPSSample GetPoint(size_t row) const;
   void ClearPoints();
 
+  /// Also keep every point projected into the frame passed to
+  /// SetCoordinateSystem(), as float32 x/y columns for LocalPoint(). Off by
+  /// default: a point costs 48 bytes in its columns plus 8 for the
+  /// cumulative distance, and local points add another 8. Takes effect
+  /// from the next SetCoordinateSystem() on; turning it off frees them.
+  void KeepLocalPoints(bool keep);
+
+  /// Point `row` in the frame last passed to SetCoordinateSystem(), kept
+  /// as float32 alongside the samples (sub-millimeter over a track). Only
+  /// valid while HasLocalPoints(): after KeepLocalPoints(true) and a
+  /// SetCoordinateSystem().
+  Point LocalPoint(size_t row) const;
+  bool HasLocalPoints() const;
+
 private:
   struct LapChunk {
     GPSSample start, finish;
@@ -82,19 +106,51 @@ private:
     size_t Count() const { return finish_index - start_index; }
   };
 
+  // Structure-of-arrays point storage: the split, bounds and distance loops
+  // each stream through just the columns they read. Every column keeps the
+  // GPSSample type, so GetPoint() returns exactly what AddPoint() was given.
+  struct PointColumns {
+    std::vector<double> lat, lon;
+    std::vector<int64_t> timestamp_ms;
+    std::vector<double> altitude, full_speed, ground_speed;
+
+    size_t size() const { return lat.size(); }
+    bool empty() const { return lat.empty(); }
+    GPSSample operator[](size_t i) const;
+    void push_back(const GPSSample &s);
+    void clear();
+  };
+
   CoordinateSystem cs_;
 
-  std::vector<GPSSample> points_;
+  PointColumns points_;
   std::vector<double> cum_point_dist_{0};
+  /// points_ in cs_ while has_local_, see LocalPoint(); only filled in by
+  /// SetCoordinateSystem() while keep_local_.
+  bool keep_local_ = false;
+  bool has_local_ = false;
+  std::vector<float> local_x_, local_y_;
+  /// cs_.Local() of the last point, so AddPoint() projects each point once.
+  Vec3f last_local_;
 
   std::vector<LapChunk> laps_;
   std::vector<LapChunk> sectors_;
 
   Segment dirty_start_line_ = {};
   std::vector<Segment> dirty_sector_lines_ = {};
-  // Set by ClearPoints so Update() re-splits even when the timing lines are
-  // re-applied unchanged over freshly loaded points.
-  bool points_dirty_ = false;
+  // Set by ClearPoints/SetCoordinateSystem so Update() re-splits even when
+  // the timing lines are re-applied unchanged.
+  bool needs_resplit_ = false;
+  uint64_t version_ = 0;
+
+  /// Timing lines in lon/lat, as of the last resplit.
+  Segment global_start_line_ = {};
+  std::vector<Segment> global_sector_lines_;
+
+  /// Incremental split state: points_[0, split_points_) are already split;
+  /// sector_index_ is the sector line expected next (-1: start line).
+  size_t split_points_ = 0;
+  int sector_index_ = -1;
 };
 
 } // namespace pacer
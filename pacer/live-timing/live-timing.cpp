@@ -1,28 +1,77 @@
 #include "live-timing.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <functional>
 #include <limits>
+#include <utility>
 
 namespace {
 constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
 } // namespace
 
-void pacer::LiveTiming::SetReferenceTrack(const ReferenceTrack &rt,
-                                          SessionConfig cfg) {
+template <typename T>
+void pacer::BasicLiveTiming<T>::SetReferenceTrack(const ReferenceTrack &rt,
+                                                  SessionConfig cfg) {
   cfg_ = cfg;
 
-  gates_.clear();
-  for (const Segment &local : rt.DensifiedGates()) {
-    gates_.push_back(rt.ToGlobal(local));
+  // Gates go through the exact frame once (or come precomputed from a .ptrk
+  // file), into the linearized one every fix is projected into; per sample
+  // it's then plain arithmetic. The exact frame is the track's own, where
+  // the densified gates already live.
+  frame_ = BasicLinearFrame<T>(rt.cs);
+  cs_ = rt.cs;
+  std::vector<BasicSegment<T>> gates;
+  if (cfg_.frame == TimingFrame::kExact) {
+    std::vector<Segment> locals = rt.DensifiedGates();
+    gates.reserve(locals.size());
+    for (const Segment &local : locals) {
+      gates.push_back(BasicSegment<T>{
+          {static_cast<T>(local.first.x), static_cast<T>(local.first.y)},
+          {static_cast<T>(local.second.x), static_cast<T>(local.second.y)},
+      });
+    }
+  } else {
+    std::vector<Segment> globals = rt.DensifiedGlobalGates();
+    gates.reserve(globals.size());
+    for (const Segment &global : globals) {
+      gates.push_back(BasicSegment<T>{
+          frame_.Local(
+              GPSSample{.lat = global.first.y, .lon = global.first.x}),
+          frame_.Local(
+              GPSSample{.lat = global.second.y, .lon = global.second.x}),
+      });
+    }
   }
+  gates_ = BasicGateIndex<T>(std::move(gates));
+  hits_.clear();
+  hits_.reserve(std::min(cfg_.gate_lookahead, gates_.size()));
 
   has_prev_ = false;
   on_lap_ = false;
   next_gate_ = 0;
-  lap_start_time_ = 0;
+  lap_start_ms_ = 0;
   last_recorded_gate_ = 0;
-  current_gate_times_.assign(gates_.size(), kNaN);
-  best_gate_times_.clear();
+
+  // The only allocation besides the gates: none once the caller's storage
+  // is installed and big enough.
+  size_t n = gates_.size();
+  storage_[0] = pending_storage_[0];
+  storage_[1] = pending_storage_[1];
+  external_ = storage_[0].size() >= n && storage_[1].size() >= n;
+  for (std::vector<int32_t> &owned : owned_) {
+    if (external_) {
+      owned.clear();
+      owned.shrink_to_fit();
+    } else {
+      owned.assign(n, kNoTime);
+    }
+  }
+  current_ = 0;
+  has_best_ = false;
+  best_lap_ms_ = 0;
+  std::span<int32_t> current = GateTimes(current_);
+  std::fill(current.begin(), current.end(), kNoTime);
 
   snapshot_ = LiveSnapshot{};
   snapshot_.session_remaining_s = kNaN;
@@ -30,91 +79,121 @@ void pacer::LiveTiming::SetReferenceTrack(const ReferenceTrack &rt,
   snapshot_.last_lap_s = kNaN;
   snapshot_.best_lap_s = kNaN;
   snapshot_.gate_count = gates_.size();
-  session_start_time_ = 0;
+  session_start_ms_ = 0;
+}
+
+template <typename T>
+bool pacer::BasicLiveTiming<T>::SetGateTimeStorage(std::span<int32_t> a,
+                                                   std::span<int32_t> b) {
+  // Overlapping arrays would make the current lap overwrite the best one.
+  std::less<const int32_t *> before;
+  bool overlap = !a.empty() && !b.empty() &&
+                 before(a.data(), b.data() + b.size()) &&
+                 before(b.data(), a.data() + a.size());
+  if (overlap) {
+    a = b = {};
+  }
+  pending_storage_[0] = a;
+  pending_storage_[1] = b;
+  return !overlap;
+}
+
+template <typename T>
+std::span<int32_t> pacer::BasicLiveTiming<T>::GateTimes(int which) {
+  return external_ ? storage_[which].first(gates_.size())
+                   : std::span<int32_t>(owned_[which]);
 }
 
-void pacer::LiveTiming::StartLap(double crossing_time) {
+template <typename T>
+void pacer::BasicLiveTiming<T>::StartLap(int64_t crossing_ms) {
   on_lap_ = true;
-  lap_start_time_ = crossing_time;
+  lap_start_ms_ = crossing_ms;
   next_gate_ = 1 % gates_.size();
   last_recorded_gate_ = 0;
-  current_gate_times_.assign(gates_.size(), kNaN);
-  current_gate_times_[0] = 0;
+  std::span<int32_t> current = GateTimes(current_);
+  std::fill(current.begin(), current.end(), kNoTime);
+  current[0] = 0;
 
   snapshot_.lap_number += 1;
   snapshot_.gates_crossed = 1;
 }
 
-void pacer::LiveTiming::FinishLap(double crossing_time) {
-  double lap_time = crossing_time - lap_start_time_;
+template <typename T>
+void pacer::BasicLiveTiming<T>::FinishLap(int64_t crossing_ms) {
+  int64_t lap_ms = crossing_ms - lap_start_ms_;
 
-  snapshot_.last_lap_s = lap_time;
+  snapshot_.last_lap_s = lap_ms / 1000.0;
 
   // A lap qualifies as the delta reference only with full gate coverage;
   // interpolation fills small skips, so a hole means we lost sync somewhere.
-  bool complete = true;
-  for (double t : current_gate_times_) {
-    if (std::isnan(t)) {
-      complete = false;
-      break;
-    }
-  }
+  std::span<const int32_t> current = GateTimes(current_);
+  bool complete =
+      std::find(current.begin(), current.end(), kNoTime) == current.end();
 
   // Delta at the line is against the best as it stood when the lap was
   // driven, so a new best flashes negative rather than 0.00.
-  if (!best_gate_times_.empty()) {
-    snapshot_.delta_s = lap_time - snapshot_.best_lap_s;
+  if (has_best_) {
+    snapshot_.delta_s = (lap_ms - best_lap_ms_) / 1000.0;
     snapshot_.delta_valid = true;
   }
 
-  if (complete &&
-      (std::isnan(snapshot_.best_lap_s) || lap_time < snapshot_.best_lap_s)) {
-    best_gate_times_ = current_gate_times_;
-    snapshot_.best_lap_s = lap_time;
+  if (complete && (!has_best_ || lap_ms < best_lap_ms_)) {
+    // The lap just finished becomes the best; the old best's buffer is
+    // reused for the next lap, which StartLap() clears.
+    current_ = 1 - current_;
+    has_best_ = true;
+    best_lap_ms_ = lap_ms;
+    snapshot_.best_lap_s = lap_ms / 1000.0;
   }
 }
 
-void pacer::LiveTiming::RecordGate(size_t gate, double crossing_time) {
-  double rel = crossing_time - lap_start_time_;
+template <typename T>
+void pacer::BasicLiveTiming<T>::RecordGate(size_t gate, int64_t crossing_ms) {
+  int32_t rel = static_cast<int32_t>(crossing_ms - lap_start_ms_);
+  std::span<int32_t> current = GateTimes(current_);
 
   // Fill gates skipped since the last recorded one by linear interpolation,
   // so a glitchy sample can't leave holes in the reference lap.
   size_t prev = last_recorded_gate_;
   size_t skipped = (gate + gates_.size() - prev) % gates_.size();
-  double prev_rel = current_gate_times_[prev];
+  int64_t prev_rel = current[prev];
   for (size_t k = 1; k < skipped; ++k) {
     size_t idx = (prev + k) % gates_.size();
-    double ratio = static_cast<double>(k) / static_cast<double>(skipped);
-    current_gate_times_[idx] = prev_rel + (rel - prev_rel) * ratio;
+    current[idx] = static_cast<int32_t>(
+        prev_rel + (rel - prev_rel) * static_cast<int64_t>(k) /
+                       static_cast<int64_t>(skipped));
   }
 
-  current_gate_times_[gate] = rel;
+  current[gate] = rel;
   last_recorded_gate_ = gate;
 
   snapshot_.gates_crossed = gate + 1;
-  if (gate < best_gate_times_.size()) {
-    snapshot_.delta_s = rel - best_gate_times_[gate];
+  if (has_best_) {
+    snapshot_.delta_s = (rel - GateTimes(1 - current_)[gate]) / 1000.0;
     snapshot_.delta_valid = true;
   }
 }
 
-void pacer::LiveTiming::OnSample(GPSSample s) {
-  double t = s.timestamp_ms / 1000.0;
+template <typename T>
+void pacer::BasicLiveTiming<T>::OnSample(GPSSample s) {
+  int64_t t = s.timestamp_ms;
   snapshot_.speed_mps = s.full_speed;
 
   if (!snapshot_.session_started && s.full_speed > cfg_.start_speed_mps) {
     snapshot_.session_started = true;
-    session_start_time_ = t;
+    session_start_ms_ = t;
   }
   if (snapshot_.session_started) {
     snapshot_.session_remaining_s =
-        cfg_.session_length_s - (t - session_start_time_);
+        cfg_.session_length_s - (t - session_start_ms_) / 1000.0;
   }
 
   GPSSample cur = s;
+  BasicPoint<T> cur_local = Project(cur);
   if (!has_prev_ || gates_.empty()) {
     has_prev_ = !gates_.empty();
     prev_ = cur;
+    prev_local_ = cur_local;
     return;
   }
 
@@ -123,120 +202,131 @@ void pacer::LiveTiming::OnSample(GPSSample s) {
   // lower than start_speed_mps: walking a track for a test must still lap.)
   if (s.full_speed < cfg_.min_crossing_speed_mps) {
     prev_ = cur;
+    prev_local_ = cur_local;
     return;
   }
 
   if (!on_lap_) {
     // Out lap: nothing to time until the start line is crossed.
-    if (auto split = Split(gates_[0], prev_, cur)) {
-      StartLap(split->timestamp_ms / 1000.0);
+    if (const BasicSegmentHit<T> *hit = FirstCrossing(0, 1, cur_local)) {
+      StartLap(CrossingTimeMs(cur, hit->ratio));
     }
   } else {
     // At 25 Hz a kart covers a couple of meters per sample, so one interval
     // can cross several ~1 m gates; keep consuming crossings until none of
     // the upcoming gates intersects this segment. Gates are ordered along
     // the track, so the first hit in the window is the next one crossed.
-    bool found = true;
-    while (found) {
-      found = false;
-      size_t window = std::min(cfg_.gate_lookahead, gates_.size());
-      for (size_t k = 0; k < window; ++k) {
-        size_t idx = (next_gate_ + k) % gates_.size();
-        auto split = Split(gates_[idx], prev_, cur);
-        if (!split) {
-          continue;
-        }
-        double crossing_time = split->timestamp_ms / 1000.0;
-        if (idx == 0) {
-          FinishLap(crossing_time);
-          StartLap(crossing_time);
-        } else {
-          RecordGate(idx, crossing_time);
-          next_gate_ = (idx + 1) % gates_.size();
-        }
-        found = true;
+    size_t n = gates_.size();
+    while (true) {
+      size_t window = std::min(cfg_.gate_lookahead, n);
+      size_t end = std::min(next_gate_ + window, n);
+      const BasicSegmentHit<T> *hit =
+          FirstCrossing(next_gate_, end, cur_local);
+      if (!hit && next_gate_ + window > n) { // window wraps past gate 0
+        hit = FirstCrossing(0, next_gate_ + window - n, cur_local);
+      }
+      if (!hit) {
         break;
       }
+      size_t idx = hit->index;
+      int64_t crossing_ms = CrossingTimeMs(cur, hit->ratio);
+      if (idx == 0) {
+        FinishLap(crossing_ms);
+        StartLap(crossing_ms);
+      } else {
+        RecordGate(idx, crossing_ms);
+        next_gate_ = (idx + 1) % n;
+      }
     }
 
     // Resync guard: whatever the gate tracker thinks, a start-line crossing
     // after a plausible lap time always closes the lap.
-    if (t - lap_start_time_ > cfg_.min_lap_s &&
-        next_gate_ != 1 % gates_.size()) {
-      size_t window = std::min(cfg_.gate_lookahead, gates_.size());
-      bool zero_in_window =
-          next_gate_ + window > gates_.size(); // window wraps past gate 0
+    if (t - lap_start_ms_ > cfg_.min_lap_s * 1000 && next_gate_ != 1 % n) {
+      size_t window = std::min(cfg_.gate_lookahead, n);
+      bool zero_in_window = next_gate_ + window > n;
       if (!zero_in_window) {
-        if (auto split = Split(gates_[0], prev_, cur)) {
-          FinishLap(split->timestamp_ms / 1000.0);
-          StartLap(split->timestamp_ms / 1000.0);
+        if (const BasicSegmentHit<T> *hit = FirstCrossing(0, 1, cur_local)) {
+          int64_t crossing_ms = CrossingTimeMs(cur, hit->ratio);
+          FinishLap(crossing_ms);
+          StartLap(crossing_ms);
         }
       }
     }
   }
 
   if (on_lap_) {
-    snapshot_.current_lap_s = t - lap_start_time_;
+    snapshot_.current_lap_s = (t - lap_start_ms_) / 1000.0;
   }
 
   prev_ = cur;
+  prev_local_ = cur_local;
+}
+
+template <typename T>
+const pacer::BasicSegmentHit<T> *
+pacer::BasicLiveTiming<T>::FirstCrossing(size_t begin, size_t end,
+                                         BasicPoint<T> cur_local) {
+  hits_.clear();
+  FindCrossings(gates_.Batch(), begin, end, prev_local_, cur_local, &hits_);
+  return hits_.empty() ? nullptr : &hits_.front();
+}
+
+template <typename T>
+int64_t pacer::BasicLiveTiming<T>::CrossingTimeMs(const GPSSample &cur,
+                                                  T ratio) const {
+  // Same rounding as pacer::Interpolate(prev_, cur, ratio).timestamp_ms; the
+  // step between fixes is small enough to be exact in T.
+  int64_t ms = prev_.timestamp_ms +
+               static_cast<int64_t>(std::llround(
+                   static_cast<T>(cur.timestamp_ms - prev_.timestamp_ms) *
+                   ratio));
+  return ms;
 }
 
-double pacer::LiveTiming::DistanceToNextLine(const GPSSample &s) const {
+template <typename T>
+pacer::BasicPoint<T>
+pacer::BasicLiveTiming<T>::Project(const GPSSample &s) const {
+  if (cfg_.frame == TimingFrame::kExact) {
+    Vec3f local = cs_.Local(s);
+    return BasicPoint<T>{static_cast<T>(local.x), static_cast<T>(local.y)};
+  }
+  return frame_.Local(s);
+}
+
+template <typename T>
+double pacer::BasicLiveTiming<T>::DistanceToNextLine(const GPSSample &s) const {
   if (gates_.empty()) {
     return kNaN;
   }
-  const Segment &gate = gates_[on_lap_ ? next_gate_ % gates_.size() : 0];
-
-  // Project both gate endpoints into a local metric frame centered on `s`
-  // (so `s` itself is the origin), then take the 2D point-segment distance.
-  CoordinateSystem cs(s);
-  auto local = [&](Point p) {
-    return cs.Local(GPSSample{.lat = p.y, .lon = p.x, .altitude = s.altitude});
-  };
-  Vec3f a = local(gate.first), b = local(gate.second);
-
-  double dx = b[0] - a[0], dy = b[1] - a[1];
-  double len2 = dx * dx + dy * dy;
-  double t = len2 > 0 ? -(a[0] * dx + a[1] * dy) / len2 : 0;
-  t = std::fmin(1.0, std::fmax(0.0, t));
-  double px = a[0] + t * dx, py = a[1] + t * dy;
-  return std::sqrt(px * px + py * py);
+  BasicSegment<T> gate = gates_[on_lap_ ? next_gate_ % gates_.size() : 0];
+  return DistanceToSegment(gate, Project(s));
 }
 
+template <typename T>
 std::optional<pacer::TrackOffset>
-pacer::LiveTiming::OffsetFromTrack(const GPSSample &s) const {
+pacer::BasicLiveTiming<T>::OffsetFromTrack(const GPSSample &s) const {
   if (gates_.empty()) {
     return std::nullopt;
   }
 
-  // Same local-metric-frame trick as DistanceToNextLine: `s` is the origin,
-  // so each gate reduces to an origin-to-segment problem in meters.
-  CoordinateSystem cs(s);
-  auto local = [&](Point p) {
-    return cs.Local(GPSSample{.lat = p.y, .lon = p.x, .altitude = s.altitude});
-  };
+  // One projection into the track frame, then a grid lookup for the nearest
+  // gate instead of measuring all of them.
+  BasicPoint<T> p = Project(s);
+  size_t gate = *gates_.Nearest(p);
+  BasicSegment<T> g = gates_[gate];
+  BasicPoint<T> along = g.second - g.first;
+  T length = std::sqrt(along.Norm());
 
   TrackOffset best;
-  double best_dist = std::numeric_limits<double>::infinity();
-  for (size_t i = 0; i < gates_.size(); ++i) {
-    Vec3f a = local(gates_[i].first), b = local(gates_[i].second);
-    double dx = b[0] - a[0], dy = b[1] - a[1];
-    double len2 = dx * dx + dy * dy;
-    // Unclamped projection parameter: keeps its meaning (0.5 == midpoint)
-    // even when the fix sits outside the gate's extent.
-    double u = len2 > 0 ? -(a[0] * dx + a[1] * dy) / len2 : 0;
-    double t = std::fmin(1.0, std::fmax(0.0, u));
-    double px = a[0] + t * dx, py = a[1] + t * dy;
-    double dist = std::sqrt(px * px + py * py);
-    if (dist < best_dist) {
-      best_dist = dist;
-      double len = std::sqrt(len2);
-      best.gate = i;
-      best.lateral_m = (u - 0.5) * len;
-      best.half_width_m = len / 2;
-      best.distance_m = dist;
-    }
-  }
+  best.gate = gate;
+  best.distance_m = DistanceToSegment(g, p);
+  // Signed offset along the gate direction: keeps its meaning even when the
+  // fix sits outside the gate's extent.
+  BasicPoint<T> mid = (g.first + g.second) / T(2);
+  best.lateral_m = length > 0 ? (p - mid).Scalar(along) / length : 0;
+  best.half_width_m = length / 2;
   return best;
 }
+
+template class pacer::BasicLiveTiming<double>;
+template class pacer::BasicLiveTiming<float>;
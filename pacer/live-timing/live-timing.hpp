@@ -1,10 +1,15 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <optional>
+#include <span>
 #include <vector>
 
 #include <pacer/datatypes/datatypes.hpp>
+#include <pacer/geometry/crossings.hpp>
+#include <pacer/geometry/gate-index.hpp>
 #include <pacer/geometry/geometry.hpp>
 #include <pacer/reference-track/reference-track.hpp>
 
@@ -14,10 +19,35 @@ namespace pacer {
 // ReferenceTrack::Resample(): consumes a live 25 Hz GPS stream and keeps
 // current/last/best lap times plus a running delta to the session-best lap,
 // measured at the same densified gates Resample() uses. Holds no point
-// history — memory is two gate-time arrays — so it runs happily on an ESP32.
+// history — memory is the gates plus two gate-time arrays — so it runs
+// happily on an ESP32. Gate times are int32 milliseconds, optionally in
+// storage the caller provides (SetGateTimeStorage()); once
+// SetReferenceTrack() returns, nothing touches the heap.
 //
-// Single-threaded by design: call OnSample() and Snapshot() from one thread,
-// or guard externally (the firmware copies Snapshot() under a mutex).
+// By default gates live in a linearized (equirectangular) frame of the
+// track, with their normals, midpoints and lengths precomputed; each fix is
+// projected into it once with a few multiply-adds, so the per-sample path has
+// no trig. The frame is affine in lon/lat, so crossing ratios (and thus lap
+// and gate times) match intersecting raw lon/lat points up to rounding.
+// SessionConfig::frame selects the track's exact frame instead.
+//
+// Single-threaded by design: call OnSample() and Snapshot() from one thread.
+// To show it elsewhere, hand Snapshot() over by value — the firmware's
+// timing task publishes it to the UI task through a TripleBuffer.
+//
+// T is the geometry scalar: the desktop times in double, the ESP32-S3 (whose
+// FPU is single precision only) in float — the track frame spans a few km,
+// well within float's reach. Clock arithmetic is integer milliseconds either
+// way: a float can't hold a GPS time of week to the millisecond.
+
+/// Frame the gates live in and every fix is projected into.
+enum class TimingFrame {
+  /// BasicLinearFrame of the track's CoordinateSystem: no trig per fix.
+  kLinearized,
+  /// The track's CoordinateSystem itself (ReferenceTrack::cs::Local()):
+  /// several sin/cos per fix, for checking the linearized frame against.
+  kExact,
+};
 
 struct SessionConfig {
   /// Timed-session length; the countdown starts the first time speed
@@ -41,6 +71,8 @@ struct SessionConfig {
   /// glitchy fix can skip a few gates, and skipped gate times are filled by
   /// interpolation.
   size_t gate_lookahead = 12;
+
+  TimingFrame frame = TimingFrame::kLinearized;
 };
 
 struct LiveSnapshot {
@@ -87,9 +119,21 @@ struct TrackOffset {
   double distance_m = 0; ///< ground distance to the gate segment itself
 };
 
-class LiveTiming {
+template <typename T> class BasicLiveTiming {
 public:
-  LiveTiming() = default;
+  /// Gate-time value for a gate not (yet) crossed on the lap.
+  static constexpr int32_t kNoTime = std::numeric_limits<int32_t>::min();
+
+  BasicLiveTiming() = default;
+
+  /// Caller-owned gate-time arrays (current lap and best lap; which is which
+  /// swaps as laps improve), used from the next SetReferenceTrack() on; the
+  /// track installed now keeps the arrays it has. Each must hold one int32
+  /// per densified gate, or that track falls back to heap arrays sized for
+  /// it. The spans must outlive their use here; pass empty spans to go back
+  /// to owned arrays. Returns false, and goes back to owned arrays, if `a`
+  /// and `b` overlap.
+  bool SetGateTimeStorage(std::span<int32_t> a, std::span<int32_t> b);
 
   /// Resets all session state and installs the track. Gate 0 of
   /// rt.DensifiedGates() (== segments[0], the start/finish line) both starts
@@ -109,34 +153,73 @@ public:
   double DistanceToNextLine(const GPSSample &s) const;
 
   /// Offset of `s` relative to the nearest densified gate (see TrackOffset).
-  /// Scans every gate, so call it at UI rate — not per 25 Hz sample — and
-  /// only while someone is looking. nullopt when no track is installed.
+  /// A grid lookup over the gates near `s` (see GateIndex), cheap enough
+  /// for every 25 Hz sample. nullopt when no track is installed.
   std::optional<TrackOffset> OffsetFromTrack(const GPSSample &s) const;
 
 private:
-  void StartLap(double crossing_time);
-  void FinishLap(double crossing_time);
-  void RecordGate(size_t gate, double crossing_time);
+  void StartLap(int64_t crossing_ms);
+  void FinishLap(int64_t crossing_ms);
+  void RecordGate(size_t gate, int64_t crossing_ms);
+
+  /// Gate-time array 0 or 1, one entry per gate.
+  std::span<int32_t> GateTimes(int which);
 
   SessionConfig cfg_;
 
-  /// Densified gates in the global (lon/lat) frame, ready for Split().
-  std::vector<Segment> gates_;
+  /// First of gates [begin, end) crossed by prev_local_ -> cur_local, in
+  /// gate order; nullptr if none. Points into hits_, valid until the next
+  /// call.
+  const BasicSegmentHit<T> *FirstCrossing(size_t begin, size_t end,
+                                          BasicPoint<T> cur_local);
+
+  /// Timestamp (ms) at `ratio` along prev_ -> cur.
+  int64_t CrossingTimeMs(const GPSSample &cur, T ratio) const;
+
+  /// `s` in the gates' frame; every fix is projected exactly once.
+  BasicPoint<T> Project(const GPSSample &s) const;
+
+  /// Linearized track frame, used unless cfg_.frame is kExact.
+  BasicLinearFrame<T> frame_;
+  /// The track's exact frame, for TimingFrame::kExact.
+  CoordinateSystem cs_;
+
+  /// Densified gates in frame_, indexed for nearest-gate lookups.
+  BasicGateIndex<T> gates_;
+  /// Scratch for FirstCrossing(), sized once per track.
+  std::vector<BasicSegmentHit<T>> hits_;
 
   bool has_prev_ = false;
   GPSSample prev_;
+  BasicPoint<T> prev_local_; ///< prev_ in frame_
 
   bool on_lap_ = false;
   size_t next_gate_ = 0; ///< next expected gate index while on a lap
-  double lap_start_time_ = 0;
+  int64_t lap_start_ms_ = 0;
   size_t last_recorded_gate_ = 0;
 
-  /// Per-gate times relative to lap start; NaN where not (yet) crossed.
-  std::vector<double> current_gate_times_;
-  std::vector<double> best_gate_times_;
+  /// Per-gate times (ms) relative to lap start; kNoTime where not (yet)
+  /// crossed. Array current_ is the lap being driven and 1 - current_ the
+  /// best lap (once has_best_); a new best is promoted by flipping current_.
+  /// They live in storage_ when external_, else in owned_.
+  std::span<int32_t> storage_[2];
+  /// SetGateTimeStorage()'s spans, taken into storage_ by the next
+  /// SetReferenceTrack().
+  std::span<int32_t> pending_storage_[2];
+  std::vector<int32_t> owned_[2];
+  bool external_ = false;
+  int current_ = 0;
+  bool has_best_ = false;
+  int64_t best_lap_ms_ = 0;
 
   LiveSnapshot snapshot_;
-  double session_start_time_ = 0;
+  int64_t session_start_ms_ = 0;
 };
 
+using LiveTiming = BasicLiveTiming<double>;
+using LiveTimingF = BasicLiveTiming<float>;
+
+extern template class BasicLiveTiming<double>;
+extern template class BasicLiveTiming<float>;
+
 } // namespace pacer
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace pacer {
+
+// Single-writer, single-reader "latest value" mailbox: the writer publishes
+// whole values, the reader always gets the most recent complete one. Three
+// slots — one being written, one being read, one holding the newest
+// published value — so neither side ever waits on the other and a stalled
+// reader can't hold the writer back (it just misses intermediate values).
+//
+// Built for handing LiveSnapshot from the timing task to the UI task on the
+// ESP32: both Publish() and Read() are a single atomic exchange, no locks.
+template <typename T> class TripleBuffer {
+public:
+  TripleBuffer() = default;
+  TripleBuffer(const TripleBuffer &) = delete;
+  TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+  /// Writer: the slot the next Publish() hands over. Not seen by the reader
+  /// until then, so it can be filled in place.
+  T &Back() { return slots_[back_]; }
+
+  /// Writer: makes Back() the latest value; Back() becomes another slot,
+  /// holding stale contents.
+  void Publish() {
+    uint8_t prev = middle_.exchange(static_cast<uint8_t>(back_ | kFresh),
+                                    std::memory_order_acq_rel);
+    back_ = prev & kIndex;
+  }
+
+  void Publish(const T &value) {
+    Back() = value;
+    Publish();
+  }
+
+  /// Reader: true if a value newer than the last Read() is waiting.
+  bool Fresh() const {
+    return middle_.load(std::memory_order_acquire) & kFresh;
+  }
+
+  /// Reader: the latest published value (default-constructed T before the
+  /// first Publish()). The reference stays valid and unchanged until the
+  /// next Read().
+  const T &Read() {
+    if (Fresh()) {
+      uint8_t prev = middle_.exchange(front_, std::memory_order_acq_rel);
+      front_ = prev & kIndex;
+    }
+    return slots_[front_];
+  }
+
+private:
+  static constexpr uint8_t kIndex = 0x3, kFresh = 0x4;
+
+  T slots_[3]{};
+  uint8_t back_ = 0;  ///< writer-owned slot
+  uint8_t front_ = 1; ///< reader-owned slot
+  /// Index of the slot in between, plus kFresh if the writer put it there
+  /// after the reader's last swap.
+  std::atomic<uint8_t> middle_{2};
+};
+
+} // namespace pacer
@@ -1,9 +1,13 @@
 #include "reference-track.hpp"
 
 #include <algorithm>
+#include <cctype>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 
 #include <nlohmann/json.hpp>
@@ -67,6 +71,98 @@ DensifyGates(const std::vector<pacer::Segment> &gates) {
   return dense;
 }
 
+// .ptrk header; the arrays follow back to back in the order of the counts
+// (segments, local gates, global gates, sector indices), so every one stays
+// 8-byte aligned for a reader that maps the file.
+constexpr char kBinaryMagic[8] = {'P', 'A', 'C', 'E', 'R', 'T', 'R', 'K'};
+constexpr uint32_t kBinaryVersion = 1;
+
+struct BinaryHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t segment_count;
+  uint32_t gate_count;
+  uint32_t sector_count;
+  double origin_lat, origin_lon, origin_altitude;
+  double extension_m;
+};
+
+static_assert(sizeof(BinaryHeader) == 56);
+static_assert(sizeof(pacer::Segment) == 32 &&
+              std::is_trivially_copyable_v<pacer::Segment>);
+
+// One ~1 m gate per meter: far more than any circuit, so a larger count is a
+// corrupt header rather than a reason to allocate.
+constexpr uint32_t kMaxBinaryGates = 1'000'000;
+
+bool IsBinaryPath(const std::string &filename) {
+  if (filename.size() < 5) {
+    return false;
+  }
+  std::string ext = filename.substr(filename.size() - 5);
+  for (char &c : ext) {
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+  return ext == ".ptrk";
+}
+
+template <typename T>
+bool ReadArray(FILE *f, std::vector<T> *out, uint32_t count) {
+  out->resize(count);
+  return count == 0 || std::fread(out->data(), sizeof(T), count, f) == count;
+}
+
+template <typename T> bool WriteArray(FILE *f, const std::vector<T> &v) {
+  return v.empty() || std::fwrite(v.data(), sizeof(T), v.size(), f) == v.size();
+}
+
+pacer::ReferenceTrack FromBinaryFile(const std::string &filename) {
+  FILE *f = std::fopen(filename.c_str(), "rb");
+  if (!f) {
+    throw std::runtime_error("Unable to open file: " + filename);
+  }
+  pacer::ReferenceTrack track;
+  BinaryHeader header;
+  std::vector<int32_t> sectors;
+  bool ok = std::fread(&header, sizeof(header), 1, f) == 1 &&
+            std::memcmp(header.magic, kBinaryMagic, sizeof(kBinaryMagic)) ==
+                0 &&
+            header.version == kBinaryVersion &&
+            header.segment_count <= kMaxBinaryGates &&
+            header.gate_count <= kMaxBinaryGates &&
+            header.sector_count <= header.segment_count;
+  // The counts must account for the file exactly before anything is
+  // allocated for them: a truncated or padded file is rejected up front.
+  uint64_t records = uint64_t{header.segment_count} + 2 * header.gate_count;
+  uint64_t expected = sizeof(BinaryHeader) + sizeof(pacer::Segment) * records +
+                      sizeof(int32_t) * header.sector_count;
+  ok = ok && std::fseek(f, 0, SEEK_END) == 0 &&
+       static_cast<uint64_t>(std::ftell(f)) == expected &&
+       std::fseek(f, sizeof(BinaryHeader), SEEK_SET) == 0;
+  ok = ok && ReadArray(f, &track.segments, header.segment_count) &&
+       ReadArray(f, &track.precomputed.local, header.gate_count) &&
+       ReadArray(f, &track.precomputed.global, header.gate_count) &&
+       ReadArray(f, &sectors, header.sector_count);
+  std::fclose(f);
+  if (!ok) {
+    throw std::runtime_error("Invalid reference track file: " + filename);
+  }
+
+  if (!track.segments.empty()) {
+    track.cs = pacer::CoordinateSystem(pacer::GPSSample{
+        .lat = header.origin_lat,
+        .lon = header.origin_lon,
+        .altitude = header.origin_altitude,
+    });
+  }
+  track.sector_indices.assign(sectors.begin(), sectors.end());
+  track.gate_extension_m = header.extension_m;
+  track.precomputed.extension_m = header.extension_m;
+  track.precomputed.segments = track.segments;
+  track.precomputed.origin = track.cs.Origin();
+  return track;
+}
+
 } // namespace
 
 size_t pacer::ReferenceTrack::Count() const { return segments.size(); }
@@ -80,6 +176,9 @@ pacer::Segment pacer::ReferenceTrack::TimingLine(size_t index) const {
 }
 
 std::vector<pacer::Segment> pacer::ReferenceTrack::DensifiedGates() const {
+  if (const PrecomputedGates *pre = Precomputed()) {
+    return pre->local;
+  }
   std::vector<Segment> gates;
   gates.reserve(TimingLinesCount());
   for (size_t i = 0; i < TimingLinesCount(); ++i) {
@@ -88,6 +187,44 @@ std::vector<pacer::Segment> pacer::ReferenceTrack::DensifiedGates() const {
   return DensifyGates(gates);
 }
 
+std::vector<pacer::Segment>
+pacer::ReferenceTrack::DensifiedGlobalGates() const {
+  if (const PrecomputedGates *pre = Precomputed()) {
+    return pre->global;
+  }
+  std::vector<Segment> gates = DensifiedGates();
+  for (Segment &gate : gates) {
+    gate = ToGlobalSegment(gate, cs);
+  }
+  return gates;
+}
+
+void pacer::ReferenceTrack::PrecomputeGates() {
+  precomputed = PrecomputedGates{};
+  precomputed.extension_m = gate_extension_m;
+  precomputed.segments = segments;
+  precomputed.origin = cs.Origin();
+  precomputed.local = DensifiedGates();
+  precomputed.global = DensifiedGlobalGates();
+}
+
+const pacer::ReferenceTrack::PrecomputedGates *
+pacer::ReferenceTrack::Precomputed() const {
+  // A full compare of the segments: a few hundred at most, next to the
+  // thousands of gates densifying would build.
+  GPSSample origin = cs.Origin();
+  if (precomputed.local.empty() ||
+      precomputed.global.size() != precomputed.local.size() ||
+      precomputed.extension_m != gate_extension_m ||
+      precomputed.origin.lat != origin.lat ||
+      precomputed.origin.lon != origin.lon ||
+      precomputed.origin.altitude != origin.altitude ||
+      precomputed.segments != segments) {
+    return nullptr;
+  }
+  return &precomputed;
+}
+
 pacer::Segment pacer::ReferenceTrack::ToGlobal(const Segment &local) const {
   return ToGlobalSegment(local, cs);
 }
@@ -96,22 +233,50 @@ pacer::Lap pacer::ReferenceTrack::Resample(const Lap &lap) const {
   if (lap.points.empty()) {
     return lap;
   }
+  return Resample(lap, GateIndex(DensifiedGates()));
+}
+
+pacer::Lap pacer::ReferenceTrack::Resample(const Lap &lap,
+                                           const GateIndex &gates) const {
+  if (lap.points.empty()) {
+    return lap;
+  }
 
-  std::vector<Segment> dense_gates = DensifiedGates();
+  // Intersect in this track's local frame, where the gates already live:
+  // one projection per lap point instead of converting every gate.
+  std::vector<Vec3f> projected(lap.points.size());
+  cs.LocalBatch(lap.points, projected);
+  std::vector<Point> local;
+  local.reserve(projected.size());
+  for (const Vec3f &p : projected) {
+    local.push_back(ToPoint(p));
+  }
 
   Lap result{.points = {lap.points.front()}};
 
-  for (size_t i_gate = 0, i_lap = 1; i_gate < dense_gates.size(); ++i_gate) {
+  // Gates are consumed in order, each at the first lap segment (from the
+  // current one on) that crosses it; a segment may cross several ~1 m gates,
+  // so its crossings are cached until the walk moves past it.
+  std::vector<GateIndex::Crossing> crossings;
+  size_t crossings_of = 0; // lap segment `crossings` belongs to; 0 == none
+  for (size_t i_gate = 0, i_lap = 1; i_gate < gates.size(); ++i_gate) {
     if (i_lap >= lap.points.size()) {
       break;
     }
-    Segment timing_line = ToGlobalSegment(dense_gates[i_gate], cs);
 
     while (i_lap < lap.points.size()) {
-      auto split_point =
-          pacer::Split(timing_line, lap.points[i_lap - 1], lap.points[i_lap]);
-      if (split_point) {
-        result.points.push_back(*split_point);
+      if (crossings_of != i_lap) {
+        gates.Crossings(local[i_lap - 1], local[i_lap], &crossings);
+        crossings_of = i_lap;
+      }
+      auto hit = std::lower_bound(
+          crossings.begin(), crossings.end(), i_gate,
+          [](const GateIndex::Crossing &c, size_t gate) {
+            return c.index < gate;
+          });
+      if (hit != crossings.end() && hit->index == i_gate) {
+        result.points.push_back(pacer::Interpolate(
+            lap.points[i_lap - 1], lap.points[i_lap], hit->ratio));
         break;
       }
       ++i_lap;
@@ -132,13 +297,16 @@ pacer::ReferenceTrack::FromLap(const Lap &lap, float width,
     return track;
   }
 
+  std::vector<Vec3f> local(lap.points.size());
+  cs.LocalBatch(lap.points, local);
+
   size_t count = lap.points.size() - 2;
   track.segments.reserve(count);
   for (size_t i = 0; i < count; ++i) {
     size_t idx = i + 1;
-    Vec3f prev = cs.Local(lap.points[idx - 1]);
-    Vec3f curr = cs.Local(lap.points[idx]);
-    Vec3f next = cs.Local(lap.points[idx + 1]);
+    Vec3f prev = local[idx - 1];
+    Vec3f curr = local[idx];
+    Vec3f next = local[idx + 1];
 
     Vec3f dir = (next - prev);
     dir /= std::sqrt(dir.Norm());
@@ -152,6 +320,9 @@ pacer::ReferenceTrack::FromLap(const Lap &lap, float width,
 
 pacer::ReferenceTrack
 pacer::ReferenceTrack::FromFile(const std::string &filename) {
+  if (IsBinaryPath(filename)) {
+    return FromBinaryFile(filename);
+  }
   std::ifstream file(filename);
   if (!file.is_open()) {
     throw std::runtime_error("Unable to open file: " + filename);
@@ -198,16 +369,56 @@ pacer::ReferenceTrack::FromFile(const std::string &filename) {
   }
 
   track.cs = CoordinateSystem(raw.front().first);
-  track.segments.reserve(raw.size());
+  std::vector<GPSSample> ends;
+  ends.reserve(2 * raw.size());
   for (const auto &[a, b] : raw) {
+    ends.push_back(a);
+    ends.push_back(b);
+  }
+  std::vector<Vec3f> local(ends.size());
+  track.cs.LocalBatch(ends, local);
+  track.segments.reserve(raw.size());
+  for (size_t i = 0; i < raw.size(); ++i) {
     track.segments.push_back(
-        Segment{ToPoint(track.cs.Local(a)), ToPoint(track.cs.Local(b))});
+        Segment{ToPoint(local[2 * i]), ToPoint(local[2 * i + 1])});
   }
 
   return track;
 }
 
 void pacer::ReferenceTrack::SaveToFile(const std::string &filename) const {
+  if (IsBinaryPath(filename)) {
+    std::vector<Segment> local = DensifiedGates();
+    std::vector<Segment> global = DensifiedGlobalGates();
+    std::vector<int32_t> sectors(sector_indices.begin(), sector_indices.end());
+
+    BinaryHeader header{};
+    std::memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic));
+    header.version = kBinaryVersion;
+    header.segment_count = static_cast<uint32_t>(segments.size());
+    header.gate_count = static_cast<uint32_t>(local.size());
+    header.sector_count = static_cast<uint32_t>(sectors.size());
+    if (!segments.empty()) {
+      GPSSample origin = cs.Origin();
+      header.origin_lat = origin.lat;
+      header.origin_lon = origin.lon;
+      header.origin_altitude = origin.altitude;
+    }
+    header.extension_m = gate_extension_m;
+
+    FILE *f = std::fopen(filename.c_str(), "wb");
+    if (!f) {
+      throw std::runtime_error("Unable to write file: " + filename);
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+              WriteArray(f, segments) && WriteArray(f, local) &&
+              WriteArray(f, global) && WriteArray(f, sectors);
+    if (std::fclose(f) != 0 || !ok) {
+      throw std::runtime_error("Unable to write file: " + filename);
+    }
+    return;
+  }
+
   nlohmann::json json;
   json["segments"] = nlohmann::json::array();
   for (const auto &seg : segments) {
@@ -224,6 +435,16 @@ void pacer::ReferenceTrack::SaveToFile(const std::string &filename) const {
   file << json.dump(2);
 }
 
+std::string pacer::ReferenceTrack::BinaryPath(const std::string &filename) {
+  size_t dot = filename.find_last_of('.');
+  size_t slash = filename.find_last_of("/\\");
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) {
+    return filename + ".ptrk";
+  }
+  return filename.substr(0, dot) + ".ptrk";
+}
+
 pacer::Sectors
 pacer::ReferenceTrack::BuildSectors(const CoordinateSystem &target_cs) const {
   Sectors result;
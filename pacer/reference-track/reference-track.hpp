@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 
+#include <pacer/geometry/gate-index.hpp>
 #include <pacer/geometry/geometry.hpp>
 #include <pacer/laps/laps.hpp>
 
@@ -20,8 +21,9 @@ struct ReferenceTrack {
 
   /// How far TimingLine() extends each gate past both annotated edges, in
   /// meters, so the gate still catches a driven lap that strays slightly
-  /// outside the annotated track boundary. Runtime-only (not saved to the
-  /// track file); tune it in the timeline's reference track loader.
+  /// outside the annotated track boundary. Not in the JSON track file; a
+  /// .ptrk file keeps the value its gates were built with and loads it back.
+  /// Tune it in the timeline's reference track loader.
   double gate_extension_m = 2.0;
 
   size_t Count() const;
@@ -30,6 +32,18 @@ struct ReferenceTrack {
   /// Returns segments[index] extended gate_extension_m past each edge.
   Segment TimingLine(size_t index) const;
 
+  /// DensifiedGates() and DensifiedGlobalGates() as of the segments, frame
+  /// origin and gate_extension_m they were built from. A .ptrk file stores
+  /// them, so a track loaded from one skips densifying and the per-endpoint
+  /// trig.
+  struct PrecomputedGates {
+    double extension_m = 0;
+    std::vector<Segment> segments;
+    GPSSample origin;
+    std::vector<Segment> local, global;
+  };
+  PrecomputedGates precomputed;
+
   /// All TimingLine()s densified to roughly one synthetic gate per meter
   /// (linearly interpolated between each annotated pair), in this track's
   /// local frame. Gate 0 is the start/finish line. Both Resample() and the
@@ -37,6 +51,18 @@ struct ReferenceTrack {
   /// their deltas agree.
   std::vector<Segment> DensifiedGates() const;
 
+  /// DensifiedGates() converted with ToGlobal(), the frame the live-timing
+  /// engine reads them in.
+  std::vector<Segment> DensifiedGlobalGates() const;
+
+  /// Fills `precomputed` for the current segments, frame and
+  /// gate_extension_m.
+  void PrecomputeGates();
+
+  /// `precomputed`, or nullptr if it is empty or was built for other
+  /// segments, another frame origin or another gate_extension_m.
+  const PrecomputedGates *Precomputed() const;
+
   /// Converts a local-frame segment to raw lon/lat Points, i.e. the frame
   /// pacer::Split() expects when intersecting against raw GPSSample points.
   Segment ToGlobal(const Segment &local) const;
@@ -49,6 +75,12 @@ struct ReferenceTrack {
   /// don't produce a jittery delta.
   Lap Resample(const Lap &lap) const;
 
+  /// Same, against a prebuilt index over DensifiedGates() — build it once
+  /// when resampling many laps against the same track. Crossings are looked
+  /// up per lap segment in the index, so the cost follows the lap's sample
+  /// count rather than gates x samples.
+  Lap Resample(const Lap &lap, const GateIndex &gates) const;
+
   /// Builds a ReferenceTrack the old way: a perpendicular offset of `width`
   /// meters at every interior point of `lap`. Useful when there is no
   /// hand-annotated track, only a recorded lap to use as a stand-in.
@@ -56,14 +88,23 @@ struct ReferenceTrack {
                                const CoordinateSystem &cs);
 
   /// Loads a reference track from the JSON schema written by
-  /// track_annotator ({"segments": [[[lat,lon],[lat,lon]], ...]}).
-  /// Throws std::runtime_error on failure.
+  /// track_annotator ({"segments": [[[lat,lon],[lat,lon]], ...]}), or, for a
+  /// *.ptrk filename, from the binary format (see SaveToFile()), with
+  /// `precomputed` and gate_extension_m filled in. Throws
+  /// std::runtime_error on failure.
   static ReferenceTrack FromFile(const std::string &filename);
 
-  /// Writes this track using the same JSON schema. Throws
-  /// std::runtime_error on failure.
+  /// Writes this track using the same JSON schema, or for a *.ptrk filename
+  /// the binary one: a fixed header (magic, version, counts, frame origin,
+  /// gate_extension_m), then segments, the densified local and global gates,
+  /// and sector_indices as raw arrays in native endianness. Loading it is a
+  /// handful of reads straight into the vectors; the JSON stays the
+  /// editable source. Throws std::runtime_error on failure.
   void SaveToFile(const std::string &filename) const;
 
+  /// `filename` with its extension replaced by .ptrk.
+  static std::string BinaryPath(const std::string &filename);
+
   /// Builds a pacer::Sectors using segments[0] as the start/finish line and
   /// sector_indices (in order) as sector splits, converting from this
   /// track's local frame into target_cs (the frame the consuming Laps
@@ -0,0 +1,202 @@
+#include "track-catalog.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'T', 'R', 'K', 'C', 'A', 'T', '\0'};
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t count;
+};
+
+static_assert(sizeof(Header) == 16);
+static_assert(sizeof(pacer::TrackCatalog::Entry) == 128);
+
+// A catalog is a handful of entries per venue; anything past this is a
+// corrupt count, not a track library.
+constexpr uint32_t kMaxEntries = 100'000;
+
+std::string DirectoryOf(const std::string &path) {
+  size_t slash = path.find_last_of("/\\");
+  return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+std::string NameOf(const std::string &path) {
+  size_t slash = path.find_last_of("/\\");
+  return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+} // namespace
+
+pacer::TrackCatalog::Entry
+pacer::TrackCatalog::Describe(const ReferenceTrack &track,
+                              const std::string &file, uint64_t size,
+                              int64_t mtime) {
+  if (track.segments.empty()) {
+    throw std::runtime_error(file + ": track has no segments");
+  }
+  if (file.size() >= sizeof(Entry::file)) {
+    throw std::runtime_error(file + ": name too long for the track catalog");
+  }
+
+  Entry entry;
+  std::memcpy(entry.file, file.data(), file.size());
+  entry.size = size;
+  entry.mtime = mtime;
+
+  Segment start = track.ToGlobal(track.segments[0]);
+  entry.start_lat = entry.min_lat = entry.max_lat = start.first.y;
+  entry.start_lon = entry.min_lon = entry.max_lon = start.first.x;
+  for (const Segment &local : track.segments) {
+    Segment global = track.ToGlobal(local);
+    for (Point p : {global.first, global.second}) {
+      entry.min_lat = std::min(entry.min_lat, p.y);
+      entry.max_lat = std::max(entry.max_lat, p.y);
+      entry.min_lon = std::min(entry.min_lon, p.x);
+      entry.max_lon = std::max(entry.max_lon, p.x);
+    }
+  }
+  return entry;
+}
+
+bool pacer::TrackCatalog::Stat(const std::string &path, uint64_t *size,
+                               int64_t *mtime) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    return false;
+  }
+  *size = static_cast<uint64_t>(st.st_size);
+  *mtime = static_cast<int64_t>(st.st_mtime);
+  return true;
+}
+
+pacer::TrackCatalog
+pacer::TrackCatalog::FromFile(const std::string &filename) {
+  FILE *f = std::fopen(filename.c_str(), "rb");
+  if (!f) {
+    throw std::runtime_error("Unable to open file: " + filename);
+  }
+  Header header;
+  TrackCatalog catalog;
+  bool ok = std::fread(&header, sizeof(header), 1, f) == 1 &&
+            std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+            header.version == kVersion && header.count <= kMaxEntries;
+  if (ok) {
+    catalog.entries.resize(header.count);
+    ok = std::fread(catalog.entries.data(), sizeof(Entry), header.count, f) ==
+         header.count;
+  }
+  std::fclose(f);
+  if (!ok) {
+    throw std::runtime_error("Invalid track catalog: " + filename);
+  }
+  for (Entry &entry : catalog.entries) {
+    entry.file[sizeof(entry.file) - 1] = '\0';
+  }
+  return catalog;
+}
+
+void pacer::TrackCatalog::SaveToFile(const std::string &filename) const {
+  std::string tmp_path = filename + ".tmp";
+  FILE *f = std::fopen(tmp_path.c_str(), "wb");
+  if (!f) {
+    throw std::runtime_error("Unable to write file: " + tmp_path);
+  }
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.count = static_cast<uint32_t>(entries.size());
+  bool ok = std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+            std::fwrite(entries.data(), sizeof(Entry), entries.size(), f) ==
+                entries.size();
+  ok = std::fclose(f) == 0 && ok;
+  // FAT (and Windows) won't rename over an existing file: only then is the
+  // old catalog removed, and only once the new one is written whole.
+  if (ok && std::rename(tmp_path.c_str(), filename.c_str()) != 0) {
+    std::remove(filename.c_str());
+    ok = std::rename(tmp_path.c_str(), filename.c_str()) == 0;
+  }
+  if (!ok) {
+    std::remove(tmp_path.c_str());
+    throw std::runtime_error("Unable to write file: " + filename);
+  }
+}
+
+const pacer::TrackCatalog::Entry *
+pacer::TrackCatalog::Find(const std::string &file) const {
+  for (const Entry &entry : entries) {
+    if (file == entry.file) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+void pacer::TrackCatalog::Upsert(const Entry &entry) {
+  if (const Entry *existing = Find(entry.file)) {
+    entries[existing - entries.data()] = entry;
+  } else {
+    entries.push_back(entry);
+  }
+}
+
+const pacer::TrackCatalog::Entry *
+pacer::TrackCatalog::Nearest(double lat, double lon, double *distance_m) const {
+  GPSSample here{.lat = lat, .lon = lon, .altitude = 0};
+  CoordinateSystem cs(here);
+
+  const Entry *best = nullptr;
+  double best_dist = 0;
+  for (const Entry &entry : entries) {
+    double dist = cs.Distance(
+        here, GPSSample{.lat = entry.start_lat, .lon = entry.start_lon});
+    if (!best || dist < best_dist) {
+      best = &entry;
+      best_dist = dist;
+    }
+  }
+  if (best && distance_m) {
+    *distance_m = best_dist;
+  }
+  return best;
+}
+
+void pacer::TrackCatalog::SaveTrack(const ReferenceTrack &track,
+                                    const std::string &path) {
+  track.SaveToFile(path);
+  std::string binary_path = ReferenceTrack::BinaryPath(path);
+  if (binary_path != path) {
+    // Written after the JSON, so its mtime says it's current.
+    track.SaveToFile(binary_path);
+  }
+
+  uint64_t size;
+  int64_t mtime;
+  if (!Stat(path, &size, &mtime)) {
+    throw std::runtime_error("Unable to stat file: " + path);
+  }
+  std::string catalog_path = DirectoryOf(path) + kFileName;
+  TrackCatalog catalog;
+  try {
+    catalog = FromFile(catalog_path);
+  } catch (const std::runtime_error &) {
+    // Missing or unreadable: start over with just this track; the firmware
+    // describes the rest on its next scan.
+  }
+  std::string name = NameOf(path);
+  if (track.segments.empty()) {
+    // Nothing to time against: keep it out of auto-selection.
+    std::erase_if(catalog.entries,
+                  [&](const Entry &entry) { return name == entry.file; });
+  } else {
+    catalog.Upsert(Describe(track, name, size, mtime));
+  }
+  catalog.SaveToFile(catalog_path);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <pacer/reference-track/reference-track.hpp>
+
+namespace pacer {
+
+// Index of a directory of track files (tracks/ on the logger's SD card): per
+// track, where its start line is and the area it covers, keyed by file name,
+// size and mtime. Picking the track nearest a fix then takes one small read
+// plus a directory listing to spot stale entries, instead of parsing every
+// track's JSON; only the winner gets loaded in full.
+//
+// track_annotator updates the catalog next to each track it saves; the
+// firmware re-describes whatever is missing or stale and writes it back.
+//
+// Layout (native endianness, little on every writer we have): a 16-byte
+// header ("PTRKCAT" magic, uint32 version, uint32 entry count), then the
+// entries as fixed-size records, so the whole file is read in one go.
+struct TrackCatalog {
+  constexpr static uint32_t kVersion = 1;
+
+  /// Catalog file name within the tracks directory.
+  constexpr static const char *kFileName = "catalog.bin";
+
+  struct Entry {
+    char file[64] = {}; ///< file name within the directory, NUL-terminated
+    uint64_t size = 0;  ///< file size when described
+    int64_t mtime = 0;  ///< stat() mtime, seconds, when described
+
+    /// First endpoint of segments[0], the start line.
+    double start_lat = 0, start_lon = 0;
+    /// Bounding box of every annotated gate endpoint.
+    double min_lat = 0, min_lon = 0, max_lat = 0, max_lon = 0;
+  };
+
+  std::vector<Entry> entries;
+
+  /// Describes `track`, stored as `file` (a name, not a path) of the given
+  /// size and mtime. Throws std::runtime_error if the track has no segments
+  /// or the name doesn't fit Entry::file.
+  static Entry Describe(const ReferenceTrack &track, const std::string &file,
+                        uint64_t size, int64_t mtime);
+
+  /// Size and mtime of `path` as Entry stores them; false if it can't be
+  /// stat()-ed.
+  static bool Stat(const std::string &path, uint64_t *size, int64_t *mtime);
+
+  /// Throws std::runtime_error if the file is missing, of another version or
+  /// truncated.
+  static TrackCatalog FromFile(const std::string &filename);
+
+  /// Writes a temporary file, then renames it over `filename`, so a failed
+  /// write never leaves half a catalog behind. Throws std::runtime_error on
+  /// failure.
+  void SaveToFile(const std::string &filename) const;
+
+  /// Entry for `file`, or nullptr.
+  const Entry *Find(const std::string &file) const;
+
+  /// Replaces the entry for the same file, or appends `entry`.
+  void Upsert(const Entry &entry);
+
+  /// Entry whose start line is nearest (lat, lon), or nullptr if empty;
+  /// `distance_m` (if given) receives the ground distance to it.
+  const Entry *Nearest(double lat, double lon,
+                       double *distance_m = nullptr) const;
+
+  /// Saves `track` to `path` (ReferenceTrack::SaveToFile) plus its .ptrk
+  /// beside it, and updates the catalog in the same directory to match,
+  /// creating it if needed; a track without segments is dropped from it. An
+  /// unreadable existing catalog is replaced. Throws std::runtime_error on
+  /// failure.
+  static void SaveTrack(const ReferenceTrack &track, const std::string &path);
+};
+
+} // namespace pacer
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include <pacer/datatypes/datatypes.hpp>
+#include <pacer/reference-track/reference-track.hpp>
+
+// A small synthetic circuit shared by the timing tests: a stadium with
+// 300 m straights and 60 m bends (~980 m, about 45 s a lap), gates every
+// 10 m, and 25 Hz sessions driven around it with varying speed, a
+// wandering line and fix noise. Deterministic.
+namespace pacer::testing {
+
+inline constexpr double kStraight = 300;
+inline constexpr double kRadius = 60;
+inline constexpr double kLapLength =
+    2 * kStraight + 2 * std::numbers::pi * kRadius;
+
+/// Point on the centreline at arc length `s` (wrapped), and the unit normal
+/// pointing out of the stadium.
+inline void CentrelineAt(double s, Point *p, Point *normal) {
+  s = std::fmod(s, kLapLength);
+  if (s < 0) {
+    s += kLapLength;
+  }
+  double bend = std::numbers::pi * kRadius;
+  for (int side = 0; side < 2; ++side) {
+    double sign = side == 0 ? 1 : -1;
+    if (s < kStraight) {
+      *p = Point{sign * (s - kStraight / 2), -sign * kRadius};
+      *normal = Point{0, -sign};
+      return;
+    }
+    s -= kStraight;
+    if (s < bend) {
+      double a = -std::numbers::pi / 2 + s / kRadius;
+      Point dir{std::cos(a), std::sin(a)};
+      *p = Point{sign * kStraight / 2, 0} + dir * (sign * kRadius);
+      *normal = dir * sign;
+      return;
+    }
+    s -= bend;
+  }
+  CentrelineAt(0, p, normal);
+}
+
+inline CoordinateSystem SyntheticFrame() {
+  return CoordinateSystem(GPSSample{.lat = 52.04, .lon = -0.78});
+}
+
+inline ReferenceTrack SyntheticTrack() {
+  ReferenceTrack track;
+  track.cs = SyntheticFrame();
+  for (double s = 0; s + 5 < kLapLength; s += 10) {
+    Point p, n;
+    CentrelineAt(s, &p, &n);
+    track.segments.push_back(Segment{p - n * 5.0, p + n * 5.0});
+  }
+  int count = static_cast<int>(track.segments.size());
+  track.sector_indices = {count / 3, 2 * count / 3};
+  return track;
+}
+
+/// `duration_s` of 25 Hz fixes around SyntheticTrack(), starting a little
+/// before the line so the first lap is timed.
+inline std::vector<GPSSample> SyntheticSession(double duration_s,
+                                               uint32_t seed = 239) {
+  constexpr double kSampleMs = 40;
+  CoordinateSystem cs = SyntheticFrame();
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> noise(0, 0.3);
+
+  std::vector<GPSSample> samples;
+  size_t count = static_cast<size_t>(duration_s * 1000 / kSampleMs);
+  samples.reserve(count);
+  double s = -30;
+  for (size_t i = 0; i < count; ++i) {
+    double phase = 2 * std::numbers::pi * s / kLapLength;
+    double speed = 20 + 5 * std::sin(7 * phase);
+    double offset = 1.5 * std::sin(s / 23) + noise(rng);
+
+    Point p, n;
+    CentrelineAt(s, &p, &n);
+    Point q = p + n * offset;
+    GPSSample sample = cs.Global(Vec3f{q.x, q.y, 0});
+    sample.full_speed = sample.ground_speed = speed;
+    sample.timestamp_ms =
+        1'000'000 + static_cast<int64_t>(static_cast<double>(i) * kSampleMs);
+    samples.push_back(sample);
+
+    s += speed * kSampleMs / 1000;
+  }
+  return samples;
+}
+
+} // namespace pacer::testing
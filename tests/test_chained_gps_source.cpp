@@ -0,0 +1,147 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <pacer/gps-source/gps-source.hpp>
+
+namespace {
+
+// `count` one-second payloads of two samples each. A sample's lat is its
+// chapter and its lon the payload index, so playback order is visible.
+class FakeSource : public pacer::RawGPSSource {
+public:
+  FakeSource(int chapter, uint32_t count) : chapter_(chapter), count_(count) {}
+
+  uint32_t Samples(void *data,
+                   void (*on_sample)(void *, pacer::GPSSample, size_t,
+                                     size_t)) override {
+    if (IsEnd()) {
+      return 1;
+    }
+    for (size_t i = 0; i < 2; ++i) {
+      pacer::GPSSample s{};
+      s.lat = chapter_;
+      s.lon = index_;
+      on_sample(data, s, i, 2);
+    }
+    return 0;
+  }
+
+  uint32_t Seek(double target) override {
+    index_ = std::min(count_, static_cast<uint32_t>(std::max(0.0, target)));
+    return IsEnd() ? 1 : 0;
+  }
+
+  void Next() override { ++index_; }
+
+  bool IsEnd() override { return index_ >= count_; }
+
+  std::pair<double, double> CurrentTimeSpan() const override {
+    return {index_, index_ + 1.0};
+  }
+
+  double GetTotalDuration() const override { return count_; }
+
+private:
+  int chapter_;
+  uint32_t count_;
+  uint32_t index_ = 0;
+};
+
+// (chapter, payload) of whatever `source` plays now.
+std::pair<int, int> Current(pacer::RawGPSSource &source) {
+  std::pair<int, int> at{-1, -1};
+  source.Samples([&](pacer::GPSSample s, size_t, size_t) {
+    at = {static_cast<int>(s.lat), static_cast<int>(s.lon)};
+  });
+  return at;
+}
+
+} // namespace
+
+TEST_CASE("ChainedGPSSource plays its chapters back to back",
+          "[gps-source]") {
+  FakeSource a(0, 3), b(1, 2), c(2, 4);
+  pacer::ChainedGPSSource chain({&a, &b, &c});
+  CHECK(chain.SourceCount() == 3);
+  CHECK(chain.GetTotalDuration() == 9);
+
+  // Leave a chapter half played: Next() rewinds it when it gets there.
+  b.Seek(1);
+
+  std::vector<std::pair<int, int>> played;
+  for (chain.Seek(0); !chain.IsEnd(); chain.Next()) {
+    played.push_back(Current(chain));
+    auto [start, end] = chain.CurrentTimeSpan();
+    CHECK(start == static_cast<double>(played.size() - 1));
+    CHECK(end == start + 1);
+  }
+  CHECK(played == std::vector<std::pair<int, int>>{
+                      {0, 0}, {0, 1}, {0, 2}, {1, 0}, {1, 1},
+                      {2, 0}, {2, 1}, {2, 2}, {2, 3}});
+  CHECK(chain.CurrentSource() == 2);
+}
+
+TEST_CASE("ChainedGPSSource seeks into the chapter covering the target",
+          "[gps-source]") {
+  FakeSource a(0, 3), b(1, 2), c(2, 4);
+  pacer::ChainedGPSSource chain({&a, &b, &c});
+
+  chain.Seek(4.5);
+  CHECK(chain.CurrentSource() == 1);
+  CHECK(Current(chain) == std::pair{1, 1});
+  CHECK(chain.CurrentTimeSpan() == std::pair{4.0, 5.0});
+
+  // Back into an earlier chapter.
+  chain.Seek(0.2);
+  CHECK(Current(chain) == std::pair{0, 0});
+
+  // A chapter's end is the next one's start.
+  chain.Seek(3);
+  CHECK(chain.CurrentSource() == 1);
+  CHECK(Current(chain) == std::pair{1, 0});
+  chain.Seek(5);
+  CHECK(Current(chain) == std::pair{2, 0});
+
+  // Past the end stays in the last chapter, at its end.
+  chain.Seek(100);
+  CHECK(chain.CurrentSource() == 2);
+  CHECK(chain.IsEnd());
+  CHECK(Current(chain) == std::pair{-1, -1});
+}
+
+TEST_CASE("ChainedGPSSource skips empty chapters", "[gps-source]") {
+  FakeSource a(0, 2), empty(1, 0), c(2, 1);
+  pacer::ChainedGPSSource chain({&a, &empty, &c});
+  CHECK(chain.GetTotalDuration() == 3);
+
+  chain.Seek(2);
+  CHECK(chain.CurrentSource() == 2);
+  CHECK(Current(chain) == std::pair{2, 0});
+
+  chain.Seek(1);
+  chain.Next();
+  CHECK(Current(chain) == std::pair{2, 0});
+  chain.Next();
+  CHECK(chain.IsEnd());
+
+  pacer::ChainedGPSSource none({});
+  CHECK(none.IsEnd());
+  CHECK(none.GetTotalDuration() == 0);
+  CHECK(none.Seek(1) == 0);
+}
+
+TEST_CASE("SequentialGPSSource chains two sources", "[gps-source]") {
+  FakeSource a(0, 2), b(1, 2);
+  pacer::SequentialGPSSource sequence(&a, &b);
+  CHECK(sequence.SourceCount() == 2);
+  CHECK(sequence.GetTotalDuration() == 4);
+  sequence.Seek(2.5);
+  CHECK(Current(sequence) == std::pair{1, 0});
+  sequence.Next();
+  CHECK(Current(sequence) == std::pair{1, 1});
+}
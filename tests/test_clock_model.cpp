@@ -0,0 +1,98 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <pacer/gps-source/clock-model.hpp>
+
+namespace {
+
+// An 18 Hz receiver whose crystal runs 30 ppm slow, recorded as GPS5:
+// one anchor per 18-fix payload, on its first fix, with the GPSU time off
+// by up to ±40 ms. At fix kStep the clock steps forward 5 s (the receiver
+// lost its fix and came back).
+constexpr size_t kFixes = 1000000;
+constexpr size_t kPerPayload = 18;
+constexpr size_t kStep = 500004; // a payload boundary
+constexpr double kPeriodMs = 1000.0 / 18 * (1 + 30e-6);
+constexpr double kStepMs = 5000;
+constexpr double kStartMs = 1710506096789;
+
+double TrueTimeMs(size_t sample) {
+  return kStartMs + kPeriodMs * static_cast<double>(sample) +
+         (sample >= kStep ? kStepMs : 0);
+}
+
+std::vector<pacer::ClockAnchor> Anchors(double jitter_ms, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> jitter(-jitter_ms, jitter_ms);
+  std::vector<pacer::ClockAnchor> anchors;
+  for (size_t sample = 0; sample < kFixes; sample += kPerPayload) {
+    anchors.push_back({.sample = sample,
+                       .time_ms = TrueTimeMs(sample) + jitter(rng)});
+  }
+  return anchors;
+}
+
+double MaxErrorMs(const pacer::ClockModel &model) {
+  double worst = 0;
+  for (size_t sample = 0; sample < kFixes; ++sample) {
+    worst = std::max(worst, std::abs(model.TimeMs(sample) - TrueTimeMs(sample)));
+  }
+  return worst;
+}
+
+} // namespace
+
+TEST_CASE("ClockModel fits a million jittery fixes to within a millisecond",
+          "[clock-model]") {
+  std::vector<pacer::ClockAnchor> anchors = Anchors(40, 239);
+  pacer::ClockModel model = pacer::ClockModel::Fit(anchors);
+
+  REQUIRE(model.Segments().size() == 2);
+  CHECK(model.Segments()[0].first_sample == 0);
+  CHECK(model.Segments()[1].first_sample == kStep);
+  for (const pacer::ClockModel::Segment &segment : model.Segments()) {
+    CHECK(std::abs(segment.period_ms - kPeriodMs) < 1e-5);
+  }
+  CHECK(MaxErrorMs(model) < 1);
+}
+
+TEST_CASE("ClockModel is exact on exact anchors", "[clock-model]") {
+  pacer::ClockModel model = pacer::ClockModel::Fit(Anchors(0, 1));
+  REQUIRE(model.Segments().size() == 2);
+  CHECK(MaxErrorMs(model) < 1e-3);
+}
+
+TEST_CASE("ClockModel drops a lone bad anchor", "[clock-model]") {
+  std::vector<pacer::ClockAnchor> anchors = Anchors(40, 7);
+  anchors[1000].time_ms += 1000;
+  anchors[40000].time_ms -= 800;
+  pacer::ClockModel model = pacer::ClockModel::Fit(anchors);
+  REQUIRE(model.Segments().size() == 2);
+  CHECK(MaxErrorMs(model) < 1);
+}
+
+TEST_CASE("ClockModel needs two samples for a rate", "[clock-model]") {
+  std::vector<pacer::ClockAnchor> none;
+  CHECK(pacer::ClockModel::Fit(none).empty());
+
+  std::vector<pacer::ClockAnchor> one{{.sample = 18, .time_ms = 1000}};
+  CHECK(pacer::ClockModel::Fit(one).empty());
+
+  // Repeated anchors of one fix still give no rate.
+  std::vector<pacer::ClockAnchor> same{{.sample = 18, .time_ms = 1000},
+                                       {.sample = 18, .time_ms = 1010}};
+  CHECK(pacer::ClockModel::Fit(same).empty());
+
+  std::vector<pacer::ClockAnchor> two{{.sample = 0, .time_ms = 1000},
+                                      {.sample = 18, .time_ms = 2000}};
+  pacer::ClockModel model = pacer::ClockModel::Fit(two);
+  REQUIRE(model.Segments().size() == 1);
+  CHECK(std::abs(model.TimeMs(9) - 1500) < 1e-9);
+  // Extrapolated past either end.
+  CHECK(std::abs(model.TimeMs(36) - 3000) < 1e-9);
+}
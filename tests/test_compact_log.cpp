@@ -0,0 +1,249 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <pacer/gps-source/compact-log.hpp>
+
+namespace {
+
+using Predictor = pacer::CompactLogPredictor;
+
+struct Fix {
+  int64_t timestamp_ms;
+  uGnssDecUbxNavPvt_t pvt;
+};
+
+// A 25 Hz drive: smooth position and clocks, noisy speeds, a 3D fix.
+std::vector<Fix> Drive(size_t count, uint32_t seed = 239) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int32_t> noise(-300, 300);
+  std::vector<Fix> fixes;
+  for (size_t i = 0; i < count; ++i) {
+    uGnssDecUbxNavPvt_t pvt{};
+    pvt.iTOW = 345600000 + static_cast<uint32_t>(i * 40);
+    pvt.year = 2024;
+    pvt.month = 3;
+    pvt.day = 15;
+    pvt.hour = static_cast<uint8_t>(12 + i / 90000);
+    pvt.sec = static_cast<uint8_t>(i / 25 % 60);
+    pvt.valid = 0x07;
+    pvt.tAcc = 20 + static_cast<uint32_t>(i % 7);
+    pvt.fixType = U_GNSS_DEC_UBX_NAV_PVT_FIX_TYPE_3D;
+    pvt.flags = 0x01;
+    pvt.numSV = static_cast<uint8_t>(12 + i % 5);
+    pvt.lat = 520400000 + static_cast<int32_t>(i * 37) + noise(rng) / 100;
+    pvt.lon = -7800000 - static_cast<int32_t>(i * 21) + noise(rng) / 100;
+    pvt.height = 95000 + noise(rng);
+    pvt.hAcc = 500 + static_cast<uint32_t>(i % 11);
+    pvt.velN = 25000 + noise(rng);
+    pvt.velE = -14000 + noise(rng);
+    pvt.velD = noise(rng);
+    pvt.gSpeed = 28700 + noise(rng);
+    pvt.headMot = 33000000 + 1000 * noise(rng);
+    pvt.pDOP = 120;
+    fixes.push_back({1710506096789 + static_cast<int64_t>(i) * 40, pvt});
+  }
+  return fixes;
+}
+
+// Header and records of `fixes`, with where each record starts.
+std::vector<uint8_t> Encode(const std::vector<Fix> &fixes,
+                            std::vector<size_t> *starts = nullptr,
+                            uint32_t keyframe_interval = 25) {
+  std::vector<uint8_t> bytes(pacer::CompactLogEncoder::kHeaderSize);
+  pacer::CompactLogEncoder::Header(bytes.data());
+  pacer::CompactLogEncoder encoder(keyframe_interval);
+  for (const Fix &fix : fixes) {
+    size_t at = bytes.size();
+    if (starts) {
+      starts->push_back(at);
+    }
+    bytes.resize(at + pacer::CompactLogEncoder::kMaxRecordSize);
+    bytes.resize(at + encoder.Append(fix.timestamp_ms, fix.pvt, &bytes[at]));
+  }
+  return bytes;
+}
+
+std::vector<Fix> Decode(std::span<const uint8_t> bytes) {
+  std::vector<Fix> fixes;
+  pacer::CompactLogDecoder decoder;
+  size_t count = decoder.Decode(
+      bytes, [&](int64_t timestamp_ms, const uGnssDecUbxNavPvt_t &pvt) {
+        fixes.push_back({timestamp_ms, pvt});
+      });
+  CHECK(count == fixes.size());
+  return fixes;
+}
+
+// Delta-coded fields match exactly; the rest are those of the keyframe the
+// record follows.
+void CheckRoundTrip(const std::vector<Fix> &expected,
+                    const std::vector<Fix> &decoded,
+                    const std::vector<size_t> &starts,
+                    const std::vector<uint8_t> &bytes) {
+  REQUIRE(decoded.size() <= expected.size());
+  const uGnssDecUbxNavPvt_t *keyframe = nullptr;
+  for (size_t i = 0; i < decoded.size(); ++i) {
+    if (bytes[starts[i]] == pacer::CompactLogEncoder::kKeyframe) {
+      keyframe = &expected[i].pvt;
+    }
+    REQUIRE(keyframe);
+    int64_t want[Predictor::kFields], got[Predictor::kFields];
+    pacer::CompactLogValues(expected[i].timestamp_ms, expected[i].pvt, want);
+    pacer::CompactLogValues(decoded[i].timestamp_ms, decoded[i].pvt, got);
+    for (size_t f = 0; f < Predictor::kFields; ++f) {
+      CHECK(got[f] == want[f]);
+    }
+    const uGnssDecUbxNavPvt_t &pvt = decoded[i].pvt;
+    CHECK(pvt.fixType == expected[i].pvt.fixType);
+    CHECK(pvt.flags == expected[i].pvt.flags);
+    CHECK(pvt.valid == expected[i].pvt.valid);
+    CHECK(pvt.sec == keyframe->sec);
+    CHECK(pvt.tAcc == keyframe->tAcc);
+    CHECK(pvt.hAcc == keyframe->hAcc);
+    CHECK(pvt.numSV == keyframe->numSV);
+    CHECK(pvt.pDOP == keyframe->pDOP);
+  }
+}
+
+} // namespace
+
+TEST_CASE("Compact log round-trips a drive", "[compact-log]") {
+  std::vector<Fix> fixes = Drive(25 * 60);
+  std::vector<size_t> starts;
+  std::vector<uint8_t> bytes = Encode(fixes, &starts);
+  CHECK(pacer::CompactLogDecoder::IsCompactLog(bytes));
+
+  std::vector<Fix> decoded = Decode(bytes);
+  REQUIRE(decoded.size() == fixes.size());
+  CheckRoundTrip(fixes, decoded, starts, bytes);
+
+  // A keyframe every 25 fixes, deltas well under a .dat record between.
+  for (size_t i = 0; i < fixes.size(); ++i) {
+    CHECK((bytes[starts[i]] == pacer::CompactLogEncoder::kKeyframe) ==
+          (i % 25 == 0));
+  }
+  CHECK(bytes.size() < fixes.size() * 30);
+}
+
+TEST_CASE("Compact log round-trips extreme deltas", "[compact-log]") {
+  constexpr int32_t kMin = std::numeric_limits<int32_t>::min();
+  constexpr int32_t kMax = std::numeric_limits<int32_t>::max();
+  std::vector<Fix> fixes = Drive(60);
+  // Residuals needing the longest varints: fields swinging end to end,
+  // against predictions that wrap.
+  for (size_t i = 5; i < 15; ++i) {
+    uGnssDecUbxNavPvt_t &pvt = fixes[i].pvt;
+    pvt.lat = i % 2 ? kMin : kMax;
+    pvt.lon = i % 3 ? kMax : kMin;
+    pvt.height = i % 2 ? kMax : kMin;
+    pvt.velD = kMin;
+    pvt.headMot = i % 2 ? -18000000 : 18000000;
+  }
+  // iTOW wraps at the end of the week, the logger clock runs backwards.
+  fixes[20].pvt.iTOW = 604800000 - 40;
+  fixes[21].pvt.iTOW = 0;
+  fixes[22].pvt.iTOW = 40;
+  fixes[30].timestamp_ms = 0;
+  fixes[31].timestamp_ms = std::numeric_limits<int64_t>::max();
+  fixes[32].timestamp_ms = std::numeric_limits<int64_t>::min();
+
+  std::vector<size_t> starts;
+  std::vector<uint8_t> bytes = Encode(fixes, &starts);
+  std::vector<Fix> decoded = Decode(bytes);
+  REQUIRE(decoded.size() == fixes.size());
+  CheckRoundTrip(fixes, decoded, starts, bytes);
+  // Those went in as deltas, not keyframes.
+  CHECK(bytes[starts[6]] == pacer::CompactLogEncoder::kDelta);
+  CHECK(bytes[starts[31]] == pacer::CompactLogEncoder::kDelta);
+}
+
+TEST_CASE("Compact log round-trips timestamp gaps and fix changes",
+          "[compact-log]") {
+  std::vector<Fix> fixes = Drive(200);
+  // The logger paused for ten minutes, then for a day.
+  for (size_t i = 70; i < fixes.size(); ++i) {
+    fixes[i].timestamp_ms += 10 * 60 * 1000;
+    fixes[i].pvt.iTOW += 10 * 60 * 1000;
+  }
+  for (size_t i = 140; i < fixes.size(); ++i) {
+    fixes[i].timestamp_ms += 86400000;
+  }
+  // The fix dropped to 2D for a few fixes.
+  for (size_t i = 101; i < 104; ++i) {
+    fixes[i].pvt.fixType = U_GNSS_DEC_UBX_NAV_PVT_FIX_TYPE_2D;
+  }
+
+  std::vector<size_t> starts;
+  std::vector<uint8_t> bytes = Encode(fixes, &starts);
+  std::vector<Fix> decoded = Decode(bytes);
+  REQUIRE(decoded.size() == fixes.size());
+  CheckRoundTrip(fixes, decoded, starts, bytes);
+  // Fix state changes start a keyframe, both ways.
+  CHECK(bytes[starts[101]] == pacer::CompactLogEncoder::kKeyframe);
+  CHECK(bytes[starts[102]] == pacer::CompactLogEncoder::kDelta);
+  CHECK(bytes[starts[104]] == pacer::CompactLogEncoder::kKeyframe);
+}
+
+TEST_CASE("Compact log drops a truncated tail", "[compact-log]") {
+  std::vector<Fix> fixes = Drive(60);
+  std::vector<size_t> starts;
+  std::vector<uint8_t> bytes = Encode(fixes, &starts);
+  starts.push_back(bytes.size());
+
+  // Cut anywhere in the last few records (a keyframe and deltas): only the
+  // whole records before the cut decode.
+  for (size_t cut = starts[48]; cut <= bytes.size(); ++cut) {
+    CAPTURE(cut);
+    size_t whole = 0;
+    while (whole + 1 < starts.size() && starts[whole + 1] <= cut) {
+      ++whole;
+    }
+    std::vector<Fix> decoded =
+        Decode(std::span<const uint8_t>(bytes).first(cut));
+    CHECK(decoded.size() == whole);
+    CheckRoundTrip(fixes, decoded, starts, bytes);
+  }
+
+  // Too short for a header, or not one.
+  CHECK(Decode(std::span<const uint8_t>(bytes).first(5)).empty());
+  std::vector<uint8_t> other = bytes;
+  other[0] = 'X';
+  CHECK(Decode(other).empty());
+  // A stray byte where a record should start ends the log there.
+  other = bytes;
+  other[starts[30]] = 'Q';
+  CHECK(Decode(other).size() == 30);
+}
+
+TEST_CASE("Compact log decodes in arbitrary chunks", "[compact-log]") {
+  std::vector<Fix> fixes = Drive(300);
+  std::vector<size_t> starts;
+  std::vector<uint8_t> bytes = Encode(fixes, &starts);
+
+  // As a growing file is read: whatever has arrived, with the partial
+  // record from last time in front.
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<size_t> chunk(1, 64);
+  pacer::CompactLogDecoder decoder;
+  std::vector<Fix> decoded;
+  std::vector<uint8_t> pending;
+  for (size_t at = pacer::CompactLogEncoder::kHeaderSize; at < bytes.size();) {
+    size_t n = std::min(chunk(rng), bytes.size() - at);
+    pending.insert(pending.end(), bytes.begin() + at, bytes.begin() + at + n);
+    at += n;
+    size_t used = decoder.DecodeRecords(
+        pending, [&](int64_t timestamp_ms, const uGnssDecUbxNavPvt_t &pvt) {
+          decoded.push_back({timestamp_ms, pvt});
+        });
+    pending.erase(pending.begin(), pending.begin() + used);
+  }
+  CHECK(pending.empty());
+  REQUIRE(decoded.size() == fixes.size());
+  CheckRoundTrip(fixes, decoded, starts, bytes);
+}
@@ -2,6 +2,10 @@
 #include <catch2/matchers/catch_matchers.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 
+#include <cmath>
+#include <utility>
+#include <vector>
+
 #include <pacer/datatypes/datatypes.hpp>
 #include <pacer/geometry/geometry.hpp>
 
@@ -38,3 +42,73 @@ TEST_CASE("London stays in London, high or low", "[london]") {
                Catch::Matchers::WithinRelMatcher(global_jump.altitude, 1e-6));
   }
 }
+
+TEST_CASE("Batch projection matches the scalar one", "[batch]") {
+  pacer::GPSSample london{.lat = 51.5074, .lon = -0.1278, .altitude = 20};
+  auto cs = pacer::CoordinateSystem(london);
+
+  // A few km around the origin, plus one far enough for the fallback.
+  std::vector<pacer::GPSSample> points;
+  for (int i = 0; i < 100; ++i) {
+    points.push_back(pacer::GPSSample{
+        .lat = london.lat + 0.0004 * (i % 10 - 5),
+        .lon = london.lon + 0.0007 * (i / 10 - 5),
+        .altitude = 10.0 + i,
+    });
+  }
+  points.push_back(pacer::GPSSample{.lat = 48.8566, .lon = 2.3522});
+
+  std::vector<pacer::Vec3f> local(points.size()), tangent(points.size());
+  cs.LocalBatch(points, local);
+  cs.LocalBatch(points, tangent, pacer::Projection::kTangentPlane);
+  std::vector<pacer::GPSSample> global(points.size());
+  cs.GlobalBatch(local, global);
+  std::vector<double> distances(points.size());
+  cs.CumulativeDistances(points, distances);
+
+  double total = 0;
+  for (size_t i = 0; i < points.size(); ++i) {
+    auto exact = cs.Local(points[i]);
+    CHECK(std::sqrt((local[i] - exact).Norm()) < 1e-6);
+    if (i < 100) {
+      CHECK(std::sqrt((tangent[i] - exact).Norm()) < 0.01);
+    }
+    CHECK_THAT(global[i].lat,
+               Catch::Matchers::WithinAbsMatcher(points[i].lat, 1e-9));
+    CHECK_THAT(global[i].lon,
+               Catch::Matchers::WithinAbsMatcher(points[i].lon, 1e-9));
+    CHECK_THAT(global[i].altitude,
+               Catch::Matchers::WithinAbsMatcher(points[i].altitude, 1e-6));
+    if (i > 0) {
+      total += cs.Distance(points[i - 1], points[i]);
+    }
+    CHECK_THAT(distances[i], Catch::Matchers::WithinRelMatcher(total, 1e-9));
+  }
+}
+
+TEST_CASE("Linearized frame stays within its stated error", "[linear]") {
+  pacer::GPSSample london{.lat = 51.5074, .lon = -0.1278};
+  auto cs = pacer::CoordinateSystem(london);
+  pacer::LinearFrame frame(cs);
+  pacer::BasicLinearFrame<float> frame_f(cs);
+
+  for (auto [radius, tolerance] : {std::pair{1000.0, 0.12},
+                                   std::pair{2000.0, 0.5}}) {
+    for (int deg = 0; deg < 360; deg += 5) {
+      double a = deg * M_PI / 180;
+      pacer::Vec3f exact{radius * std::cos(a), radius * std::sin(a), 0};
+      pacer::GPSSample global = cs.Global(exact);
+
+      pacer::Point local = frame.Local(global);
+      CHECK(std::hypot(local.x - exact.x, local.y - exact.y) < tolerance);
+      pacer::PointF local_f = frame_f.Local(global);
+      CHECK(std::hypot(local_f.x - exact.x, local_f.y - exact.y) <
+            tolerance + 0.01);
+
+      // Global() inverts Local() exactly, up to rounding.
+      pacer::GPSSample back = frame.Global(local);
+      CHECK_THAT(back.lat, Catch::Matchers::WithinAbsMatcher(global.lat, 1e-9));
+      CHECK_THAT(back.lon, Catch::Matchers::WithinAbsMatcher(global.lon, 1e-9));
+    }
+  }
+}
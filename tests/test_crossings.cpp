@@ -0,0 +1,133 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <pacer/geometry/crossings.hpp>
+
+namespace {
+
+constexpr pacer::CrossingsKernel kKernels[] = {
+    pacer::CrossingsKernel::kScalar,
+    pacer::CrossingsKernel::kAvx2,
+    pacer::CrossingsKernel::kNeon,
+};
+
+// Bitwise, so NaN ratios compare equal too.
+bool Same(double a, double b) { return std::memcmp(&a, &b, sizeof(a)) == 0; }
+
+} // namespace
+
+TEST_CASE("FindFirstCrossing finds crossings on every lane and in the tail",
+          "[crossings]") {
+  // A vertical gate at x = 0.5; the polyline sits at x = -1 up to point
+  // `at - 1` and at x = 1 from `at` on, so only segment `at` crosses it.
+  pacer::Segment gate{{0.5, -1}, {0.5, 1}};
+  constexpr size_t kPoints = 24;
+  std::vector<double> x(kPoints), y(kPoints, 0.25);
+
+  for (pacer::CrossingsKernel kernel : kKernels) {
+    if (!pacer::HasCrossingsKernel(kernel)) {
+      continue;
+    }
+    for (size_t at = 1; at < kPoints; ++at) {
+      for (size_t i = 0; i < kPoints; ++i) {
+        x[i] = i < at ? -1 : 1;
+      }
+      for (size_t begin = 1; begin < 10; ++begin) {
+        for (size_t end = begin; end <= kPoints; ++end) {
+          double ratio = -1;
+          size_t hit = pacer::FindFirstCrossing(kernel, gate, x.data(),
+                                                y.data(), begin, end, &ratio);
+          if (at >= begin && at < end) {
+            REQUIRE(hit == at);
+            CHECK(ratio == 0.75);
+          } else {
+            REQUIRE(hit == end);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("FindFirstCrossing kernels match the scalar one", "[crossings]") {
+  // Random walks with points exactly on the gate (touching is no crossing),
+  // zero-length steps and NaNs mixed in.
+  pacer::Segment gate{{0, -2}, {0, 2}};
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<double> coord(-3, 3);
+  std::uniform_int_distribution<int> kind(0, 19);
+  std::vector<double> x(64), y(64);
+
+  for (int round = 0; round < 2000; ++round) {
+    for (size_t i = 0; i < x.size(); ++i) {
+      x[i] = coord(rng);
+      y[i] = coord(rng);
+      switch (kind(rng)) {
+      case 0:
+        x[i] = 0;
+        break;
+      case 1:
+        if (i > 0) {
+          x[i] = x[i - 1];
+          y[i] = y[i - 1];
+        }
+        break;
+      case 2:
+        x[i] = std::numeric_limits<double>::quiet_NaN();
+        break;
+      }
+    }
+    size_t begin = 1 + round % 7;
+    for (size_t end = begin; end <= x.size(); end += 1 + round % 5) {
+      double expected_ratio = 0;
+      size_t expected = pacer::FindFirstCrossing(
+          pacer::CrossingsKernel::kScalar, gate, x.data(), y.data(), begin,
+          end, &expected_ratio);
+      for (pacer::CrossingsKernel kernel : kKernels) {
+        double ratio = 0;
+        size_t hit = pacer::FindFirstCrossing(kernel, gate, x.data(),
+                                              y.data(), begin, end, &ratio);
+        REQUIRE(hit == expected);
+        if (hit != end) {
+          CHECK(Same(ratio, expected_ratio));
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("FindCrossings kernels match the scalar one", "[crossings]") {
+  // Gates fanned around the trajectory, so several are hit per query, at
+  // every lane position and in the tail.
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<double> coord(-5, 5);
+  for (int round = 0; round < 500; ++round) {
+    pacer::SegmentBatch batch;
+    size_t count = 1 + round % 23;
+    for (size_t i = 0; i < count; ++i) {
+      pacer::Point a{coord(rng), coord(rng)};
+      batch.push_back(i % 5 == 4 ? pacer::Segment{a, a}
+                                 : pacer::Segment{a, a * -1.0});
+    }
+    pacer::Point fst{coord(rng), coord(rng)}, snd{coord(rng), coord(rng)};
+
+    for (size_t begin = 0; begin <= count; begin += 3) {
+      std::vector<pacer::SegmentHit> expected;
+      pacer::FindCrossings(pacer::CrossingsKernel::kScalar, batch, begin,
+                           count, fst, snd, &expected);
+      for (pacer::CrossingsKernel kernel : kKernels) {
+        std::vector<pacer::SegmentHit> hits;
+        pacer::FindCrossings(kernel, batch, begin, count, fst, snd, &hits);
+        REQUIRE(hits.size() == expected.size());
+        for (size_t k = 0; k < hits.size(); ++k) {
+          CHECK(hits[k].index == expected[k].index);
+          CHECK(Same(hits[k].ratio, expected[k].ratio));
+        }
+      }
+    }
+  }
+}
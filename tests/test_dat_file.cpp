@@ -0,0 +1,136 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pacer/gps-source/dat-file.hpp>
+
+namespace {
+
+std::string TempPath(const char *name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+uGnssDecUbxNavPvt_t Fix(int i) {
+  uGnssDecUbxNavPvt_t pvt{};
+  pvt.iTOW = 1000 + 40 * i;
+  pvt.lat = 515000000 + i;
+  pvt.lon = -1278000 - i;
+  pvt.height = 20000 + i;
+  pvt.gSpeed = 15000 + i;
+  return pvt;
+}
+
+// `count` records (with the timestamp prefix when `timestamps`), then
+// `extra` raw bytes of `fill`.
+void WriteDat(const std::string &path, int count, bool timestamps,
+              size_t extra = 0, char fill = 0) {
+  FILE *f = std::fopen(path.c_str(), "wb");
+  REQUIRE(f);
+  for (int i = 0; i < count; ++i) {
+    int64_t t = 5000 + 40 * i;
+    if (timestamps) {
+      std::fwrite(&t, sizeof(t), 1, f);
+    }
+    uGnssDecUbxNavPvt_t pvt = Fix(i);
+    std::fwrite(&pvt, sizeof(pvt), 1, f);
+  }
+  std::vector<char> tail(extra, fill);
+  std::fwrite(tail.data(), 1, tail.size(), f);
+  std::fclose(f);
+}
+
+} // namespace
+
+TEST_CASE("DatFile decodes whole records", "[dat-file]") {
+  std::string path = TempPath("test_dat_file.dat");
+
+  WriteDat(path, 10, true);
+  pacer::DatFile with(path.c_str());
+  REQUIRE(with.size() == 10);
+  CHECK(with.Stride() == sizeof(uGnssDecUbxNavPvt_t) + 8);
+  CHECK(with.Timestamp(3) == 5120);
+  pacer::GPSSample s = with.Sample(3);
+  CHECK(s.timestamp_ms == 1120);
+  CHECK(s.lat == 51.5000003);
+  CHECK(s.altitude == 20.003);
+  CHECK(with.Lat()[3] == s.lat);
+  CHECK(with.TimeMs()[9] == 1360);
+
+  WriteDat(path, 10, false);
+  pacer::DatFile without(path.c_str(), pacer::DatVersion::JUST_DATA);
+  REQUIRE(without.size() == 10);
+  CHECK(without.Timestamp(3) == 0);
+  CHECK(without.Sample(9).timestamp_ms == 1360);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("DatFile drops truncated and odd-sized tails", "[dat-file]") {
+  std::string path = TempPath("test_dat_file.dat");
+
+  // Power lost mid-record: the partial record is ignored.
+  WriteDat(path, 7, true, 37, 'x');
+  CHECK(pacer::DatFile(path.c_str()).size() == 7);
+
+  // Shorter than one record, and empty.
+  WriteDat(path, 0, true, 50, 'x');
+  CHECK(pacer::DatFile(path.c_str()).empty());
+  WriteDat(path, 0, true);
+  CHECK(pacer::DatFile(path.c_str()).empty());
+
+  // A timestamped file read as JUST_DATA: 100-byte records over 92-byte
+  // strides leave an odd remainder, which is dropped too.
+  WriteDat(path, 23, true);
+  pacer::DatFile wrong(path.c_str(), pacer::DatVersion::JUST_DATA);
+  CHECK(wrong.size() == 23 * 100 / 92);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("DatFile stops at a preallocated zero tail", "[dat-file]") {
+  std::string path = TempPath("test_dat_file.dat");
+  size_t stride = sizeof(uGnssDecUbxNavPvt_t) + 8;
+
+  // Every boundary position for a short file, then a long tail.
+  for (int count = 0; count <= 9; ++count) {
+    for (size_t tail_records : {0, 1, 2, 7, 64}) {
+      WriteDat(path, count, true, tail_records * stride);
+      CHECK(pacer::DatFile(path.c_str()).size() == size_t(count));
+    }
+  }
+  WriteDat(path, 1000, true, 10000 * stride + 13);
+  pacer::DatFile file(path.c_str());
+  REQUIRE(file.size() == 1000);
+  CHECK(file.Sample(999).timestamp_ms == 1000 + 40 * 999);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("ReadDatFile streams records and throws on a missing file",
+          "[dat-file]") {
+  std::string path = TempPath("test_dat_file.dat");
+  WriteDat(path, 5, true, 3, 'x');
+
+  std::vector<int64_t> times;
+  pacer::ReadDatFile(
+      path.c_str(),
+      [&](pacer::GPSSample s, double time) {
+        times.push_back(s.timestamp_ms);
+        CHECK(time == s.timestamp_ms / 1e3);
+      },
+      pacer::DatVersion::WITH_TIMESTAMP);
+  CHECK(times == std::vector<int64_t>{1000, 1040, 1080, 1120, 1160});
+
+  std::filesystem::remove(path);
+  CHECK_THROWS_AS(pacer::DatFile(path.c_str()), std::runtime_error);
+  CHECK_THROWS_AS(
+      pacer::ReadDatFile(
+          path.c_str(), [](pacer::GPSSample, double) {},
+          pacer::DatVersion::WITH_TIMESTAMP),
+      std::runtime_error);
+}
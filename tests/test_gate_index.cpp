@@ -0,0 +1,123 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <pacer/geometry/gate-index.hpp>
+
+namespace {
+
+// A closed wiggly loop of ~1 m gates across a 400 m box, like a densified
+// track, plus a few long stray gates crossing it.
+std::vector<pacer::Segment> LoopGates() {
+  std::vector<pacer::Segment> gates;
+  for (int i = 0; i < 1500; ++i) {
+    double t = 2 * M_PI * i / 1500;
+    double r = 150 + 30 * std::sin(5 * t);
+    pacer::Point c{200 + r * std::cos(t), 200 + r * std::sin(t)};
+    pacer::Point n{std::cos(t), std::sin(t)};
+    gates.push_back(pacer::Segment{c - n * 4.0, c + n * 4.0});
+  }
+  gates.push_back(pacer::Segment{{0, 0}, {400, 400}});
+  gates.push_back(pacer::Segment{{0, 400}, {400, 0}});
+  return gates;
+}
+
+size_t BruteNearest(const std::vector<pacer::Segment> &gates, pacer::Point p) {
+  size_t best = 0;
+  double best_dist = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < gates.size(); ++i) {
+    double dist = pacer::DistanceToSegment(gates[i], p);
+    if (dist < best_dist) {
+      best_dist = dist;
+      best = i;
+    }
+  }
+  return best;
+}
+
+std::vector<uint32_t> BruteCrossings(const std::vector<pacer::Segment> &gates,
+                                     pacer::Point fst, pacer::Point snd) {
+  std::vector<uint32_t> hits;
+  for (size_t i = 0; i < gates.size(); ++i) {
+    if (gates[i].Intersects(fst, snd, nullptr)) {
+      hits.push_back(static_cast<uint32_t>(i));
+    }
+  }
+  return hits;
+}
+
+} // namespace
+
+TEST_CASE("GateIndex::Nearest matches brute force", "[gate-index]") {
+  std::vector<pacer::Segment> gates = LoopGates();
+  pacer::GateIndex index(gates);
+
+  std::mt19937 rng(42);
+  // Includes points well outside the grid, which clamp to edge cells.
+  std::uniform_real_distribution<double> coord(-100, 500);
+  for (int i = 0; i < 5000; ++i) {
+    pacer::Point p{coord(rng), coord(rng)};
+    std::optional<size_t> nearest = index.Nearest(p);
+    REQUIRE(nearest.has_value());
+    size_t brute = BruteNearest(gates, p);
+    CHECK(pacer::DistanceToSegment(gates[*nearest], p) ==
+          pacer::DistanceToSegment(gates[brute], p));
+  }
+}
+
+TEST_CASE("GateIndex::Crossings matches brute force", "[gate-index]") {
+  std::vector<pacer::Segment> gates = LoopGates();
+  pacer::GateIndex index(gates);
+
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> coord(-50, 450);
+  std::uniform_real_distribution<double> step(-20, 20);
+  std::vector<pacer::GateIndex::Crossing> out;
+  for (int i = 0; i < 5000; ++i) {
+    pacer::Point fst{coord(rng), coord(rng)};
+    pacer::Point snd = fst + pacer::Point{step(rng), step(rng)};
+    index.Crossings(fst, snd, &out);
+    std::vector<uint32_t> brute = BruteCrossings(gates, fst, snd);
+    REQUIRE(out.size() == brute.size());
+    for (size_t k = 0; k < out.size(); ++k) {
+      CHECK(out[k].index == brute[k]);
+      double ratio = 0;
+      gates[brute[k]].Intersects(fst, snd, &ratio);
+      CHECK(std::abs(out[k].ratio - ratio) < 1e-9);
+    }
+  }
+}
+
+TEST_CASE("GateIndex handles empty and degenerate gates", "[gate-index]") {
+  std::vector<pacer::GateIndex::Crossing> out{{.index = 1, .ratio = 0.5}};
+
+  pacer::GateIndex empty;
+  CHECK(empty.empty());
+  CHECK_FALSE(empty.Nearest(pacer::Point{1, 2}).has_value());
+  empty.Crossings(pacer::Point{0, 0}, pacer::Point{1, 1}, &out);
+  CHECK(out.empty());
+
+  // A single zero-length gate: a zero-area grid, nothing can cross it.
+  pacer::GateIndex point({pacer::Segment{{5, 5}, {5, 5}}});
+  CHECK(point.Nearest(pacer::Point{-100, 40}) == 0u);
+  point.Crossings(pacer::Point{0, 0}, pacer::Point{10, 10}, &out);
+  CHECK(out.empty());
+
+  // Gates all on one horizontal line (zero-height grid), one of them a
+  // repeat: every query still resolves and crossings stay unique.
+  std::vector<pacer::Segment> flat;
+  for (int i = 0; i < 50; ++i) {
+    flat.push_back(pacer::Segment{{i * 2.0, 0}, {i * 2.0 + 1, 0}});
+  }
+  flat.push_back(flat[10]);
+  pacer::GateIndex line(flat);
+  CHECK(line.Nearest(pacer::Point{20.5, 3}) == 10u);
+  CHECK(line.Nearest(pacer::Point{1e6, -1e6}) == 49u);
+  line.Crossings(pacer::Point{20.5, -1}, pacer::Point{20.5, 1}, &out);
+  REQUIRE(out.size() == 2);
+  CHECK(out[0].index == 10);
+  CHECK(out[1].index == 50);
+}
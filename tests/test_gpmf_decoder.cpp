@@ -0,0 +1,247 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pacer/gps-source/gpmf-reader.hpp>
+
+namespace {
+
+// Builds a GPMF payload the way the camera writes it: big-endian KLVs of a
+// FourCC key, a type char, the struct size and the repeat count, with the
+// data padded to 32 bits.
+class GPMFWriter {
+public:
+  GPMFWriter &Raw(const char *key, char type, uint8_t size, uint16_t repeat,
+                  const std::vector<uint8_t> &data) {
+    bytes_.insert(bytes_.end(), key, key + 4);
+    bytes_.push_back(static_cast<uint8_t>(type));
+    bytes_.push_back(size);
+    bytes_.push_back(static_cast<uint8_t>(repeat >> 8));
+    bytes_.push_back(static_cast<uint8_t>(repeat));
+    bytes_.insert(bytes_.end(), data.begin(), data.end());
+    bytes_.resize((bytes_.size() + 3) / 4 * 4, 0);
+    return *this;
+  }
+
+  /// Integers of type `type` ('s', 'l' or 'L'), `per_struct` to a sample.
+  template <typename T>
+  GPMFWriter &Ints(const char *key, char type, size_t per_struct,
+                   const std::vector<T> &values) {
+    std::vector<uint8_t> data;
+    for (T value : values) {
+      auto bits = static_cast<uint64_t>(value);
+      for (size_t b = sizeof(T); b-- > 0;) {
+        data.push_back(static_cast<uint8_t>(bits >> (8 * b)));
+      }
+    }
+    return Raw(key, type, static_cast<uint8_t>(sizeof(T) * per_struct),
+               static_cast<uint16_t>(values.size() / per_struct), data);
+  }
+
+  /// Strings of `size` chars each, concatenated in `text`.
+  GPMFWriter &Chars(const char *key, char type, uint8_t size,
+                    const std::string &text) {
+    return Raw(key, type, size, static_cast<uint16_t>(text.size() / size),
+               std::vector<uint8_t>(text.begin(), text.end()));
+  }
+
+  GPMFWriter &Nest(const char *key, const GPMFWriter &inner) {
+    return Raw(key, '\0', 4, static_cast<uint16_t>(inner.bytes_.size() / 4),
+               inner.bytes_);
+  }
+
+  std::vector<uint32_t> Words() const {
+    std::vector<uint32_t> words(bytes_.size() / 4);
+    std::memcpy(words.data(), bytes_.data(), bytes_.size());
+    return words;
+  }
+
+private:
+  std::vector<uint8_t> bytes_;
+};
+
+constexpr int kFixes = 18;
+constexpr int kImu = 200;
+
+// A GPS5 stream of kFixes fixes, with `gpsu` (16 chars per entry, if any).
+GPMFWriter GPS5Stream(const std::string &gpsu) {
+  std::vector<int32_t> gps;
+  for (int i = 0; i < kFixes; ++i) {
+    gps.insert(gps.end(),
+               {515000000 + i, -1278000 - i, 20000 + i, 15000 + i, 16000 + i});
+  }
+  GPMFWriter stream;
+  stream.Chars("STNM", 'c', 10, "GPS (Lat.)");
+  stream.Ints<uint32_t>("GPSF", 'L', 1, {3});
+  if (!gpsu.empty()) {
+    stream.Chars("GPSU", 'U', 16, gpsu);
+  }
+  stream.Ints<int32_t>("SCAL", 'l', 1, {10000000, 10000000, 1000, 1000, 1000});
+  stream.Chars("SIUN", 'c', 4, std::string("deg\0deg\0m\0\0\0m/s\0m/s\0", 20));
+  stream.Ints<int32_t>("GPS5", 'l', 5, gps);
+  return stream;
+}
+
+// An IMU stream of kImu readings, channel k of reading i at (i + k) / scale,
+// with `orin` (if any) naming the camera axis of each channel.
+GPMFWriter ImuStream(const char *key, int16_t scale,
+                     const std::string &orin = "") {
+  std::vector<int16_t> values;
+  for (int i = 0; i < kImu; ++i) {
+    values.insert(values.end(), {int16_t(i), int16_t(i + 1), int16_t(i + 2)});
+  }
+  GPMFWriter stream;
+  if (!orin.empty()) {
+    stream.Chars("ORIN", 'c', 1, orin);
+  }
+  stream.Ints<int16_t>("SCAL", 's', 1, {scale});
+  stream.Ints<int16_t>(key, 's', 3, values);
+  return stream;
+}
+
+std::vector<uint32_t> Payload(const std::string &gpsu,
+                              const std::string &orin = "") {
+  GPMFWriter devc;
+  devc.Ints<uint32_t>("DVID", 'L', 1, {1});
+  devc.Chars("DVNM", 'c', 6, "Camera");
+  devc.Nest("STRM", ImuStream("ACCL", 418, orin));
+  // Streams the decoder doesn't know are skipped.
+  GPMFWriter temperature;
+  temperature.Ints<int16_t>("SCAL", 's', 1, {10});
+  temperature.Ints<int16_t>("TMPC", 's', 1, {321});
+  devc.Nest("STRM", temperature);
+  devc.Nest("STRM", GPS5Stream(gpsu));
+  devc.Nest("STRM", ImuStream("GYRO", 100, orin));
+  return GPMFWriter().Nest("DEVC", devc).Words();
+}
+
+// 2024-03-15 12:34:56.789 UTC.
+constexpr int64_t kGPSUMs = 1710506096789;
+
+} // namespace
+
+TEST_CASE("GPMFDecoder decodes GPS5 with its scale and GPSU time",
+          "[gpmf]") {
+  std::vector<uint32_t> payload = Payload("240315123456.789");
+  pacer::GPMFDecoder decoder;
+  uint32_t status = ~0u;
+  auto fixes = decoder.DecodePayload(
+      payload.data(), static_cast<uint32_t>(payload.size() * 4), &status);
+  CHECK(status == 0);
+  REQUIRE(fixes.size() == kFixes);
+  for (int i = 0; i < kFixes; ++i) {
+    const pacer::GPSSample &gps = fixes[i].gps;
+    CHECK(std::abs(gps.lat - (515000000 + i) / 1e7) < 1e-12);
+    CHECK(std::abs(gps.lon - (-1278000 - i) / 1e7) < 1e-12);
+    CHECK(std::abs(gps.altitude - (20000 + i) / 1e3) < 1e-9);
+    CHECK(std::abs(gps.full_speed - (15000 + i) / 1e3) < 1e-9);
+    CHECK(std::abs(gps.ground_speed - (16000 + i) / 1e3) < 1e-9);
+    CHECK(gps.timestamp_ms == kGPSUMs);
+    CHECK(fixes[i].index == uint32_t(i));
+    CHECK(fixes[i].count == kFixes);
+  }
+  // IMU streams are skipped unless asked for.
+  CHECK(decoder.Accel().empty());
+  CHECK(decoder.Gyro().empty());
+}
+
+TEST_CASE("GPMFDecoder takes the last of several GPSU entries", "[gpmf]") {
+  std::vector<uint32_t> payload =
+      Payload("240315123456.789240315123457.789");
+  pacer::GPMFDecoder decoder;
+  auto fixes = decoder.DecodePayload(
+      payload.data(), static_cast<uint32_t>(payload.size() * 4));
+  REQUIRE(fixes.size() == kFixes);
+  CHECK(fixes.front().gps.timestamp_ms == kGPSUMs + 1000);
+  CHECK(fixes.back().gps.timestamp_ms == kGPSUMs + 1000);
+
+  // No GPSU at all: no clock.
+  payload = Payload("");
+  fixes = decoder.DecodePayload(payload.data(),
+                                static_cast<uint32_t>(payload.size() * 4));
+  REQUIRE(fixes.size() == kFixes);
+  CHECK(fixes.front().gps.timestamp_ms == 0);
+}
+
+TEST_CASE("GPMFDecoder decodes ACCL and GYRO in the same walk", "[gpmf]") {
+  std::vector<uint32_t> payload = Payload("240315123456.789");
+  pacer::GPMFDecoder decoder;
+  decoder.SetImu(true);
+  auto fixes = decoder.DecodePayload(
+      payload.data(), static_cast<uint32_t>(payload.size() * 4));
+  CHECK(fixes.size() == kFixes);
+  REQUIRE(decoder.Accel().size() == kImu);
+  REQUIRE(decoder.Gyro().size() == kImu);
+  for (int i = 0; i < kImu; i += 17) {
+    const pacer::GPMFImuSample &a = decoder.Accel()[i];
+    CHECK(std::abs(a.x - i / 418.0) < 1e-12);
+    CHECK(std::abs(a.y - (i + 1) / 418.0) < 1e-12);
+    CHECK(std::abs(a.z - (i + 2) / 418.0) < 1e-12);
+    CHECK(a.index == uint32_t(i));
+    CHECK(a.count == kImu);
+    CHECK(std::abs(decoder.Gyro()[i].z - (i + 2) / 100.0) < 1e-12);
+  }
+}
+
+TEST_CASE("GPMFDecoder maps IMU channels onto camera axes by ORIN",
+          "[gpmf]") {
+  struct Orientation {
+    std::string orin;
+    // Channel and sign feeding camera x, y and z.
+    int channel[3];
+    double sign[3];
+  };
+  // The HERO8+ order, one with negated axes, and ORINs that aren't a
+  // permutation of XYZ (left as written).
+  const Orientation orientations[] = {
+      {"ZXY", {1, 2, 0}, {1, 1, 1}},
+      {"yXz", {1, 0, 2}, {1, -1, -1}},
+      {"XYZ", {0, 1, 2}, {1, 1, 1}},
+      {"XXZ", {0, 1, 2}, {1, 1, 1}},
+      {"X1Z", {0, 1, 2}, {1, 1, 1}},
+  };
+  for (const Orientation &orientation : orientations) {
+    CAPTURE(orientation.orin);
+    std::vector<uint32_t> payload =
+        Payload("240315123456.789", orientation.orin);
+    pacer::GPMFDecoder decoder;
+    decoder.SetImu(true);
+    decoder.DecodePayload(payload.data(),
+                          static_cast<uint32_t>(payload.size() * 4));
+    REQUIRE(decoder.Accel().size() == kImu);
+    REQUIRE(decoder.Gyro().size() == kImu);
+    for (int i = 0; i < kImu; i += 17) {
+      for (auto [imu, scale] : {std::pair{decoder.Accel(), 418.0},
+                                std::pair{decoder.Gyro(), 100.0}}) {
+        const pacer::GPMFImuSample &r = imu[i];
+        double axes[3] = {r.x, r.y, r.z};
+        for (int a = 0; a < 3; ++a) {
+          double expected =
+              orientation.sign[a] * (i + orientation.channel[a]) / scale;
+          CHECK(std::abs(axes[a] - expected) < 1e-12);
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("GPMFDecoder skips payloads it can't walk", "[gpmf]") {
+  pacer::GPMFDecoder decoder;
+  // Not GPMF at all: nothing decodes, and nothing is read past the end.
+  std::vector<uint32_t> garbage(16, 0xffffffffu);
+  CHECK(decoder
+            .DecodePayload(garbage.data(),
+                           static_cast<uint32_t>(garbage.size() * 4))
+            .empty());
+
+  // Cut short inside the GPS stream.
+  std::vector<uint32_t> payload = Payload("240315123456.789");
+  auto fixes = decoder.DecodePayload(
+      payload.data(), static_cast<uint32_t>(payload.size() * 4 / 2));
+  CHECK(fixes.size() < kFixes);
+}
@@ -0,0 +1,204 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <pacer/laps/laps.hpp>
+
+#include "synthetic-session.hpp"
+
+namespace {
+
+// Laps timed on the synthetic circuit: the first gate as the start line
+// and two more splitting it into three sectors.
+void SetupTiming(pacer::Laps &laps, const pacer::ReferenceTrack &track) {
+  laps.SetCoordinateSystem(track.cs);
+  laps.sectors.start_line = track.segments[0];
+  laps.sectors.sector_lines = {track.segments[track.sector_indices[0]],
+                               track.segments[track.sector_indices[1]]};
+}
+
+// Every lap and sector split of `a` equals the one in `b`.
+// (SectorTime() isn't const.)
+void CheckSameSplits(pacer::Laps &a, pacer::Laps &b) {
+  REQUIRE(a.LapsCount() == b.LapsCount());
+  for (size_t lap = 0; lap < a.LapsCount(); ++lap) {
+    CHECK(a.LapTime(lap) == b.LapTime(lap));
+    CHECK(a.SampleCount(lap) == b.SampleCount(lap));
+    CHECK(a.StartTimestamp(lap) == b.StartTimestamp(lap));
+    CHECK(a.LapEntrySpeed(lap) == b.LapEntrySpeed(lap));
+  }
+  REQUIRE(a.RecordedSectors() == b.RecordedSectors());
+  for (size_t sector = 0; sector < a.RecordedSectors(); ++sector) {
+    CHECK(a.SectorTime(sector) == b.SectorTime(sector));
+    CHECK(a.SectorStartTimestamp(sector) == b.SectorStartTimestamp(sector));
+  }
+}
+
+} // namespace
+
+TEST_CASE("Laps::Update on appended chunks matches a one-shot split",
+          "[laps]") {
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  std::vector<pacer::GPSSample> samples =
+      pacer::testing::SyntheticSession(10 * 60);
+
+  pacer::Laps whole;
+  SetupTiming(whole, track);
+  for (const pacer::GPSSample &s : samples) {
+    whole.AddPoint(s);
+  }
+  whole.Update();
+  REQUIRE(whole.LapsCount() > 10);
+  REQUIRE(whole.RecordedSectors() > 30);
+
+  // Chunks from a single point up to several hundred, so crossings land
+  // on the first and last point of a chunk as well as inside it.
+  pacer::Laps chunked;
+  SetupTiming(chunked, track);
+  std::mt19937 rng(17);
+  std::uniform_int_distribution<size_t> chunk(1, 400);
+  chunked.Update();
+  uint64_t version = chunked.Version();
+  for (size_t i = 0; i < samples.size();) {
+    size_t end = std::min(samples.size(), i + chunk(rng));
+    for (; i < end; ++i) {
+      chunked.AddPoint(samples[i]);
+    }
+    chunked.Update();
+    // Appending never re-splits.
+    CHECK(chunked.Version() == version);
+  }
+  CheckSameSplits(whole, chunked);
+
+  // Every point on its own.
+  pacer::Laps single;
+  SetupTiming(single, track);
+  for (const pacer::GPSSample &s : samples) {
+    single.AddPoint(s);
+    single.Update();
+  }
+  CheckSameSplits(whole, single);
+}
+
+TEST_CASE("Laps::Update re-splits after the timing lines change", "[laps]") {
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  std::vector<pacer::GPSSample> samples =
+      pacer::testing::SyntheticSession(5 * 60);
+
+  pacer::Laps laps;
+  SetupTiming(laps, track);
+  size_t half = samples.size() / 2;
+  for (size_t i = 0; i < half; ++i) {
+    laps.AddPoint(samples[i]);
+  }
+  laps.Update();
+  uint64_t version = laps.Version();
+
+  // Move the start line, then keep appending.
+  laps.sectors.start_line = track.segments[5];
+  for (size_t i = half; i < samples.size(); ++i) {
+    laps.AddPoint(samples[i]);
+  }
+  laps.Update();
+  CHECK(laps.Version() > version);
+
+  pacer::Laps fresh;
+  SetupTiming(fresh, track);
+  fresh.sectors.start_line = track.segments[5];
+  for (const pacer::GPSSample &s : samples) {
+    fresh.AddPoint(s);
+  }
+  fresh.Update();
+  CheckSameSplits(fresh, laps);
+
+  // ClearPoints() drops the splits even with the lines left as they are.
+  laps.ClearPoints();
+  laps.Update();
+  CHECK(laps.LapsCount() == 0);
+  CHECK(laps.RecordedSectors() == 0);
+  for (const pacer::GPSSample &s : samples) {
+    laps.AddPoint(s);
+  }
+  laps.Update();
+  CheckSameSplits(fresh, laps);
+}
+
+TEST_CASE("Laps column storage returns the samples it was given", "[laps]") {
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  std::vector<pacer::GPSSample> samples =
+      pacer::testing::SyntheticSession(3 * 60);
+  // Values float can't hold exactly.
+  for (size_t i = 0; i < samples.size(); ++i) {
+    samples[i].altitude = 100.000123 + 1e-7 * static_cast<double>(i);
+    samples[i].full_speed += 1e-9;
+    samples[i].ground_speed = samples[i].full_speed - 0.123456789;
+  }
+
+  pacer::Laps laps;
+  for (const pacer::GPSSample &s : samples) {
+    laps.AddPoint(s);
+  }
+  REQUIRE(laps.PointCount() == samples.size());
+  CHECK_FALSE(laps.HasLocalPoints());
+
+  double min_lon = samples[0].lon, max_lon = samples[0].lon;
+  double min_lat = samples[0].lat, max_lat = samples[0].lat;
+  for (size_t i = 0; i < samples.size(); ++i) {
+    pacer::GPSSample p = laps.GetPoint(i);
+    CHECK(p.lat == samples[i].lat);
+    CHECK(p.lon == samples[i].lon);
+    CHECK(p.altitude == samples[i].altitude);
+    CHECK(p.full_speed == samples[i].full_speed);
+    CHECK(p.ground_speed == samples[i].ground_speed);
+    CHECK(p.timestamp_ms == samples[i].timestamp_ms);
+    min_lon = std::min(min_lon, samples[i].lon);
+    max_lon = std::max(max_lon, samples[i].lon);
+    min_lat = std::min(min_lat, samples[i].lat);
+    max_lat = std::max(max_lat, samples[i].lat);
+  }
+  auto [lo, hi] = laps.MinMax();
+  CHECK(lo.x == min_lon);
+  CHECK(lo.y == min_lat);
+  CHECK(hi.x == max_lon);
+  CHECK(hi.y == max_lat);
+
+  // The frame projects every point once, into the cumulative distances
+  // behind Distance() and, only if asked for, the float32 local columns.
+  SetupTiming(laps, track);
+  laps.Update();
+  CHECK_FALSE(laps.HasLocalPoints());
+  laps.KeepLocalPoints(true);
+  CHECK_FALSE(laps.HasLocalPoints());
+  SetupTiming(laps, track);
+  laps.Update();
+  REQUIRE(laps.HasLocalPoints());
+  for (size_t i = 0; i < samples.size(); i += 97) {
+    pacer::Vec3f local = track.cs.Local(samples[i]);
+    CHECK(std::abs(laps.LocalPoint(i).x - local[0]) < 1e-3);
+    CHECK(std::abs(laps.LocalPoint(i).y - local[1]) < 1e-3);
+  }
+  REQUIRE(laps.LapsCount() > 1);
+  pacer::Lap lap = laps.GetLap(0);
+  REQUIRE(lap.Count() == laps.SampleCount(0) - 1);
+  // Up to the last recorded point; the finish split follows it.
+  for (size_t row = 0; row + 1 < lap.Count(); ++row) {
+    CHECK(laps.At(0, row).altitude == lap.points[row].altitude);
+    CHECK(laps.Speed(0, row) == lap.points[row].full_speed);
+    CHECK(std::abs(laps.Distance(0, row) - lap.cum_distances[row]) < 1e-6);
+  }
+
+  // Appended points are projected as they come; turning the columns off
+  // drops them for good.
+  laps.AddPoint(samples.front());
+  pacer::Vec3f local = track.cs.Local(samples.front());
+  CHECK(std::abs(laps.LocalPoint(samples.size()).x - local[0]) < 1e-3);
+  laps.KeepLocalPoints(false);
+  SetupTiming(laps, track);
+  laps.Update();
+  CHECK_FALSE(laps.HasLocalPoints());
+  CHECK(laps.LapsCount() > 1);
+}
@@ -0,0 +1,173 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <pacer/live-timing/live-timing.hpp>
+
+#include "synthetic-session.hpp"
+
+namespace {
+
+// Both NaN, or within `tolerance`.
+bool Close(double a, double b, double tolerance) {
+  return (std::isnan(a) && std::isnan(b)) || std::abs(a - b) <= tolerance;
+}
+
+} // namespace
+
+TEST_CASE("Single-precision live timing matches double within a ms",
+          "[live-timing]") {
+  // A 3 h endurance run, ~220 laps: no sample may cross a different gate
+  // in float than in double.
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  std::vector<pacer::GPSSample> samples =
+      pacer::testing::SyntheticSession(3 * 60 * 60);
+
+  pacer::LiveTiming timing;
+  pacer::LiveTimingF timing_f;
+  timing.SetReferenceTrack(track);
+  timing_f.SetReferenceTrack(track);
+
+  // A crossing may round to the neighbouring millisecond.
+  constexpr double kMs = 1.001e-3;
+  size_t mismatches = 0;
+  for (const pacer::GPSSample &s : samples) {
+    timing.OnSample(s);
+    timing_f.OnSample(s);
+    pacer::LiveSnapshot a = timing.Snapshot(), b = timing_f.Snapshot();
+
+    REQUIRE(a.lap_number == b.lap_number);
+    CHECK(Close(a.last_lap_s, b.last_lap_s, kMs));
+    CHECK(Close(a.best_lap_s, b.best_lap_s, kMs));
+    CHECK(Close(a.current_lap_s, b.current_lap_s, kMs));
+    CHECK(a.delta_valid == b.delta_valid);
+    // Gate times show through the delta: current minus best at each gate.
+    if (a.gates_crossed != b.gates_crossed) {
+      ++mismatches;
+    }
+    CHECK(Close(a.delta_s, b.delta_s, kMs));
+
+    auto offset = timing.OffsetFromTrack(s);
+    auto offset_f = timing_f.OffsetFromTrack(s);
+    REQUIRE(offset_f.has_value());
+    CHECK(std::abs(offset->lateral_m - offset_f->lateral_m) < 0.01);
+  }
+
+  CHECK(timing.Snapshot().lap_number > 200);
+  CHECK(mismatches == 0);
+}
+
+TEST_CASE("Linearized frame times laps like the exact one",
+          "[live-timing]") {
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  std::vector<pacer::GPSSample> samples =
+      pacer::testing::SyntheticSession(5 * 60);
+
+  pacer::LiveTiming linearized, exact;
+  linearized.SetReferenceTrack(track);
+  exact.SetReferenceTrack(track,
+                          pacer::SessionConfig{.frame =
+                                                   pacer::TimingFrame::kExact});
+
+  constexpr double kMs = 1.001e-3;
+  for (const pacer::GPSSample &s : samples) {
+    linearized.OnSample(s);
+    exact.OnSample(s);
+    pacer::LiveSnapshot a = linearized.Snapshot(), b = exact.Snapshot();
+    REQUIRE(a.lap_number == b.lap_number);
+    CHECK(Close(a.last_lap_s, b.last_lap_s, kMs));
+    CHECK(Close(a.best_lap_s, b.best_lap_s, kMs));
+  }
+  CHECK(exact.Snapshot().lap_number > 2);
+}
+
+TEST_CASE("Live timing in caller storage matches owned storage",
+          "[live-timing]") {
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  std::vector<pacer::GPSSample> samples =
+      pacer::testing::SyntheticSession(5 * 60);
+
+  size_t gates = track.DensifiedGates().size();
+  std::vector<int32_t> a(gates), b(gates), small_a(gates - 1),
+      small_b(gates - 1);
+
+  pacer::LiveTimingF owned, external, too_small;
+  CHECK(external.SetGateTimeStorage(a, b));
+  // Falls back to owned arrays.
+  CHECK(too_small.SetGateTimeStorage(small_a, small_b));
+  owned.SetReferenceTrack(track);
+  external.SetReferenceTrack(track);
+  too_small.SetReferenceTrack(track);
+
+  for (const pacer::GPSSample &s : samples) {
+    owned.OnSample(s);
+    external.OnSample(s);
+    too_small.OnSample(s);
+    for (const pacer::LiveTimingF *other : {&external, &too_small}) {
+      pacer::LiveSnapshot x = owned.Snapshot(), y = other->Snapshot();
+      REQUIRE(x.lap_number == y.lap_number);
+      CHECK(Close(x.best_lap_s, y.best_lap_s, 0));
+      CHECK(Close(x.delta_s, y.delta_s, 0));
+      CHECK(x.gates_crossed == y.gates_crossed);
+    }
+  }
+
+  CHECK(owned.Snapshot().lap_number > 2);
+  CHECK(owned.Snapshot().delta_valid);
+}
+
+TEST_CASE("Live timing keeps its gate-time arrays until the next track",
+          "[live-timing]") {
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  std::vector<pacer::GPSSample> samples =
+      pacer::testing::SyntheticSession(5 * 60);
+
+  size_t gates = track.DensifiedGates().size();
+  std::vector<int32_t> a(gates), b(gates), small(gates - 1);
+
+  pacer::LiveTimingF owned, swapped;
+  owned.SetReferenceTrack(track);
+  REQUIRE(swapped.SetGateTimeStorage(a, b));
+  swapped.SetReferenceTrack(track);
+
+  // Storage swapped mid-session, for none and then for arrays too short
+  // for this track: the session carries on in the arrays it started with.
+  for (size_t i = 0; i < samples.size(); ++i) {
+    if (i == samples.size() / 3) {
+      CHECK(swapped.SetGateTimeStorage({}, {}));
+    } else if (i == 2 * samples.size() / 3) {
+      CHECK(swapped.SetGateTimeStorage(small, b));
+    }
+    owned.OnSample(samples[i]);
+    swapped.OnSample(samples[i]);
+    pacer::LiveSnapshot x = owned.Snapshot(), y = swapped.Snapshot();
+    REQUIRE(x.lap_number == y.lap_number);
+    CHECK(Close(x.best_lap_s, y.best_lap_s, 0));
+    CHECK(Close(x.delta_s, y.delta_s, 0));
+  }
+  CHECK(owned.Snapshot().lap_number > 2);
+  CHECK(owned.Snapshot().delta_valid);
+
+  // Overlapping arrays would share the current and best laps: refused, and
+  // the next track gets owned arrays, leaving `a` alone.
+  std::fill(a.begin(), a.end(), 7);
+  CHECK_FALSE(swapped.SetGateTimeStorage(a, a));
+  CHECK_FALSE(swapped.SetGateTimeStorage(std::span(a).first(gates / 2 + 1),
+                                         std::span(a).subspan(gates / 2)));
+  CHECK(swapped.SetGateTimeStorage(std::span(a).first(gates / 2),
+                                   std::span(a).subspan(gates / 2)));
+  CHECK_FALSE(swapped.SetGateTimeStorage(a, a));
+  owned.SetReferenceTrack(track);
+  swapped.SetReferenceTrack(track);
+  for (const pacer::GPSSample &s : samples) {
+    owned.OnSample(s);
+    swapped.OnSample(s);
+    REQUIRE(owned.Snapshot().lap_number == swapped.Snapshot().lap_number);
+    CHECK(Close(owned.Snapshot().delta_s, swapped.Snapshot().delta_s, 0));
+  }
+  CHECK(std::all_of(a.begin(), a.end(), [](int32_t t) { return t == 7; }));
+}
@@ -0,0 +1,112 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pacer/gps-source/gps-source.hpp>
+#include <pacer/gps-source/ubx-nav-pvt.hpp>
+
+namespace {
+
+std::string TempPath(const std::string &name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// A .dat log of `count` fixes whose iTOW encodes (file, index), so replay
+// order can be checked sample by sample.
+std::string WriteDat(int file, int count) {
+  std::string path = TempPath("test_load_gps_files_" + std::to_string(file) +
+                              ".dat");
+  FILE *f = std::fopen(path.c_str(), "wb");
+  REQUIRE(f);
+  for (int i = 0; i < count; ++i) {
+    int64_t t = 0;
+    uGnssDecUbxNavPvt_t pvt{};
+    pvt.iTOW = 1000000 * file + i;
+    pvt.lat = 515000000 + i;
+    std::fwrite(&t, sizeof(t), 1, f);
+    std::fwrite(&pvt, sizeof(pvt), 1, f);
+  }
+  std::fclose(f);
+  return path;
+}
+
+} // namespace
+
+TEST_CASE("LoadGPSFiles replays files in order and reports errors",
+          "[load-gps-files]") {
+  std::vector<std::string> files;
+  for (int k = 0; k < 24; ++k) {
+    files.push_back(WriteDat(k, 50 + 37 * k));
+  }
+  // Skipped, missing and undecodable inputs in between.
+  files.insert(files.begin() + 3, "");
+  files.insert(files.begin() + 7, TempPath("test_load_gps_files_missing"));
+  std::string bogus = TempPath("test_load_gps_files_bogus.pcl");
+  std::ofstream(bogus) << "not a compact log";
+  files.insert(files.begin() + 12, bogus);
+
+  std::vector<int64_t> times;
+  std::vector<std::string> errors;
+  size_t loaded = pacer::LoadGPSFiles(
+      files, [&](pacer::GPSSample s) { times.push_back(s.timestamp_ms); },
+      &errors);
+
+  CHECK(loaded == 24);
+  REQUIRE(errors.size() == 2);
+  CHECK(errors[0].find("missing: not found") != std::string::npos);
+  CHECK(errors[1].find("bogus.pcl: not a compact session log") !=
+        std::string::npos);
+
+  std::vector<int64_t> expected;
+  for (int k = 0; k < 24; ++k) {
+    for (int i = 0; i < 50 + 37 * k; ++i) {
+      expected.push_back(1000000 * k + i);
+    }
+  }
+  CHECK(times == expected);
+
+  for (const std::string &file : files) {
+    if (!file.empty()) {
+      std::filesystem::remove(file);
+    }
+  }
+}
+
+TEST_CASE("LoadGPSFiles decodes a single file on the calling thread",
+          "[load-gps-files]") {
+  // One file never starts a worker.
+  std::string path = WriteDat(0, 10);
+  size_t count = 0;
+  CHECK(pacer::LoadGPSFiles({path}, [&](pacer::GPSSample) { ++count; }) == 1);
+  CHECK(count == 10);
+  CHECK(pacer::LoadGPSFiles({}, [&](pacer::GPSSample) { ++count; }) == 0);
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("LoadGPSFiles propagates an exception from on_sample",
+          "[load-gps-files]") {
+  std::vector<std::string> files;
+  for (int k = 0; k < 16; ++k) {
+    files.push_back(WriteDat(k, 200));
+  }
+
+  size_t seen = 0;
+  CHECK_THROWS_AS(pacer::LoadGPSFiles(files,
+                                      [&](pacer::GPSSample) {
+                                        if (++seen == 250) {
+                                          throw std::runtime_error("stop");
+                                        }
+                                      }),
+                  std::runtime_error);
+  CHECK(seen == 250);
+
+  for (const std::string &file : files) {
+    std::filesystem::remove(file);
+  }
+}
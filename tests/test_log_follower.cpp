@@ -0,0 +1,164 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <pacer/gps-source/log-follower.hpp>
+#include <pacer/gps-source/ubx-nav-pvt.hpp>
+
+namespace {
+
+std::string TempPath(const std::string &name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// .dat records whose iTOW is 1000 * file + index, so every fix says which
+// file it came from.
+std::string DatRecords(int file, int first, int count) {
+  std::string bytes;
+  for (int i = first; i < first + count; ++i) {
+    int64_t t = 0;
+    uGnssDecUbxNavPvt_t pvt{};
+    pvt.iTOW = static_cast<uint32_t>(1000 * file + i);
+    pvt.lat = 515000000 + i;
+    bytes.append(reinterpret_cast<const char *>(&t), sizeof(t));
+    bytes.append(reinterpret_cast<const char *>(&pvt), sizeof(pvt));
+  }
+  return bytes;
+}
+
+constexpr size_t kRecord = sizeof(int64_t) + sizeof(uGnssDecUbxNavPvt_t);
+
+void Write(const std::string &path, const std::string &bytes,
+           std::ios::openmode mode = std::ios::trunc) {
+  std::ofstream(path, std::ios::binary | mode) << bytes;
+}
+
+struct Polled {
+  pacer::LogFollower::PollResult result;
+  std::vector<int64_t> times;
+};
+
+Polled Poll(pacer::LogFollower &follower) {
+  Polled polled;
+  polled.result = follower.Poll(
+      [&](pacer::GPSSample s) { polled.times.push_back(s.timestamp_ms); });
+  CHECK(polled.result.samples == polled.times.size());
+  return polled;
+}
+
+std::vector<int64_t> Times(int file, int first, int count) {
+  std::vector<int64_t> times;
+  for (int i = first; i < first + count; ++i) {
+    times.push_back(1000 * file + i);
+  }
+  return times;
+}
+
+} // namespace
+
+TEST_CASE("LogFollower picks up appended records", "[log-follower]") {
+  std::string path = TempPath("test_log_follower_append.dat");
+  std::filesystem::remove(path);
+  pacer::LogFollower follower(path, /*inotify=*/false);
+
+  // Not there yet.
+  CHECK(Poll(follower).times.empty());
+
+  Write(path, DatRecords(1, 0, 3));
+  CHECK(Poll(follower).times == Times(1, 0, 3));
+  CHECK(Poll(follower).times.empty());
+
+  // A record and a half: the half waits for the rest.
+  std::string more = DatRecords(1, 3, 2);
+  Write(path, more.substr(0, kRecord + kRecord / 2), std::ios::app);
+  Polled polled = Poll(follower);
+  CHECK(polled.times == Times(1, 3, 1));
+  CHECK_FALSE(polled.result.restarted);
+  Write(path, more.substr(kRecord + kRecord / 2), std::ios::app);
+  CHECK(Poll(follower).times == Times(1, 4, 1));
+  CHECK(follower.Offset() == 5 * kRecord);
+
+  // Without inotify, Wait() sleeps for the poll interval at most.
+  auto start = std::chrono::steady_clock::now();
+  CHECK(follower.Wait(20));
+  CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("LogFollower waits out a preallocated zero tail",
+          "[log-follower]") {
+  std::string path = TempPath("test_log_follower_zeros.dat");
+  Write(path, DatRecords(1, 0, 3) + std::string(5 * kRecord, '\0'));
+  pacer::LogFollower follower(path, /*inotify=*/false);
+  CHECK(Poll(follower).times == Times(1, 0, 3));
+  CHECK(follower.Offset() == 3 * kRecord);
+
+  // The logger fills the zeros in place; the file doesn't grow.
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(static_cast<std::streamoff>(3 * kRecord));
+    file << DatRecords(1, 3, 2);
+  }
+  Polled polled = Poll(follower);
+  CHECK(polled.times == Times(1, 3, 2));
+  CHECK_FALSE(polled.result.restarted);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("LogFollower starts over on a truncated file", "[log-follower]") {
+  std::string path = TempPath("test_log_follower_truncate.dat");
+  Write(path, DatRecords(1, 0, 6));
+  pacer::LogFollower follower(path, /*inotify=*/false);
+  CHECK(Poll(follower).times == Times(1, 0, 6));
+
+  // Rewritten in place, shorter.
+  Write(path, DatRecords(2, 0, 2));
+  Polled polled = Poll(follower);
+  CHECK(polled.result.restarted);
+  CHECK(polled.times == Times(2, 0, 2));
+
+  Write(path, DatRecords(2, 2, 1), std::ios::app);
+  polled = Poll(follower);
+  CHECK_FALSE(polled.result.restarted);
+  CHECK(polled.times == Times(2, 2, 1));
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("LogFollower starts over on a replaced file", "[log-follower]") {
+  std::string path = TempPath("test_log_follower_replace.dat");
+  std::string next = TempPath("test_log_follower_replace.dat.part");
+  Write(path, DatRecords(1, 0, 3));
+  pacer::LogFollower follower(path, /*inotify=*/false);
+  CHECK(Poll(follower).times == Times(1, 0, 3));
+
+  // A sync tool renames a new, longer copy over the log: its size alone
+  // looks like an append.
+  Write(next, DatRecords(2, 0, 5));
+  std::filesystem::rename(next, path);
+  Polled polled = Poll(follower);
+  CHECK(polled.result.restarted);
+  CHECK(polled.times == Times(2, 0, 5));
+
+  // The same size again.
+  Write(next, DatRecords(3, 0, 5));
+  std::filesystem::rename(next, path);
+  polled = Poll(follower);
+  CHECK(polled.result.restarted);
+  CHECK(polled.times == Times(3, 0, 5));
+
+  // And then followed as usual.
+  Write(path, DatRecords(3, 5, 2), std::ios::app);
+  polled = Poll(follower);
+  CHECK_FALSE(polled.result.restarted);
+  CHECK(polled.times == Times(3, 5, 2));
+
+  std::filesystem::remove(path);
+}
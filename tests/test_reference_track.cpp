@@ -0,0 +1,159 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pacer/reference-track/reference-track.hpp>
+
+#include "synthetic-session.hpp"
+
+namespace {
+
+std::string TempPath(const std::string &name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::string ReadBytes(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), {});
+}
+
+void WriteBytes(const std::string &path, const std::string &bytes) {
+  std::ofstream(path, std::ios::binary) << bytes;
+}
+
+// .ptrk header offsets.
+constexpr size_t kHeaderSize = 56;
+constexpr size_t kGateCountAt = 16;
+
+} // namespace
+
+TEST_CASE("ReferenceTrack round-trips through a .ptrk file",
+          "[reference-track]") {
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  std::string path = TempPath("test_reference_track.ptrk");
+  track.SaveToFile(path);
+  pacer::ReferenceTrack loaded = pacer::ReferenceTrack::FromFile(path);
+
+  REQUIRE(loaded.Precomputed() != nullptr);
+  CHECK(loaded.segments == track.segments);
+  CHECK(loaded.sector_indices == track.sector_indices);
+  CHECK(loaded.cs.Origin().lat == track.cs.Origin().lat);
+  CHECK(loaded.cs.Origin().lon == track.cs.Origin().lon);
+  CHECK(loaded.DensifiedGates() == track.DensifiedGates());
+  CHECK(loaded.DensifiedGlobalGates() == track.DensifiedGlobalGates());
+
+  // Gates built for another extension are recomputed, not reused.
+  loaded.gate_extension_m += 1;
+  CHECK(loaded.Precomputed() == nullptr);
+  CHECK(loaded.DensifiedGates().front() == loaded.TimingLine(0));
+
+  // The extension the gates were built with comes back with them.
+  track.gate_extension_m = 3.0;
+  track.SaveToFile(path);
+  loaded = pacer::ReferenceTrack::FromFile(path);
+  CHECK(loaded.gate_extension_m == 3.0);
+  REQUIRE(loaded.Precomputed() != nullptr);
+  CHECK(loaded.DensifiedGates().front() == track.TimingLine(0));
+  CHECK(loaded.DensifiedGates() == track.DensifiedGates());
+
+  // A track without segments round-trips too, with nothing precomputed.
+  pacer::ReferenceTrack empty;
+  empty.SaveToFile(path);
+  loaded = pacer::ReferenceTrack::FromFile(path);
+  CHECK(loaded.segments.empty());
+  CHECK(loaded.Precomputed() == nullptr);
+  CHECK(loaded.DensifiedGates().empty());
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("ReferenceTrack drops precomputed gates that went stale",
+          "[reference-track]") {
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  track.PrecomputeGates();
+  REQUIRE(track.Precomputed() != nullptr);
+
+  // An interior gate moved: the first and last gates still match.
+  pacer::ReferenceTrack moved = track;
+  moved.segments[moved.segments.size() / 2].first.x += 3;
+  CHECK(moved.Precomputed() == nullptr);
+  pacer::ReferenceTrack fresh = moved;
+  fresh.precomputed = {};
+  CHECK(moved.DensifiedGates() == fresh.DensifiedGates());
+  CHECK(moved.DensifiedGates() != track.DensifiedGates());
+
+  // A gate added or removed in the middle.
+  pacer::ReferenceTrack fewer = track;
+  fewer.segments.erase(fewer.segments.begin() + 10);
+  CHECK(fewer.Precomputed() == nullptr);
+
+  // The same local gates in another frame are elsewhere on the globe.
+  pacer::ReferenceTrack shifted = track;
+  pacer::GPSSample origin = shifted.cs.Origin();
+  origin.lon += 0.01;
+  shifted.cs = pacer::CoordinateSystem(origin);
+  CHECK(shifted.Precomputed() == nullptr);
+  CHECK(shifted.DensifiedGlobalGates() != track.DensifiedGlobalGates());
+
+  // Precomputing again picks the changes up.
+  moved.PrecomputeGates();
+  REQUIRE(moved.Precomputed() != nullptr);
+  CHECK(moved.DensifiedGates() == fresh.DensifiedGates());
+}
+
+TEST_CASE("ReferenceTrack rejects a bad .ptrk file", "[reference-track]") {
+  std::string path = TempPath("test_reference_track_source.ptrk");
+  std::string bad = TempPath("test_reference_track_bad.ptrk");
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  track.SaveToFile(path);
+  std::string bytes = ReadBytes(path);
+  std::filesystem::remove(path);
+  REQUIRE(bytes.size() > kHeaderSize);
+
+  CHECK_THROWS_AS(pacer::ReferenceTrack::FromFile(bad), std::runtime_error);
+
+  std::string magic = bytes;
+  magic[0] = 'X';
+  WriteBytes(bad, magic);
+  CHECK_THROWS_AS(pacer::ReferenceTrack::FromFile(bad), std::runtime_error);
+
+  std::string version = bytes;
+  version[8] = 2;
+  WriteBytes(bad, version);
+  CHECK_THROWS_AS(pacer::ReferenceTrack::FromFile(bad), std::runtime_error);
+
+  // Cut short anywhere: in the header, between arrays, inside one.
+  for (size_t size : {size_t{0}, kHeaderSize - 1, kHeaderSize,
+                      kHeaderSize + 32, bytes.size() / 2, bytes.size() - 4,
+                      bytes.size() - 1}) {
+    CAPTURE(size);
+    WriteBytes(bad, bytes.substr(0, size));
+    CHECK_THROWS_AS(pacer::ReferenceTrack::FromFile(bad), std::runtime_error);
+  }
+
+  // A byte too many.
+  WriteBytes(bad, bytes + '\0');
+  CHECK_THROWS_AS(pacer::ReferenceTrack::FromFile(bad), std::runtime_error);
+
+  // Counts the file doesn't hold, however plausible.
+  for (uint32_t gates : {uint32_t{999'999}, uint32_t{0xffffffff}}) {
+    CAPTURE(gates);
+    std::string counts = bytes;
+    std::memcpy(counts.data() + kGateCountAt, &gates, sizeof(gates));
+    WriteBytes(bad, counts);
+    CHECK_THROWS_AS(pacer::ReferenceTrack::FromFile(bad), std::runtime_error);
+  }
+
+  // The untouched bytes still load.
+  WriteBytes(bad, bytes);
+  CHECK(pacer::ReferenceTrack::FromFile(bad).segments == track.segments);
+
+  std::filesystem::remove(bad);
+}
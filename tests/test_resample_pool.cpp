@@ -0,0 +1,145 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <pacer/laps-display/resample-pool.hpp>
+
+#include "synthetic-session.hpp"
+
+namespace {
+
+// Laps driven around the synthetic circuit, split on its own timing lines.
+pacer::Laps SyntheticLaps(const pacer::ReferenceTrack &track) {
+  pacer::Laps laps;
+  laps.SetCoordinateSystem(track.cs);
+  laps.sectors = track.BuildSectors(track.cs);
+  for (const pacer::GPSSample &s : pacer::testing::SyntheticSession(5 * 60)) {
+    laps.AddPoint(s);
+  }
+  laps.Update();
+  return laps;
+}
+
+// Collects results until `count` have arrived (or ten seconds pass).
+std::vector<pacer::ResamplePool::Result> WaitFor(pacer::ResamplePool &pool,
+                                                 size_t count) {
+  std::vector<pacer::ResamplePool::Result> results;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (results.size() < count &&
+         std::chrono::steady_clock::now() < deadline) {
+    for (pacer::ResamplePool::Result &result : pool.TakeResults()) {
+      results.push_back(std::move(result));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return results;
+}
+
+} // namespace
+
+TEST_CASE("ResamplePool resamples like ReferenceTrack::Resample",
+          "[resample-pool]") {
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  pacer::Laps laps = SyntheticLaps(track);
+  REQUIRE(laps.LapsCount() > 3);
+
+  auto snapshot = pacer::ResamplePool::Track::Make(track, 7);
+  CHECK(snapshot->version == 7);
+  CHECK(snapshot->densified == track.DensifiedGates());
+
+  pacer::ResamplePool pool(3);
+  for (size_t lap = 0; lap < laps.LapsCount(); ++lap) {
+    pool.Submit(pacer::ResamplePool::Job{
+        .lap_id = static_cast<int>(lap),
+        .key = {.track_version = 7, .sample_count = laps.SampleCount(lap)},
+        .lap = laps.GetLap(lap),
+        .track = snapshot,
+    });
+  }
+
+  std::map<int, pacer::ResamplePool::Result> by_id;
+  for (pacer::ResamplePool::Result &result :
+       WaitFor(pool, laps.LapsCount())) {
+    by_id.emplace(result.lap_id, std::move(result));
+  }
+  REQUIRE(by_id.size() == laps.LapsCount());
+  for (auto &[id, result] : by_id) {
+    CHECK(result.key.track_version == 7);
+    CHECK(result.key.sample_count == laps.SampleCount(id));
+    pacer::Lap expected = track.Resample(laps.GetLap(id));
+    REQUIRE(result.lap.points.size() == expected.points.size());
+    for (size_t i = 0; i < expected.points.size(); ++i) {
+      CHECK(result.lap.points[i].lat == expected.points[i].lat);
+      CHECK(result.lap.points[i].lon == expected.points[i].lon);
+      CHECK(result.lap.points[i].timestamp_ms ==
+            expected.points[i].timestamp_ms);
+    }
+  }
+  CHECK(pool.TakeResults().empty());
+}
+
+TEST_CASE("ResamplePool drops queued jobs and keeps working",
+          "[resample-pool]") {
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  pacer::Laps laps = SyntheticLaps(track);
+  auto snapshot = pacer::ResamplePool::Track::Make(track, 1);
+
+  constexpr int kJobs = 200;
+  std::vector<pacer::ResamplePool::Job> jobs;
+  for (int id = 0; id < kJobs; ++id) {
+    jobs.push_back(pacer::ResamplePool::Job{
+        .lap_id = id, .key = {}, .lap = laps.GetLap(1), .track = snapshot});
+  }
+
+  // Queuing takes far less than resampling, so one worker can't have got
+  // through the queue before it is dropped.
+  pacer::ResamplePool pool(1);
+  for (pacer::ResamplePool::Job &job : jobs) {
+    pool.Submit(std::move(job));
+  }
+  pool.DropQueued();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  CHECK(pool.TakeResults().size() < kJobs);
+
+  pool.Submit(pacer::ResamplePool::Job{
+      .lap_id = -1, .key = {}, .lap = laps.GetLap(1), .track = snapshot});
+  std::vector<pacer::ResamplePool::Result> results = WaitFor(pool, 1);
+  REQUIRE(results.size() == 1);
+  CHECK(results[0].lap_id == -1);
+
+  // A pool destroyed with work queued finishes it and joins its workers.
+  for (int id = 0; id < 20; ++id) {
+    pool.Submit(pacer::ResamplePool::Job{
+        .lap_id = id, .key = {}, .lap = laps.GetLap(1), .track = snapshot});
+  }
+}
+
+TEST_CASE("ResamplePool::Track matches only an equivalent track",
+          "[resample-pool]") {
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  auto snapshot = pacer::ResamplePool::Track::Make(track, 1);
+  CHECK(snapshot->Matches(track));
+
+  // The same origin rebuilt from scratch is the same frame.
+  pacer::ReferenceTrack same = track;
+  same.cs = pacer::CoordinateSystem(track.cs.Origin());
+  CHECK(snapshot->Matches(same));
+
+  pacer::ReferenceTrack extended = track;
+  extended.gate_extension_m += 0.5;
+  CHECK_FALSE(snapshot->Matches(extended));
+
+  pacer::ReferenceTrack moved = track;
+  moved.segments[track.segments.size() / 2].first.x += 1;
+  CHECK_FALSE(snapshot->Matches(moved));
+
+  pacer::ReferenceTrack elsewhere = track;
+  pacer::GPSSample origin = track.cs.Origin();
+  origin.lat += 1e-4;
+  elsewhere.cs = pacer::CoordinateSystem(origin);
+  CHECK_FALSE(snapshot->Matches(elsewhere));
+}
@@ -0,0 +1,128 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <pacer/gps-source/session-cache.hpp>
+
+namespace {
+
+std::string TempPath(const char *name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+pacer::GPMFSession Session() {
+  pacer::GPMFSession session;
+  for (size_t k = 0; k < 3; ++k) {
+    session.payloads.push_back(pacer::GPMFSession::Payload{
+        .start_s = 1.0 * k,
+        .end_s = 1.0 * k + 1,
+        .first_sample = session.samples.size(),
+    });
+    for (int i = 0; i < 18; ++i) {
+      session.samples.push_back(pacer::GPSSample{
+          .lat = 51.5 + 1e-5 * session.samples.size(),
+          .lon = -0.12,
+          .altitude = 20,
+          .full_speed = 10,
+          .ground_speed = 9,
+          .timestamp_ms = int64_t(1000 * k + 55 * i),
+      });
+      session.payload_offset_s.push_back(i / 18.0);
+    }
+    for (int i = 0; i < 200; ++i) {
+      session.accel.time_s.push_back(k + i / 200.0);
+      session.accel.x.push_back(i);
+      session.accel.y.push_back(-i);
+      session.accel.z.push_back(9.81);
+    }
+  }
+  session.duration_s = 3;
+  return session;
+}
+
+// Overwrites the cache bytes at `offset` (see Header in session-cache.cpp:
+// magic at 0, sample_count at 32, accel_count at 56; columns after the
+// padded path).
+template <typename T>
+void Patch(const std::string &path, size_t offset, T value) {
+  std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+  f.seekp(static_cast<std::streamoff>(offset));
+  f.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+} // namespace
+
+TEST_CASE("SessionCache round-trips a session", "[session-cache]") {
+  std::string source = TempPath("test_session_cache.mp4");
+  std::ofstream(source) << "not really an mp4";
+  pacer::GPMFSession session = Session();
+  REQUIRE(pacer::SessionCache::Write(source, session));
+
+  pacer::SessionCache cache = pacer::SessionCache::Open(source);
+  REQUIRE(cache.valid());
+  REQUIRE(cache.size() == session.size());
+  CHECK(cache.PayloadCount() == 3);
+  CHECK(cache.GetPayload(2).first_sample == 36);
+  CHECK(cache.Duration() == 3);
+  CHECK(cache.Sample(40).lat == session.samples[40].lat);
+  CHECK(cache.Sample(40).timestamp_ms == session.samples[40].timestamp_ms);
+  CHECK(cache.PayloadOffset(5) == session.payload_offset_s[5]);
+  CHECK(cache.Accel().size == 600);
+  CHECK(cache.Accel().y[7] == -7);
+  CHECK(cache.Gyro().size == 0);
+
+  // Touching the source makes the cache stale.
+  std::ofstream(source, std::ios::app) << "!";
+  CHECK_FALSE(pacer::SessionCache::Open(source).valid());
+
+  std::filesystem::remove(source);
+  std::filesystem::remove(pacer::SessionCache::PathFor(source));
+}
+
+TEST_CASE("SessionCache rejects corrupt caches", "[session-cache]") {
+  std::string source = TempPath("test_session_cache.mp4");
+  std::string path = pacer::SessionCache::PathFor(source);
+  std::ofstream(source) << "not really an mp4";
+  pacer::GPMFSession session = Session();
+
+  auto rewrite = [&] {
+    REQUIRE(pacer::SessionCache::Write(source, session));
+    REQUIRE(pacer::SessionCache::Open(source).valid());
+  };
+
+  rewrite();
+  Patch(path, 0, 'X');
+  CHECK_FALSE(pacer::SessionCache::Open(source).valid());
+
+  rewrite();
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+  CHECK_FALSE(pacer::SessionCache::Open(source).valid());
+
+  rewrite();
+  std::filesystem::resize_file(path, 20);
+  CHECK_FALSE(pacer::SessionCache::Open(source).valid());
+
+  // Counts whose byte size wraps around to the real one: 2^59 more IMU
+  // entries is 2^64 more bytes.
+  rewrite();
+  Patch(path, 56, uint64_t{600} + (uint64_t{1} << 59));
+  CHECK_FALSE(pacer::SessionCache::Open(source).valid());
+  rewrite();
+  Patch(path, 32, ~uint64_t{0});
+  CHECK_FALSE(pacer::SessionCache::Open(source).valid());
+
+  // A payload pointing past the samples.
+  rewrite();
+  size_t columns = std::filesystem::file_size(path) -
+                   8 * (7 * 54 + 3 * 3 + 4 * 600);
+  Patch(path, columns + 8 * (7 * 54 + 2 * 3 + 1), uint64_t{55});
+  CHECK_FALSE(pacer::SessionCache::Open(source).valid());
+
+  std::filesystem::remove(source);
+  std::filesystem::remove(path);
+}
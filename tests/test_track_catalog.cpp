@@ -0,0 +1,208 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pacer/reference-track/track-catalog.hpp>
+
+#include "synthetic-session.hpp"
+
+namespace {
+
+// A fresh, empty directory under the temp directory.
+std::filesystem::path TempDir(const std::string &name) {
+  auto dir = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  return dir;
+}
+
+// The synthetic circuit moved by `dlat`, `dlon` degrees.
+pacer::ReferenceTrack TrackAt(double dlat, double dlon) {
+  pacer::ReferenceTrack track = pacer::testing::SyntheticTrack();
+  pacer::GPSSample origin = track.cs.Origin();
+  origin.lat += dlat;
+  origin.lon += dlon;
+  track.cs = pacer::CoordinateSystem(origin);
+  return track;
+}
+
+pacer::TrackCatalog::Entry Entry(const std::string &file, double lat,
+                                 double lon) {
+  pacer::TrackCatalog::Entry entry;
+  std::snprintf(entry.file, sizeof(entry.file), "%s", file.c_str());
+  entry.start_lat = entry.min_lat = entry.max_lat = lat;
+  entry.start_lon = entry.min_lon = entry.max_lon = lon;
+  entry.size = file.size();
+  entry.mtime = 1710506096;
+  return entry;
+}
+
+} // namespace
+
+TEST_CASE("TrackCatalog round-trips through its file", "[track-catalog]") {
+  auto dir = TempDir("test_track_catalog_format");
+  std::string path = (dir / pacer::TrackCatalog::kFileName).string();
+
+  pacer::TrackCatalog catalog;
+  catalog.entries = {Entry("a.json", 52.0, -0.7), Entry("b.json", 51.0, 1.2)};
+  catalog.SaveToFile(path);
+  CHECK(std::filesystem::file_size(path) == 16 + 2 * 128);
+  CHECK_FALSE(std::filesystem::exists(path + ".tmp"));
+
+  pacer::TrackCatalog loaded = pacer::TrackCatalog::FromFile(path);
+  REQUIRE(loaded.entries.size() == 2);
+  for (size_t i = 0; i < 2; ++i) {
+    const auto &got = loaded.entries[i], &want = catalog.entries[i];
+    CHECK(std::string(got.file) == want.file);
+    CHECK(got.size == want.size);
+    CHECK(got.mtime == want.mtime);
+    CHECK(got.start_lat == want.start_lat);
+    CHECK(got.start_lon == want.start_lon);
+  }
+
+  // Saving again replaces the file.
+  catalog.entries.pop_back();
+  catalog.SaveToFile(path);
+  CHECK(pacer::TrackCatalog::FromFile(path).entries.size() == 1);
+
+  // Missing, of another version, or cut short.
+  CHECK_THROWS_AS(pacer::TrackCatalog::FromFile((dir / "none.bin").string()),
+                  std::runtime_error);
+  std::string bytes;
+  {
+    std::ifstream in(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), {});
+  }
+  std::string bad = (dir / "bad.bin").string();
+  std::string version = bytes;
+  version[8] = 9;
+  std::ofstream(bad, std::ios::binary) << version;
+  CHECK_THROWS_AS(pacer::TrackCatalog::FromFile(bad), std::runtime_error);
+  std::ofstream(bad, std::ios::binary) << bytes.substr(0, bytes.size() - 1);
+  CHECK_THROWS_AS(pacer::TrackCatalog::FromFile(bad), std::runtime_error);
+
+  // A failed write leaves the old catalog alone: here the temporary file
+  // is a disk that is always full.
+  if (std::filesystem::exists("/dev/full")) {
+    std::filesystem::create_symlink("/dev/full", path + ".tmp");
+    catalog.entries.push_back(Entry("c.json", 50.0, 0.0));
+    CHECK_THROWS_AS(catalog.SaveToFile(path), std::runtime_error);
+    CHECK(pacer::TrackCatalog::FromFile(path).entries.size() == 1);
+    CHECK_FALSE(std::filesystem::is_symlink(path + ".tmp"));
+  }
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("TrackCatalog finds entries by name and by start line",
+          "[track-catalog]") {
+  pacer::TrackCatalog catalog;
+  CHECK(catalog.Nearest(52, -0.7) == nullptr);
+
+  catalog.Upsert(Entry("near.json", 52.0400, -0.7800));
+  catalog.Upsert(Entry("far.json", 51.5, -0.1));
+  catalog.Upsert(Entry("other.json", 52.0500, -0.7800));
+  REQUIRE(catalog.Find("far.json"));
+  CHECK(catalog.Find("far.json")->start_lat == 51.5);
+  CHECK(catalog.Find("missing.json") == nullptr);
+
+  double distance = -1;
+  const pacer::TrackCatalog::Entry *nearest =
+      catalog.Nearest(52.0401, -0.7800, &distance);
+  REQUIRE(nearest);
+  CHECK(std::string(nearest->file) == "near.json");
+  // 0.0001 degrees of latitude.
+  CHECK(std::abs(distance - 11.1) < 0.2);
+
+  // Upsert replaces in place.
+  catalog.Upsert(Entry("near.json", 51.5001, -0.1));
+  CHECK(catalog.entries.size() == 3);
+  CHECK(std::string(catalog.Nearest(52.0401, -0.78)->file) == "other.json");
+}
+
+TEST_CASE("TrackCatalog describes a track's start line and extent",
+          "[track-catalog]") {
+  pacer::ReferenceTrack track = TrackAt(0, 0);
+  pacer::TrackCatalog::Entry entry =
+      pacer::TrackCatalog::Describe(track, "stadium.json", 1234, 99);
+  CHECK(std::string(entry.file) == "stadium.json");
+  CHECK(entry.size == 1234);
+  CHECK(entry.mtime == 99);
+  pacer::Segment start = track.ToGlobal(track.segments[0]);
+  CHECK(entry.start_lat == start.first.y);
+  CHECK(entry.start_lon == start.first.x);
+  CHECK(entry.min_lat < entry.start_lat);
+  CHECK(entry.max_lat > entry.start_lat);
+  CHECK(entry.min_lon < entry.start_lon);
+  CHECK(entry.max_lon > entry.start_lon);
+
+  CHECK_THROWS_AS(pacer::TrackCatalog::Describe(pacer::ReferenceTrack{},
+                                                "empty.json", 0, 0),
+                  std::runtime_error);
+  CHECK_THROWS_AS(
+      pacer::TrackCatalog::Describe(track, std::string(64, 'x'), 0, 0),
+      std::runtime_error);
+}
+
+TEST_CASE("TrackCatalog::SaveTrack keeps the catalog current",
+          "[track-catalog]") {
+  auto dir = TempDir("test_track_catalog_save");
+  std::string catalog_path = (dir / pacer::TrackCatalog::kFileName).string();
+  std::string a = (dir / "a.json").string(), b = (dir / "b.json").string();
+
+  pacer::TrackCatalog::SaveTrack(TrackAt(0, 0), a);
+  pacer::TrackCatalog::SaveTrack(TrackAt(1, 0), b);
+  CHECK(std::filesystem::exists(pacer::ReferenceTrack::BinaryPath(a)));
+  pacer::TrackCatalog catalog = pacer::TrackCatalog::FromFile(catalog_path);
+  REQUIRE(catalog.entries.size() == 2);
+
+  // Entries match the files as they are now.
+  for (const std::string &path : {a, b}) {
+    uint64_t size;
+    int64_t mtime;
+    REQUIRE(pacer::TrackCatalog::Stat(path, &size, &mtime));
+    const pacer::TrackCatalog::Entry *entry =
+        catalog.Find(std::filesystem::path(path).filename().string());
+    REQUIRE(entry);
+    CHECK(entry->size == size);
+    CHECK(entry->mtime == mtime);
+  }
+
+  // A file changed behind the catalog's back no longer matches its entry:
+  // that's how a scan spots a stale one.
+  pacer::ReferenceTrack longer = TrackAt(1, 0);
+  longer.segments.push_back(longer.segments.back());
+  longer.SaveToFile(b);
+  uint64_t size;
+  int64_t mtime;
+  REQUIRE(pacer::TrackCatalog::Stat(b, &size, &mtime));
+  CHECK(catalog.Find("b.json")->size != size);
+
+  // Saving through the catalog brings the entry up to date, in place.
+  pacer::TrackCatalog::SaveTrack(longer, b);
+  catalog = pacer::TrackCatalog::FromFile(catalog_path);
+  REQUIRE(catalog.entries.size() == 2);
+  CHECK(catalog.Find("b.json")->size == size);
+
+  // A track without segments leaves the catalog.
+  pacer::TrackCatalog::SaveTrack(pacer::ReferenceTrack{}, a);
+  catalog = pacer::TrackCatalog::FromFile(catalog_path);
+  CHECK(catalog.Find("a.json") == nullptr);
+  CHECK(catalog.Find("b.json") != nullptr);
+
+  // An unreadable catalog is started over.
+  std::ofstream(catalog_path, std::ios::binary) << "garbage";
+  pacer::TrackCatalog::SaveTrack(TrackAt(0, 0), a);
+  catalog = pacer::TrackCatalog::FromFile(catalog_path);
+  REQUIRE(catalog.entries.size() == 1);
+  CHECK(catalog.Find("a.json") != nullptr);
+
+  std::filesystem::remove_all(dir);
+}
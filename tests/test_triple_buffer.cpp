@@ -0,0 +1,91 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include <pacer/live-timing/triple-buffer.hpp>
+
+namespace {
+
+// Every field derives from `seq`, so a torn read shows up as a mismatch.
+struct Payload {
+  uint64_t seq = 0;
+  uint64_t words[15] = {};
+
+  void Fill(uint64_t s) {
+    seq = s;
+    for (uint64_t i = 0; i < 15; ++i) {
+      words[i] = s * 31 + i;
+    }
+  }
+
+  bool Consistent() const {
+    for (uint64_t i = 0; i < 15; ++i) {
+      if (words[i] != seq * 31 + i) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+} // namespace
+
+TEST_CASE("Reader gets the latest published value", "[triple-buffer]") {
+  pacer::TripleBuffer<int> buffer;
+  CHECK_FALSE(buffer.Fresh());
+  CHECK(buffer.Read() == 0);
+
+  buffer.Publish(1);
+  buffer.Publish(2);
+  CHECK(buffer.Fresh());
+  const int &latest = buffer.Read();
+  CHECK(latest == 2);
+  CHECK_FALSE(buffer.Fresh());
+
+  // Publishing doesn't touch what the reader holds until it reads again.
+  for (int i = 3; i < 10; ++i) {
+    buffer.Publish(i);
+  }
+  CHECK(latest == 2);
+  CHECK(buffer.Read() == 9);
+  CHECK(buffer.Read() == 9);
+
+  buffer.Back() = 10;
+  CHECK(buffer.Read() == 9);
+  buffer.Publish();
+  CHECK(buffer.Read() == 10);
+}
+
+TEST_CASE("Concurrent reads are never torn or stale", "[triple-buffer]") {
+  pacer::TripleBuffer<Payload> buffer;
+  constexpr uint64_t kCount = 200'000;
+  std::atomic<bool> done{false};
+
+  std::thread writer([&] {
+    for (uint64_t s = 1; s <= kCount; ++s) {
+      buffer.Back().Fill(s);
+      buffer.Publish();
+    }
+    done = true;
+  });
+
+  uint64_t last = 0;
+  size_t torn = 0, backwards = 0;
+  while (true) {
+    bool finished = done;
+    const Payload &p = buffer.Read();
+    torn += !p.Consistent();
+    backwards += p.seq < last;
+    last = p.seq;
+    if (finished) {
+      break;
+    }
+  }
+  writer.join();
+
+  CHECK(torn == 0);
+  CHECK(backwards == 0);
+  CHECK(buffer.Read().seq == kCount);
+}
@@ -0,0 +1,110 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <pacer/gps-source/ubx-parser.hpp>
+
+namespace {
+
+std::vector<uint8_t> Frame(uint8_t cls, uint8_t id,
+                           const std::vector<uint8_t> &payload) {
+  std::vector<uint8_t> frame = {pacer::kUbxSync1,
+                                pacer::kUbxSync2,
+                                cls,
+                                id,
+                                static_cast<uint8_t>(payload.size() & 0xFF),
+                                static_cast<uint8_t>(payload.size() >> 8)};
+  frame.insert(frame.end(), payload.begin(), payload.end());
+  uint8_t ck_a, ck_b;
+  pacer::UbxChecksum(frame.data() + 2, frame.size() - 2, &ck_a, &ck_b);
+  frame.push_back(ck_a);
+  frame.push_back(ck_b);
+  return frame;
+}
+
+std::vector<uint8_t> NavPvt(uint32_t itow, int32_t lat_e7) {
+  std::vector<uint8_t> payload(pacer::kUbxNavPvtLen);
+  for (int b = 0; b < 4; ++b) {
+    payload[0 + b] = static_cast<uint8_t>(itow >> (8 * b));
+    payload[28 + b] = static_cast<uint8_t>(uint32_t(lat_e7) >> (8 * b));
+  }
+  payload[20] = 3; // 3D fix
+  return Frame(pacer::kUbxClassNav, pacer::kUbxIdNavPvt, payload);
+}
+
+void Append(std::vector<uint8_t> &stream, const std::vector<uint8_t> &bytes) {
+  stream.insert(stream.end(), bytes.begin(), bytes.end());
+}
+
+} // namespace
+
+TEST_CASE("NAV-PVT frames survive any chunking", "[ubx]") {
+  std::vector<uint8_t> stream;
+  Append(stream, {'$', 'G', 'P', 'G', 'G', 'A', '\r', '\n'});
+  for (uint32_t i = 0; i < 5; ++i) {
+    Append(stream, NavPvt(1000 + 40 * i, 515074000 + int32_t(i)));
+    Append(stream, Frame(0x05, 0x01, {0x06, 0x8A})); // ACK, not a fix
+  }
+
+  for (size_t chunk : {size_t{1}, size_t{7}, size_t{100}, stream.size()}) {
+    pacer::UbxParser parser;
+    std::vector<uGnssDecUbxNavPvt_t> fixes;
+    for (size_t i = 0; i < stream.size(); i += chunk) {
+      size_t n = std::min(chunk, stream.size() - i);
+      parser.FeedNavPvt({stream.data() + i, n},
+                        [&](const uGnssDecUbxNavPvt_t &p) {
+                          fixes.push_back(p);
+                        });
+    }
+    REQUIRE(fixes.size() == 5);
+    for (uint32_t i = 0; i < 5; ++i) {
+      CHECK(fixes[i].iTOW == 1000 + 40 * i);
+      CHECK(fixes[i].lat == 515074000 + int32_t(i));
+      CHECK(fixes[i].fixType == U_GNSS_DEC_UBX_NAV_PVT_FIX_TYPE_3D);
+    }
+    CHECK(parser.GetStats().frames == 10);
+    CHECK(parser.GetStats().skipped_bytes == 8);
+  }
+}
+
+TEST_CASE("A corrupt frame doesn't hide the next one", "[ubx]") {
+  std::vector<uint8_t> bad = NavPvt(1000, 1), good = NavPvt(1040, 2);
+  bad[40] ^= 0xFF;
+
+  // The good frame starts inside the bad one's claimed length, and a sync
+  // pair with an absurd length precedes both.
+  std::vector<uint8_t> stream = {pacer::kUbxSync1, pacer::kUbxSync2, 1, 7,
+                                 0xFF, 0xFF};
+  stream.insert(stream.end(), bad.begin(), bad.begin() + 50);
+  Append(stream, good);
+
+  pacer::UbxParser parser;
+  std::vector<uint32_t> itows;
+  for (size_t i = 0; i < stream.size(); i += 13) {
+    size_t n = std::min<size_t>(13, stream.size() - i);
+    parser.FeedNavPvt({stream.data() + i, n},
+                      [&](const uGnssDecUbxNavPvt_t &p) {
+                        itows.push_back(p.iTOW);
+                      });
+  }
+  CHECK(itows == std::vector<uint32_t>{1040});
+  CHECK(parser.GetStats().oversized == 1);
+  CHECK(parser.GetStats().checksum_errors == 1);
+}
+
+TEST_CASE("NAV-PVT converts like the .dat reader", "[ubx]") {
+  uGnssDecUbxNavPvt_t pvt{};
+  pvt.iTOW = 123456;
+  pvt.lat = 515074000;
+  pvt.lon = -1278000;
+  pvt.height = 12500;
+  pvt.gSpeed = 25000;
+
+  pacer::GPSSample sample = pacer::ToGPSSample(pvt);
+  CHECK(sample.lat == 51.5074);
+  CHECK(sample.lon == -0.1278);
+  CHECK(sample.altitude == 12.5);
+  CHECK(sample.ground_speed == 25.0);
+  CHECK(sample.timestamp_ms == 123456);
+}